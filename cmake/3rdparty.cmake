@@ -1,6 +1,7 @@
 find_package(OpenGL REQUIRED)
 find_package(FLTK REQUIRED)
 find_package(Armadillo REQUIRED)
+find_package(Threads REQUIRED)
 
 include(cmake/hmm.cmake)
 include(cmake/stb.cmake)
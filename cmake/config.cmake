@@ -55,6 +55,12 @@ macro(make_executable)
         DESTINATION ${CMAKE_INSTALL_PREFIX})
 endmacro()
 
+macro(make_library)
+    make_project_()
+    add_library(${PROJECT} STATIC ${HEADERS} ${SOURCES})
+    make_project_options_()
+endmacro()
+
 function(add_all_subdirectories)
     file(GLOB CHILDREN RELATIVE ${CMAKE_CURRENT_SOURCE_DIR} ${CMAKE_CURRENT_SOURCE_DIR}/*)
 
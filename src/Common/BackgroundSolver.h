@@ -0,0 +1,99 @@
+#pragma once
+
+/*
+ * Search run on a worker thread, so the steps are not tied to the timers of
+ * the user interface. The worker steps the object and publishes its copies
+ * through a SnapshotSlot, the interface draws the latest copy at its own
+ * rate. T is copied with clone(), which returns std::unique_ptr<T>.
+ */
+template <typename T>
+class BackgroundSolver {
+public:
+    // One step of the search, false when the search is over
+    using Step = std::function<bool(T& object)>;
+
+    BackgroundSolver() = default;
+    ~BackgroundSolver() { stop(); }
+
+    BackgroundSolver(const BackgroundSolver&) = delete;
+    BackgroundSolver& operator=(const BackgroundSolver&) = delete;
+
+    // The object is left to the worker until the solver stops. Steps are
+    // interval seconds apart and every step is published; zero interval runs
+    // the steps at full speed and publishes copies publishInterval apart
+    void start(T& object, Step step, double interval, double publishInterval) {
+        stop();
+
+        slot_.back() = object.clone();
+        slot_.publish();
+
+        stop_ = false;
+        running_ = true;
+        thread_ = std::thread([=, &object]() {
+            run(object, step, interval, publishInterval);
+        });
+    }
+
+    // Interrupts the search and waits for the worker, a worker that finished
+    // the search is joined as well
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        running_ = false;
+    }
+
+    // True until the search is over or stopped
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    // Takes the latest published copy, false if nothing new was published
+    bool update() { return slot_.update(); }
+
+    // Copy taken by the last update, null before the first start. The copy
+    // belongs to the thread calling update until the next update
+    T* snapshot() { return slot_.front().get(); }
+
+private:
+    void run(T& object, const Step& step, double interval, double publishInterval) {
+        using Clock = std::chrono::steady_clock;
+        const auto pause = std::chrono::duration<double>(interval);
+        const auto publishPause = std::chrono::duration<double>(publishInterval);
+
+        auto published = Clock::now();
+        bool more = true;
+        while (more && !stop_.load(std::memory_order_relaxed)) {
+            more = step(object);
+
+            auto now = Clock::now();
+            if (!more || interval > 0.0 || now - published >= publishPause) {
+                slot_.back() = object.clone();
+                slot_.publish();
+                published = now;
+            }
+
+            if (more && interval > 0.0) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait_for(lock, pause, [this]() { return stop_.load(); });
+            }
+        }
+
+        running_.store(false, std::memory_order_release);
+    }
+
+private:
+    SnapshotSlot<std::unique_ptr<T>> slot_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+
+    // Set by stop(), the mutex only guards the pauses between steps
+    std::atomic<bool> stop_{ false };
+    std::mutex mutex_;
+    std::condition_variable wake_;
+};
@@ -0,0 +1,241 @@
+#ifndef STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#endif
+#include <stb_image_write.h>
+
+#include "pch.h"
+#include "Canvas.h"
+
+namespace CanvasParams {
+    constexpr int GlyphWidth = 3;
+    constexpr int GlyphHeight = 5;
+    constexpr int GlyphSpacing = 1;
+
+    // Rows of glyphs from the top as octal digits, characters 0x20-0x5f
+    constexpr uint16_t Glyphs[] = {
+        000000, 022202, 055000, 057575, 036236, 051245, 025253, 022000,  //  !"#$%&'
+        012221, 042224, 005250, 002720, 000024, 000700, 000002, 011244,  // ()*+,-./
+        075557, 026227, 071747, 071317, 055711, 074717, 074757, 071122,  // 01234567
+        075757, 075717, 002020, 002024, 012421, 007070, 042124, 071302,  // 89:;<=>?
+        075747, 025755, 065656, 034443, 065556, 074647, 074644, 034553,  // @ABCDEFG
+        055755, 072227, 011152, 055655, 044447, 057755, 065555, 025552,  // HIJKLMNO
+        065644, 025563, 065655, 034216, 072222, 055557, 055552, 055775,  // PQRSTUVW
+        055255, 055222, 071247, 032223, 044211, 062226, 025000, 000007,  // XYZ[\]^_
+    };
+    constexpr int FirstGlyph = 0x20;
+    constexpr int GlyphCount = sizeof(Glyphs) / sizeof(Glyphs[0]);
+}
+
+Canvas::Canvas(int width, int height) {
+    resize(width, height);
+}
+
+void Canvas::resize(int width, int height) {
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    pixels_.assign(static_cast<size_t>(width_) * height_ * 4, 0);
+}
+
+void Canvas::clear(CanvasColor c) {
+    for (size_t i = 0; i < pixels_.size(); i += 4) {
+        pixels_[i] = c.r;
+        pixels_[i + 1] = c.g;
+        pixels_[i + 2] = c.b;
+        pixels_[i + 3] = c.a;
+    }
+}
+
+void Canvas::set_color(CanvasColor c) {
+    color_ = c;
+}
+
+void Canvas::set_line_width(int width) {
+    lineWidth_ = std::max(width, 1);
+}
+
+void Canvas::set_text_size(int size) {
+    textScale_ = std::max(size / (CanvasParams::GlyphHeight + 1), 1);
+}
+
+void Canvas::blend(int x, int y) {
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+        return;
+    }
+
+    unsigned char* p = &pixels_[(static_cast<size_t>(y) * width_ + x) * 4];
+    if (color_.a == 255) {
+        p[0] = color_.r;
+        p[1] = color_.g;
+        p[2] = color_.b;
+        p[3] = 255;
+        return;
+    }
+
+    int a = color_.a;
+    p[0] = static_cast<unsigned char>((color_.r * a + p[0] * (255 - a)) / 255);
+    p[1] = static_cast<unsigned char>((color_.g * a + p[1] * (255 - a)) / 255);
+    p[2] = static_cast<unsigned char>((color_.b * a + p[2] * (255 - a)) / 255);
+    p[3] = static_cast<unsigned char>(a + p[3] * (255 - a) / 255);
+}
+
+void Canvas::fill_span(int x1, int x2, int y) {
+    if (y < 0 || y >= height_) {
+        return;
+    }
+    x1 = std::max(x1, 0);
+    x2 = std::min(x2, width_ - 1);
+    for (int x = x1; x <= x2; x++) {
+        blend(x, y);
+    }
+}
+
+void Canvas::draw_line(float x1, float y1, float x2, float y2) {
+    // Clip with the canvas extended by the line width (Liang-Barsky)
+    const float margin = static_cast<float>(lineWidth_);
+    const float d[2] = { x2 - x1, y2 - y1 };
+    const float lo[2] = { -margin - x1, -margin - y1 };
+    const float hi[2] = { width_ + margin - x1, height_ + margin - y1 };
+    float t0 = 0, t1 = 1;
+    for (int k = 0; k < 2; k++) {
+        if (d[k] == 0) {
+            if (lo[k] > 0 || hi[k] < 0) {
+                return;
+            }
+            continue;
+        }
+        float ta = lo[k] / d[k];
+        float tb = hi[k] / d[k];
+        t0 = std::max(t0, std::min(ta, tb));
+        t1 = std::min(t1, std::max(ta, tb));
+    }
+    if (t0 > t1) {
+        return;
+    }
+
+    float ax = x1 + t0 * d[0], ay = y1 + t0 * d[1];
+    float bx = x1 + t1 * d[0], by = y1 + t1 * d[1];
+
+    // Square pen of the line width stepped by one pixel along the major axis
+    int half = (lineWidth_ - 1) / 2;
+    auto pen = [this, half](int x, int y) {
+        for (int j = 0; j < lineWidth_; j++) {
+            fill_span(x - half, x - half + lineWidth_ - 1, y - half + j);
+        }
+    };
+
+    bool steep = std::fabs(by - ay) > std::fabs(bx - ax);
+    if (steep) {
+        std::swap(ax, ay);
+        std::swap(bx, by);
+    }
+    if (ax > bx) {
+        std::swap(ax, bx);
+        std::swap(ay, by);
+    }
+
+    int first = static_cast<int>(std::floor(ax));
+    int last = static_cast<int>(std::floor(bx));
+    for (int u = first; u <= last; u++) {
+        float t = (bx > ax) ? std::clamp((u + 0.5f - ax) / (bx - ax), 0.0f, 1.0f) : 0.0f;
+        int v = static_cast<int>(std::floor(ay + t * (by - ay)));
+        if (steep) {
+            pen(v, u);
+        }
+        else {
+            pen(u, v);
+        }
+    }
+}
+
+void Canvas::fill_triangle(float x1, float y1, float x2, float y2, float x3, float y3) {
+    int xmin = std::max(static_cast<int>(std::floor(std::min({ x1, x2, x3 }))), 0);
+    int xmax = std::min(static_cast<int>(std::ceil(std::max({ x1, x2, x3 }))), width_ - 1);
+    int ymin = std::max(static_cast<int>(std::floor(std::min({ y1, y2, y3 }))), 0);
+    int ymax = std::min(static_cast<int>(std::ceil(std::max({ y1, y2, y3 }))), height_ - 1);
+
+    float area = (x2 - x1) * (y3 - y1) - (y2 - y1) * (x3 - x1);
+    if (area == 0) {
+        return;
+    }
+    float sign = (area > 0) ? 1.0f : -1.0f;
+
+    // Pixel centers on the same side of all edges are inside
+    auto edge = [sign](float ax, float ay, float bx, float by, float px, float py) {
+        return sign * ((bx - ax) * (py - ay) - (by - ay) * (px - ax));
+    };
+    for (int y = ymin; y <= ymax; y++) {
+        float py = y + 0.5f;
+        for (int x = xmin; x <= xmax; x++) {
+            float px = x + 0.5f;
+            if (edge(x1, y1, x2, y2, px, py) >= 0 &&
+                edge(x2, y2, x3, y3, px, py) >= 0 &&
+                edge(x3, y3, x1, y1, px, py) >= 0) {
+                blend(x, y);
+            }
+        }
+    }
+}
+
+void Canvas::fill_rectangle(float x1, float y1, float x2, float y2) {
+    int xa = static_cast<int>(std::floor(std::min(x1, x2)));
+    int xb = static_cast<int>(std::ceil(std::max(x1, x2))) - 1;
+    int ya = std::max(static_cast<int>(std::floor(std::min(y1, y2))), 0);
+    int yb = std::min(static_cast<int>(std::ceil(std::max(y1, y2))) - 1, height_ - 1);
+    for (int y = ya; y <= yb; y++) {
+        fill_span(xa, xb, y);
+    }
+}
+
+void Canvas::draw_text(float x, float y, const char* fmt, ...) {
+    using namespace CanvasParams;
+
+    const size_t BufferLen = 256;
+    char text[BufferLen] = { 0 };
+    va_list ap;
+
+    if (!fmt) {
+        return;
+    }
+
+    va_start(ap, fmt);
+    vsnprintf(text, BufferLen - 1, fmt, ap);
+    va_end(ap);
+
+    int left = static_cast<int>(std::floor(x));
+    int top = static_cast<int>(std::floor(y)) - GlyphHeight * textScale_;
+    for (const char* p = text; *p != '\0'; p++) {
+        int c = toupper(static_cast<unsigned char>(*p)) - FirstGlyph;
+        uint16_t glyph = (c >= 0 && c < GlyphCount) ? Glyphs[c] : Glyphs['?' - FirstGlyph];
+
+        for (int row = 0; row < GlyphHeight; row++) {
+            int bits = (glyph >> ((GlyphHeight - 1 - row) * 3)) & 7;
+            for (int col = 0; col < GlyphWidth; col++) {
+                if (!(bits & (4 >> col))) {
+                    continue;
+                }
+                int px = left + col * textScale_;
+                int py = top + row * textScale_;
+                for (int k = 0; k < textScale_; k++) {
+                    fill_span(px, px + textScale_ - 1, py + k);
+                }
+            }
+        }
+        left += (GlyphWidth + GlyphSpacing) * textScale_;
+    }
+}
+
+int Canvas::text_width(const char* text) const {
+    using namespace CanvasParams;
+    int n = static_cast<int>(strlen(text));
+    return (n > 0) ? (n * (GlyphWidth + GlyphSpacing) - GlyphSpacing) * textScale_ : 0;
+}
+
+int Canvas::text_height() const {
+    return CanvasParams::GlyphHeight * textScale_;
+}
+
+bool Canvas::write_png(const std::string& fileName) const {
+    constexpr int Channels = 4;
+    return stbi_write_png(fileName.c_str(), width_, height_, Channels,
+        pixels_.data(), width_ * Channels) != 0;
+}
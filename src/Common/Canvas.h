@@ -0,0 +1,50 @@
+#pragma once
+
+struct CanvasColor {
+    unsigned char r, g, b, a;
+};
+
+/*
+ * RGBA image rasterised on the CPU, so plots are drawn without a display
+ * or an OpenGL context. Coordinates are in pixels from the top left corner.
+ */
+class Canvas {
+public:
+    Canvas(int width, int height);
+
+    void resize(int width, int height);
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Rows of RGBA pixels from the top
+    const unsigned char* pixels() const { return pixels_.data(); }
+
+    void clear(CanvasColor c);
+
+    void set_color(CanvasColor c);
+    void set_line_width(int width);
+
+    void draw_line(float x1, float y1, float x2, float y2);
+    void fill_triangle(float x1, float y1, float x2, float y2, float x3, float y3);
+    void fill_rectangle(float x1, float y1, float x2, float y2);
+
+    // Built-in 3x5 font scaled to the text size, (x, y) is the left end of the baseline.
+    // Lowercase letters are drawn as capitals.
+    void draw_text(float x, float y, const char* fmt, ...);
+    void set_text_size(int size);
+    int text_width(const char* text) const;
+    int text_height() const;
+
+    bool write_png(const std::string& fileName) const;
+
+private:
+    void blend(int x, int y);
+    void fill_span(int x1, int x2, int y);
+
+private:
+    int width_{ 0 }, height_{ 0 };
+    int lineWidth_{ 1 };
+    int textScale_{ 2 };
+    CanvasColor color_{ 255, 255, 255, 255 };
+    std::vector<unsigned char> pixels_;
+};
@@ -0,0 +1,48 @@
+#include "pch.h"
+#include "Canvas.h"
+#include "ImageWriter.h"
+#include "Headless.h"
+
+int RenderFrames(const std::string& directory, int width, int height, const RenderFunc& render) {
+    using Clock = std::chrono::steady_clock;
+
+    if (width <= 0 || height <= 0) {
+        fprintf(stderr, "Incorrect image size %dx%d\n", width, height);
+        return 1;
+    }
+
+    constexpr size_t BufferLen = 32;
+    char name[BufferLen] = { 0 };
+
+    Canvas canvas(width, height);
+    ImageWriter writer;
+
+    auto start = Clock::now();
+    double renderTime = 0.0;
+    int frames = 0;
+    for (;;) {
+        auto frameStart = Clock::now();
+        if (!render(frames, canvas)) {
+            break;
+        }
+        renderTime += std::chrono::duration<double>(Clock::now() - frameStart).count();
+
+        snprintf(name, BufferLen - 1, "frame%04d.png", frames);
+        writer.write(canvas, directory + "/" + name);
+        frames++;
+    }
+    writer.wait();
+    double totalTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printf("%d frames %dx%d, %zu encoder threads\n", frames, width, height, writer.threads());
+    printf("Rendering: %.3f s, %.1f frames/s\n", renderTime,
+        (renderTime > 0.0) ? frames / renderTime : 0.0);
+    printf("Rendering and encoding: %.3f s, %.1f frames/s\n", totalTime,
+        (totalTime > 0.0) ? frames / totalTime : 0.0);
+
+    if (writer.failed() > 0) {
+        fprintf(stderr, "%zu of %d frames are not written\n", writer.failed(), frames);
+        return 1;
+    }
+    return 0;
+}
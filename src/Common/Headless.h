@@ -0,0 +1,11 @@
+#pragma once
+
+// Draws a frame into the canvas, returns false when there are no frames left
+using RenderFunc = std::function<bool(int frame, Canvas& canvas)>;
+
+/*
+ * Renders frames without a display and writes them as <directory>/frameNNNN.png
+ * on a pool of encoder threads. Prints rendering and overall rates in frames
+ * per second. Returns zero when every frame is written.
+ */
+int RenderFrames(const std::string& directory, int width, int height, const RenderFunc& render);
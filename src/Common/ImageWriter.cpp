@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "Canvas.h"
+#include "ThreadPool.h"
+#include "ImageWriter.h"
+
+namespace ImageWriterParams {
+    // Pending images per thread, bounds the memory taken by pending frames
+    constexpr size_t PendingPerThread = 2;
+}
+
+ImageWriter::ImageWriter() : pool_(ThreadPool::shared()) {
+    pendingLimit_ = pool_.threads() * ImageWriterParams::PendingPerThread;
+}
+
+ImageWriter::~ImageWriter() {
+    wait();
+}
+
+void ImageWriter::write(const Canvas& canvas, const std::string& fileName) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ < pendingLimit_; });
+        pending_++;
+    }
+
+    pool_.submit([this, canvas, fileName]() {
+        bool ok = canvas.write_png(fileName);
+        if (!ok) {
+            fprintf(stderr, "Unable to write %s\n", fileName.c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_--;
+        (ok ? written_ : failed_)++;
+        done_.notify_all();
+    });
+}
+
+void ImageWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+size_t ImageWriter::threads() const {
+    return pool_.threads();
+}
+
+size_t ImageWriter::written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+size_t ImageWriter::failed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+class ThreadPool;
+
+/*
+ * Encodes canvases to PNG files on the shared thread pool, so the next frame
+ * is rendered while the previous ones are compressed. Images are copied into
+ * the tasks, write() blocks while too many of them are pending.
+ */
+class ImageWriter {
+public:
+    ImageWriter();
+    ~ImageWriter();
+
+    ImageWriter(const ImageWriter&) = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+
+    void write(const Canvas& canvas, const std::string& fileName);
+
+    // Blocks until every pending image is written
+    void wait();
+
+    size_t threads() const;
+    size_t written() const;
+    size_t failed() const;
+
+private:
+    ThreadPool& pool_;
+    size_t pendingLimit_{ 0 };
+    size_t pending_{ 0 };
+    size_t written_{ 0 }, failed_{ 0 };
+
+    mutable std::mutex mutex_;
+    std::condition_variable done_;
+};
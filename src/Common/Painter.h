@@ -0,0 +1,444 @@
+#pragma once
+
+// Drawing shared by the FLTK viewers. Common is built without FLTK, so the
+// viewers include this header after their pch and Canvas.h
+
+#define DRAW_METHOD_OPENGL 1
+#define DRAW_METHOD_FLTK 2
+#ifndef DRAW_METHOD
+#define DRAW_METHOD DRAW_METHOD_FLTK
+#endif
+
+// Maps plot coordinates to pixels of the target, identity under OpenGL
+using CoordinateFunc = std::function<double(double)>;
+
+// Pixel sizes are in plot units, the plot starts at the offset in pixels
+inline CoordinateFunc PlotToPixelX(double xmin, double pixelX, double offset) {
+    return [=](double x) { return (x - xmin) / pixelX + offset; };
+}
+
+// Pixel rows go down from the top of the plot
+inline CoordinateFunc PlotToPixelY(double ymax, double pixelY, double offset) {
+    return [=](double y) { return (ymax - y) / pixelY + offset; };
+}
+
+// Side of the anchor point the text is placed on, Right and Top by default
+namespace TextAlign {
+    const uint8_t Top = 0x01;
+    const uint8_t Middle = 0x02;
+    const uint8_t Bottom = 0x04;
+
+    const uint8_t Left = 0x10;
+    const uint8_t Center = 0x20;
+    const uint8_t Right = 0x40;
+}
+
+inline CanvasColor ToCanvasColor(Fl_Color c) {
+    CanvasColor color{ 0, 0, 0, 255 };
+    Fl::get_color(c, color.r, color.g, color.b);
+    return color;
+}
+
+// Vertex of interleaved arrays in GL_C4UB_V2F layout
+struct ColorVertex {
+    unsigned char r, g, b, a;
+    float x, y;
+};
+
+enum class PrimitiveType {
+    Lines,
+    Triangles,
+    Quads
+};
+
+/*
+ * Target of a plot: the widget on the screen or an image on the canvas, so
+ * both are drawn by the same code. Coordinates are in plot units, arrays
+ * hold pairs of x and y.
+ */
+class Painter {
+public:
+    Painter(CoordinateFunc xFunc, CoordinateFunc yFunc)
+        : xFunc_(std::move(xFunc)), yFunc_(std::move(yFunc)) {
+    }
+    virtual ~Painter() = default;
+
+    virtual void set_color(Fl_Color c) = 0;
+    virtual void set_line_width(int width) = 0;
+    virtual void set_text_size(int size) = 0;
+
+    virtual void line(double x1, double y1, double x2, double y2) = 0;
+    virtual void rectangle(double x1, double y1, double x2, double y2) = 0;
+
+    // Square of the size in pixels around the point
+    virtual void point(double x, double y, int size) = 0;
+
+    virtual void lines(const float* xy, size_t count) = 0;
+    virtual void polyline(const float* xy, size_t count, bool closed) = 0;
+    virtual void triangles(const float* xy, size_t count) = 0;
+    virtual void triangle_strip(const float* xy, size_t count) = 0;
+
+    // Primitives with the colors of their first vertices
+    virtual void draw(PrimitiveType type, const ColorVertex* vertices, size_t count) = 0;
+
+    void text(double x, double y, uint8_t align, const char* fmt, ...) {
+        constexpr size_t BufferLen = 256;
+        char str[BufferLen] = { 0 };
+
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(str, BufferLen, fmt, args);
+        va_end(args);
+
+        draw_text(x, y, align, str);
+    }
+
+protected:
+    virtual void draw_text(double x, double y, uint8_t align, const char* str) = 0;
+
+    // Offset of the text of the size in pixels, y goes down
+    static void align_text(uint8_t align, double w, double h, double& dx, double& dy) {
+        dx = (align & TextAlign::Left) ? -w : (align & TextAlign::Center) ? -w / 2.0 : 0.0;
+        dy = (align & TextAlign::Bottom) ? h : (align & TextAlign::Middle) ? h / 2.0 : 0.0;
+    }
+
+protected:
+    CoordinateFunc xFunc_, yFunc_;
+};
+
+// Widget drawn with OpenGL or FLTK, the FLTK coordinate functions map to
+// pixels of the widget or its offscreen buffer
+class ScreenPainter : public Painter {
+public:
+    ScreenPainter(CoordinateFunc xFunc, CoordinateFunc yFunc)
+        : Painter(std::move(xFunc), std::move(yFunc)) {
+    }
+
+    void set_color(Fl_Color c) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        GLubyte r, g, b;
+        Fl::get_color(c, r, g, b);
+        glColor4ub(r, g, b, 255);
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        fl_color(c);
+#endif
+    }
+
+    void set_line_width(int width) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        glLineWidth(static_cast<float>(width));
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        fl_line_style(FL_SOLID, width);
+#endif
+    }
+
+    void set_text_size(int size) override {
+        textSize_ = size;
+    }
+
+    void line(double x1, double y1, double x2, double y2) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        glBegin(GL_LINES);
+        glVertex2d(x1, y1);
+        glVertex2d(x2, y2);
+        glEnd();
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        fl_line(xFunc_(x1), yFunc_(y1), xFunc_(x2), yFunc_(y2));
+#endif
+    }
+
+    void rectangle(double x1, double y1, double x2, double y2) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        glBegin(GL_QUADS);
+        glVertex2d(x1, y1);
+        glVertex2d(x2, y1);
+        glVertex2d(x2, y2);
+        glVertex2d(x1, y2);
+        glEnd();
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        fl_polygon(xFunc_(x1), yFunc_(y1),
+            xFunc_(x2), yFunc_(y1),
+            xFunc_(x2), yFunc_(y2),
+            xFunc_(x1), yFunc_(y2));
+#endif
+    }
+
+    void point(double x, double y, int size) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        glPointSize(static_cast<float>(size));
+        glBegin(GL_POINTS);
+        glVertex2d(x, y);
+        glEnd();
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        fl_rectf(xFunc_(x) - size / 2.0, yFunc_(y) - size / 2.0, size, size);
+#endif
+    }
+
+    void lines(const float* xy, size_t count) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        draw_array(GL_LINES, xy, count);
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        for (size_t i = 0; i + 1 < count; i += 2) {
+            fl_line(xFunc_(xy[i * 2]), yFunc_(xy[i * 2 + 1]),
+                xFunc_(xy[i * 2 + 2]), yFunc_(xy[i * 2 + 3]));
+        }
+#endif
+    }
+
+    void polyline(const float* xy, size_t count, bool closed) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        draw_array(closed ? GL_LINE_LOOP : GL_LINE_STRIP, xy, count);
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        if (closed) {
+            fl_begin_loop();
+        }
+        else {
+            fl_begin_line();
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            fl_vertex(xFunc_(xy[i * 2]), yFunc_(xy[i * 2 + 1]));
+        }
+
+        if (closed) {
+            fl_end_loop();
+        }
+        else {
+            fl_end_line();
+        }
+#endif
+    }
+
+    void triangles(const float* xy, size_t count) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        draw_array(GL_TRIANGLES, xy, count);
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        for (size_t i = 0; i + 2 < count; i += 3) {
+            fill_triangle(xy + i * 2);
+        }
+#endif
+    }
+
+    void triangle_strip(const float* xy, size_t count) override {
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        draw_array(GL_TRIANGLE_STRIP, xy, count);
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        for (size_t i = 0; i + 2 < count; i++) {
+            fill_triangle(xy + i * 2);
+        }
+#endif
+    }
+
+    void draw(PrimitiveType type, const ColorVertex* v, size_t count) override {
+        if (count == 0) {
+            return;
+        }
+
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        GLenum mode = GL_LINES;
+        if (type == PrimitiveType::Triangles) {
+            mode = GL_TRIANGLES;
+        }
+        else if (type == PrimitiveType::Quads) {
+            mode = GL_QUADS;
+        }
+
+        glInterleavedArrays(GL_C4UB_V2F, 0, v);
+        glDrawArrays(mode, 0, static_cast<GLsizei>(count));
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        // Color is switched only between runs of different colors
+        const ColorVertex* last = nullptr;
+        auto set_color = [&last](const ColorVertex& c) {
+            if (!last || last->r != c.r || last->g != c.g || last->b != c.b) {
+                fl_color(fl_rgb_color(c.r, c.g, c.b));
+            }
+            last = &c;
+        };
+
+        auto x = [&](size_t i) { return xFunc_(v[i].x); };
+        auto y = [&](size_t i) { return yFunc_(v[i].y); };
+
+        switch (type) {
+        case PrimitiveType::Lines:
+            for (size_t i = 0; i + 1 < count; i += 2) {
+                set_color(v[i]);
+                fl_line(x(i), y(i), x(i + 1), y(i + 1));
+            }
+            break;
+
+        case PrimitiveType::Triangles:
+            for (size_t i = 0; i + 2 < count; i += 3) {
+                set_color(v[i]);
+                fl_polygon(x(i), y(i), x(i + 1), y(i + 1), x(i + 2), y(i + 2));
+            }
+            break;
+
+        case PrimitiveType::Quads:
+            for (size_t i = 0; i + 3 < count; i += 4) {
+                set_color(v[i]);
+                fl_polygon(x(i), y(i), x(i + 1), y(i + 1),
+                    x(i + 2), y(i + 2), x(i + 3), y(i + 3));
+            }
+            break;
+        }
+#endif
+    }
+
+protected:
+    void draw_text(double x, double y, uint8_t align, const char* str) override {
+        double dx{ 0.0 }, dy{ 0.0 };
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+        // Bitmap fonts of GLUT come in a few sizes only
+        void* font = (textSize_ >= 18) ? GLUT_BITMAP_HELVETICA_18 :
+            (textSize_ >= 12) ? GLUT_BITMAP_HELVETICA_12 : GLUT_BITMAP_HELVETICA_10;
+
+        int w = 0;
+        for (const char* p = str; *p != '\0'; p++) {
+            w += glutBitmapWidth(font, *p);
+        }
+        align_text(align, w, glutBitmapHeight(font), dx, dy);
+
+        // Raster position is moved in pixels, it goes up in OpenGL
+        glRasterPos2d(x, y);
+        glBitmap(0, 0, 0, 0, static_cast<float>(dx), static_cast<float>(-dy), nullptr);
+        glutBitmapString(font, reinterpret_cast<const unsigned char*>(str));
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+        fl_font(FL_HELVETICA, textSize_);
+
+        int w{ 0 }, h{ 0 };
+        fl_measure(str, w, h);
+        align_text(align, w, h, dx, dy);
+
+        fl_draw(str, xFunc_(x) + dx, yFunc_(y) + dy);
+#endif
+    }
+
+private:
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+    static void draw_array(GLenum mode, const float* xy, size_t count) {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, xy);
+        glDrawArrays(mode, 0, static_cast<GLsizei>(count));
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+#elif DRAW_METHOD==DRAW_METHOD_FLTK
+    void fill_triangle(const float* xy) {
+        fl_polygon(xFunc_(xy[0]), yFunc_(xy[1]),
+            xFunc_(xy[2]), yFunc_(xy[3]),
+            xFunc_(xy[4]), yFunc_(xy[5]));
+    }
+#endif
+
+private:
+    int textSize_{ 12 };
+};
+
+// Image rasterised on the CPU, the coordinate functions map to canvas pixels
+class CanvasPainter : public Painter {
+public:
+    CanvasPainter(Canvas& canvas, CoordinateFunc xFunc, CoordinateFunc yFunc)
+        : Painter(std::move(xFunc), std::move(yFunc)), canvas_(canvas) {
+    }
+
+    void set_color(Fl_Color c) override {
+        canvas_.set_color(ToCanvasColor(c));
+    }
+
+    void set_line_width(int width) override {
+        canvas_.set_line_width(width);
+    }
+
+    void set_text_size(int size) override {
+        canvas_.set_text_size(size);
+    }
+
+    void line(double x1, double y1, double x2, double y2) override {
+        canvas_.draw_line(xFunc_(x1), yFunc_(y1), xFunc_(x2), yFunc_(y2));
+    }
+
+    void rectangle(double x1, double y1, double x2, double y2) override {
+        canvas_.fill_rectangle(xFunc_(x1), yFunc_(y1), xFunc_(x2), yFunc_(y2));
+    }
+
+    void point(double x, double y, int size) override {
+        double px = xFunc_(x), py = yFunc_(y);
+        canvas_.fill_rectangle(px - size / 2.0, py - size / 2.0, px + size / 2.0, py + size / 2.0);
+    }
+
+    void lines(const float* xy, size_t count) override {
+        for (size_t i = 0; i + 1 < count; i += 2) {
+            line(xy[i * 2], xy[i * 2 + 1], xy[i * 2 + 2], xy[i * 2 + 3]);
+        }
+    }
+
+    void polyline(const float* xy, size_t count, bool closed) override {
+        size_t segments = closed ? count : count - 1;
+        for (size_t i = 0; count > 1 && i < segments; i++) {
+            size_t j = (i + 1) % count;
+            line(xy[i * 2], xy[i * 2 + 1], xy[j * 2], xy[j * 2 + 1]);
+        }
+    }
+
+    void triangles(const float* xy, size_t count) override {
+        for (size_t i = 0; i + 2 < count; i += 3) {
+            fill_triangle(xy + i * 2);
+        }
+    }
+
+    void triangle_strip(const float* xy, size_t count) override {
+        for (size_t i = 0; i + 2 < count; i++) {
+            fill_triangle(xy + i * 2);
+        }
+    }
+
+    void draw(PrimitiveType type, const ColorVertex* v, size_t count) override {
+        auto set_color = [this](const ColorVertex& c) {
+            canvas_.set_color({ c.r, c.g, c.b, c.a });
+        };
+        auto x = [&](size_t i) { return xFunc_(v[i].x); };
+        auto y = [&](size_t i) { return yFunc_(v[i].y); };
+
+        switch (type) {
+        case PrimitiveType::Lines:
+            for (size_t i = 0; i + 1 < count; i += 2) {
+                set_color(v[i]);
+                canvas_.draw_line(x(i), y(i), x(i + 1), y(i + 1));
+            }
+            break;
+
+        case PrimitiveType::Triangles:
+            for (size_t i = 0; i + 2 < count; i += 3) {
+                set_color(v[i]);
+                canvas_.fill_triangle(x(i), y(i), x(i + 1), y(i + 1), x(i + 2), y(i + 2));
+            }
+            break;
+
+        case PrimitiveType::Quads:
+            for (size_t i = 0; i + 3 < count; i += 4) {
+                set_color(v[i]);
+                canvas_.fill_triangle(x(i), y(i), x(i + 1), y(i + 1), x(i + 2), y(i + 2));
+                canvas_.fill_triangle(x(i), y(i), x(i + 2), y(i + 2), x(i + 3), y(i + 3));
+            }
+            break;
+        }
+    }
+
+protected:
+    void draw_text(double x, double y, uint8_t align, const char* str) override {
+        double dx{ 0.0 }, dy{ 0.0 };
+        align_text(align, canvas_.text_width(str), canvas_.text_height(), dx, dy);
+        canvas_.draw_text(xFunc_(x) + dx, yFunc_(y) + dy, "%s", str);
+    }
+
+private:
+    void fill_triangle(const float* xy) {
+        canvas_.fill_triangle(xFunc_(xy[0]), yFunc_(xy[1]),
+            xFunc_(xy[2]), yFunc_(xy[3]),
+            xFunc_(xy[4]), yFunc_(xy[5]));
+    }
+
+private:
+    Canvas& canvas_;
+};
@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "SearchStats.h"
+
+SearchStats::SearchStats(const SearchStats& other)
+    : evaluations_(other.evaluations()),
+      steps_(other.steps_),
+      total_(other.total_),
+      max_(other.max_),
+      histogram_(other.histogram_) {
+}
+
+SearchStats& SearchStats::operator=(const SearchStats& other) {
+    evaluations_ = other.evaluations();
+    steps_ = other.steps_;
+    total_ = other.total_;
+    max_ = other.max_;
+    histogram_ = other.histogram_;
+    return *this;
+}
+
+void SearchStats::reset() {
+    evaluations_ = 0;
+    steps_ = 0;
+    total_ = max_ = 0.0;
+    histogram_.fill(0);
+}
+
+void SearchStats::merge(const SearchStats& other) {
+    add_evaluations(other.evaluations());
+    steps_ += other.steps_;
+    total_ += other.total_;
+    max_ = std::max(max_, other.max_);
+    for (size_t i = 0; i < BucketCount; i++) {
+        histogram_[i] += other.histogram_[i];
+    }
+}
+
+void SearchStats::add_step(double seconds) {
+    steps_++;
+    total_ += seconds;
+    max_ = std::max(max_, seconds);
+
+    // Times of [2^(e-1), 2^e) microseconds go to bucket e
+    size_t bucket = 0;
+    double us = seconds * 1e6;
+    if (us >= 1.0) {
+        int e = 0;
+        frexp(us, &e);
+        bucket = std::min(static_cast<size_t>(e), BucketCount - 1);
+    }
+    histogram_[bucket]++;
+}
+
+double SearchStats::percentile(double q) const {
+    if (steps_ == 0) {
+        return 0.0;
+    }
+
+    auto rank = static_cast<size_t>(ceil(q * static_cast<double>(steps_)));
+    rank = std::max<size_t>(rank, 1);
+
+    size_t count = 0;
+    for (size_t i = 0; i < BucketCount; i++) {
+        count += histogram_[i];
+        if (count >= rank) {
+            return std::min(bucket_limit(i), max_);
+        }
+    }
+    return max_;
+}
+
+double SearchStats::bucket_limit(size_t i) {
+    return ldexp(1e-6, static_cast<int>(i));
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+ * Statistics of a search: evaluations of the objective and the times of the
+ * steps. Evaluations are counted atomically, so tasks of one step count them
+ * on any thread. Step times go to a histogram with buckets doubling from one
+ * microsecond, which gives the percentiles of a run of any length in fixed
+ * memory.
+ */
+class SearchStats {
+public:
+    static constexpr size_t BucketCount = 32;
+
+    SearchStats() = default;
+    SearchStats(const SearchStats& other);
+    SearchStats& operator=(const SearchStats& other);
+
+    void reset();
+
+    // Totals of both runs, e.g. of the runs of a benchmark
+    void merge(const SearchStats& other);
+
+    void add_evaluations(size_t n) { evaluations_.fetch_add(n, std::memory_order_relaxed); }
+    size_t evaluations() const { return evaluations_.load(std::memory_order_relaxed); }
+
+    void add_step(double seconds);
+
+    size_t steps() const { return steps_; }
+    double total_time() const { return total_; }
+    double max_time() const { return max_; }
+    double mean_time() const { return (steps_ > 0) ? total_ / static_cast<double>(steps_) : 0.0; }
+
+    // Upper limit of the bucket holding the fraction q of the fastest steps
+    // or the slowest step, in seconds, at most twice the exact percentile
+    double percentile(double q) const;
+
+    // Bucket 0 holds steps under a microsecond, bucket i up to 2^i microseconds
+    const std::array<size_t, BucketCount>& histogram() const { return histogram_; }
+    static double bucket_limit(size_t i);
+
+private:
+    std::atomic<size_t> evaluations_{ 0 };
+
+    size_t steps_{ 0 };
+    double total_{ 0.0 }, max_{ 0.0 };
+    std::array<size_t, BucketCount> histogram_{};
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+ * Slot passing the latest value from one producer thread to one consumer
+ * thread without locks. Three buffers are kept: the producer fills the back
+ * one, the consumer reads the front one and the middle one holds the latest
+ * published value. Publishing and taking swap a buffer with the middle one
+ * atomically, so neither side waits for the other and the consumer skips
+ * values published between its updates.
+ */
+template <typename T>
+class SnapshotSlot {
+public:
+    // Producer: buffer to fill, then publish it
+    T& back() { return buffers_[back_]; }
+    void publish() {
+        back_ = middle_.exchange(back_ | Fresh, std::memory_order_acq_rel) & Index;
+    }
+
+    // Consumer: take the latest published buffer, false if nothing new was
+    // published since the last update
+    bool update() {
+        if (!(middle_.load(std::memory_order_relaxed) & Fresh)) {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & Index;
+        return true;
+    }
+    T& front() { return buffers_[front_]; }
+    const T& front() const { return buffers_[front_]; }
+
+private:
+    static constexpr unsigned Index = 3;
+    static constexpr unsigned Fresh = 4;
+
+    std::array<T, 3> buffers_;
+    unsigned back_{ 0 }, front_{ 1 };
+
+    // Index of the middle buffer and the flag of a value not taken yet
+    std::atomic<unsigned> middle_{ 2 };
+};
@@ -0,0 +1,156 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+// Queue of the worker running on this thread
+thread_local size_t WorkerIndex = std::numeric_limits<size_t>::max();
+thread_local const ThreadPool* WorkerPool = nullptr;
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        threads_.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& t : threads_) {
+        t.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(Task task) {
+    size_t index = on_worker() ?
+        WorkerIndex : next_.fetch_add(1) % queues_.size();
+
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::on_worker() const {
+    return WorkerPool == this;
+}
+
+bool ThreadPool::take(size_t index, Task& task) {
+    {
+        Queue& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t k = 1; k < queues_.size(); k++) {
+        Queue& other = *queues_[(index + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::run_queued() {
+    Task task;
+    if (!take(WorkerIndex, task)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_--;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::run(size_t index) {
+    WorkerIndex = index;
+    WorkerPool = this;
+
+    for (;;) {
+        if (run_queued()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this]() { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool_(pool) {
+}
+
+TaskGroup::~TaskGroup() {
+    wait();
+}
+
+void TaskGroup::submit(ThreadPool::Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_++;
+    }
+
+    pool_.submit([this, task = std::move(task)]() {
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) {
+            done_.notify_all();
+        }
+    });
+}
+
+void TaskGroup::wait() {
+    // A worker blocked here could hold up the tasks of its own batch
+    if (pool_.on_worker()) {
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (pending_ == 0) {
+                    return;
+                }
+            }
+            if (!pool_.run_queued()) {
+                break;
+            }
+        }
+    }
+
+    // The rest of the batch is running on other threads
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_ == 0; });
+}
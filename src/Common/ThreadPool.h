@@ -0,0 +1,77 @@
+#pragma once
+
+/*
+ * Pool of worker threads with a queue of tasks per worker. Tasks are spread
+ * over the queues, a worker takes the newest task of its own queue and an
+ * idle worker steals the oldest task of another queue, so tasks of uneven
+ * length keep every thread busy.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // Zero threads means one thread per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Tasks submitted by a task go to the queue of its worker
+    void submit(Task task);
+
+    size_t threads() const { return threads_.size(); }
+
+    // Pool shared by the whole program
+    static ThreadPool& shared();
+
+private:
+    friend class TaskGroup;
+
+    struct Queue {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    void run(size_t index);
+    bool take(size_t index, Task& task);
+
+    // Runs one queued task on the calling worker, false if none is queued
+    bool run_queued();
+    bool on_worker() const;
+
+private:
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_{ 0 };
+
+    size_t queued_{ 0 };
+    bool stop_{ false };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+};
+
+/*
+ * Batch of tasks on a pool, wait() blocks until the tasks of this batch are
+ * done and does not wait for other tasks of the pool. A worker waiting for
+ * its batch runs queued tasks meanwhile, so tasks can submit batches too.
+ */
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::shared());
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void submit(ThreadPool::Task task);
+    void wait();
+
+private:
+    ThreadPool& pool_;
+    size_t pending_{ 0 };
+
+    std::mutex mutex_;
+    std::condition_variable done_;
+};
@@ -0,0 +1,267 @@
+#include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
+#include "GraphicsUtils.h"
+#include "LinAlgUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
+#include "FEM.h"
+#include "LodGrid.h"
+#include "SpatialIndex.h"
+#include "ModelWidget.h"
+#include "Benchmark.h"
+
+namespace BenchmarkParams {
+    // Lattice sizes in cells
+    const std::vector<std::array<int, 2>> Sizes = {
+        {16, 8},
+        {32, 16},
+        {64, 32},
+        {128, 64},
+        {256, 128}
+    };
+
+    constexpr float TipLoad = -100.0;
+
+    // Lattice and window of the draw benchmark
+    constexpr int DrawLatticeX = 256;
+    constexpr int DrawLatticeY = 128;
+    constexpr int DrawWidth = 800;
+    constexpr int DrawHeight = 600;
+
+    // Lattice of the picking benchmark, 4*512*512 elements
+    constexpr int PickLatticeX = 512;
+    constexpr int PickLatticeY = 512;
+    constexpr float PickRadius = 0.5;
+}
+
+void CreateLattice(FinitModel& model, int nx, int ny) {
+    model.clear();
+    model.title = "Lattice";
+
+    auto node_id = [nx](int i, int j) {
+        return j * (nx + 1) + i + 1;
+    };
+
+    for (int j = 0; j <= ny; j++) {
+        for (int i = 0; i <= nx; i++) {
+            model.nodes.push_back({ node_id(i, j),
+                static_cast<float>(i), static_cast<float>(j) });
+        }
+    }
+    model.component_count = model.nodes.size() * ModelDimensions;
+
+    // Left edge is clamped, the load is applied to the top right corner
+    for (int j = 0; j <= ny; j++) {
+        model.fixes.push_back({ node_id(0, j), 1 });
+        model.fixes.push_back({ node_id(0, j), 2 });
+    }
+    model.loads.push_back({ node_id(nx, ny), 0.0, BenchmarkParams::TipLoad });
+
+    auto add_element = [&model](int n1, int n2) {
+        Element e;
+        e.elem = model.elems.size() + 1;
+        e.nodes[0] = n1;
+        e.nodes[1] = n2;
+        model.update_element(e);
+        model.elems.push_back(e);
+    };
+
+    for (int j = 0; j <= ny; j++) {
+        for (int i = 0; i <= nx; i++) {
+            if (i < nx) {
+                add_element(node_id(i, j), node_id(i + 1, j));
+            }
+            if (j < ny) {
+                add_element(node_id(i, j), node_id(i, j + 1));
+            }
+            if (i < nx && j < ny) {
+                add_element(node_id(i, j), node_id(i + 1, j + 1));
+                add_element(node_id(i + 1, j), node_id(i, j + 1));
+            }
+        }
+    }
+}
+
+int RunBenchmark() {
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    const std::vector<std::tuple<SolverMethod, std::string>> methods = {
+        {SolverMethod::ConjugateGradient, "CG+Jacobi"},
+        {SolverMethod::Multigrid, "CG+AMG"},
+        {SolverMethod::DomainDecomposition, "Subdomains"}
+    };
+
+    printf("%-10s %10s %10s %-10s %8s %10s %10s %12s\n",
+        "Lattice", "DOFs", "Elements", "Method", "Iters", "Setup,ms", "Solve,ms", "Residual");
+
+    for (const auto& size : BenchmarkParams::Sizes) {
+        FinitModel model;
+        CreateLattice(model, size[0], size[1]);
+
+        char lattice[32] = { 0 };
+        snprintf(lattice, sizeof(lattice) - 1, "%dx%d", size[0], size[1]);
+
+        for (const auto& m : methods) {
+            model.method = std::get<0>(m);
+
+            auto t0 = Clock::now();
+            model.prepare_solve();
+            auto t1 = Clock::now();
+            model.solve();
+            auto t2 = Clock::now();
+
+            printf("%-10s %10d %10zu %-10s %8d %10.1f %10.1f %12.4e%s\n",
+                lattice, model.component_count, model.elems.size(),
+                std::get<1>(m).c_str(),
+                model.solver_result.iterations,
+                Milliseconds(t1 - t0).count(), Milliseconds(t2 - t1).count(),
+                model.solver_result.residual,
+                model.solver_result.converged ? "" : " (not converged)");
+        }
+    }
+
+    return 0;
+}
+
+int RunDrawBenchmark(const char* fileName, int frames) {
+    using namespace BenchmarkParams;
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    FinitModel model;
+    if (fileName) {
+        model.load_from_file(fileName);
+    }
+    else {
+        CreateLattice(model, DrawLatticeX, DrawLatticeY);
+    }
+
+    Fl_Window window(DrawWidth, DrawHeight, "FEMSolve draw benchmark");
+    auto widget = new ModelWidget(0, 0, DrawWidth, DrawHeight, model);
+    window.end();
+    window.show();
+
+    auto t0 = Clock::now();
+    widget->reload_model();
+    Fl::flush();
+    auto t1 = Clock::now();
+
+    for (int i = 0; i < frames; i++) {
+        widget->refresh();
+        Fl::flush();
+    }
+    auto t2 = Clock::now();
+
+    printf("Nodes %zu, elements %zu\n", model.nodes.size(), model.elems.size());
+    printf("First frame : %10.2f ms\n", Milliseconds(t1 - t0).count());
+    printf("Frame       : %10.2f ms (%d frames)\n",
+        Milliseconds(t2 - t1).count() / std::max(frames, 1), frames);
+    printf("Draw        : %10.2f ms\n", widget->frame_time());
+
+    return 0;
+}
+
+int RunPickBenchmark(const char* fileName, int queries) {
+    using namespace BenchmarkParams;
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    FinitModel model;
+    if (fileName) {
+        model.load_from_file(fileName);
+    }
+    else {
+        CreateLattice(model, PickLatticeX, PickLatticeY);
+    }
+    if (model.nodes.empty()) {
+        printf("Model is empty\n");
+        return 1;
+    }
+
+    auto t0 = Clock::now();
+    SpatialIndex index;
+    index.build(model);
+    auto t1 = Clock::now();
+
+    BoundingBox extent{ model.nodes[0].x, model.nodes[0].y, model.nodes[0].x, model.nodes[0].y };
+    for (const auto& n : model.nodes) {
+        extent.xmin = std::min(extent.xmin, n.x);
+        extent.ymin = std::min(extent.ymin, n.y);
+        extent.xmax = std::max(extent.xmax, n.x);
+        extent.ymax = std::max(extent.ymax, n.y);
+    }
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> rx(extent.xmin, extent.xmax);
+    std::uniform_real_distribution<float> ry(extent.ymin, extent.ymax);
+    std::vector<std::array<float, 2>> points(std::max(queries, 1));
+    for (auto& p : points) {
+        p = { rx(random), ry(random) };
+    }
+
+    // Returns average time of a query in microseconds
+    size_t found = 0;
+    auto measure = [&](const std::function<size_t(float, float)>& query) {
+        found = 0;
+        auto start = Clock::now();
+        for (const auto& p : points) {
+            found += query(p[0], p[1]);
+        }
+        return Microseconds(Clock::now() - start).count() / points.size();
+    };
+
+    printf("Nodes %zu, elements %zu\n", model.nodes.size(), model.elems.size());
+    printf("Build            : %10.2f ms\n", Milliseconds(t1 - t0).count());
+
+    double t = measure([&](float x, float y) {
+        return index.nearest_node(x, y, PickRadius) >= 0;
+    });
+    printf("Nearest node     : %10.2f us (%zu found)\n", t, found);
+
+    t = measure([&](float x, float y) {
+        return index.nearest_element(x, y, PickRadius) >= 0;
+    });
+    printf("Nearest element  : %10.2f us (%zu found)\n", t, found);
+
+    // Viewport of a tenth of the model size
+    float w = (extent.xmax - extent.xmin) * 0.1f;
+    float h = (extent.ymax - extent.ymin) * 0.1f;
+    std::vector<int> result;
+    t = measure([&](float x, float y) {
+        index.elements_in_rect({ x, y, x + w, y + h }, result);
+        return result.size();
+    });
+    printf("Elements in rect : %10.2f us (%.0f per query)\n", t,
+        static_cast<double>(found) / points.size());
+
+    t = measure([&](float x, float y) {
+        float param{ 0 };
+        return index.ray_hit(x, y, 1.0f, 0.5f, param) >= 0;
+    });
+    printf("Ray hit          : %10.2f us (%zu found)\n", t, found);
+
+    // Linear scan for comparison
+    auto scanned = points;
+    scanned.resize(std::min<size_t>(scanned.size(), 100));
+    std::swap(points, scanned);
+    t = measure([&](float x, float y) {
+        int nearest = -1;
+        float best = PickRadius * PickRadius;
+        for (size_t i = 0; i < model.nodes.size(); i++) {
+            float dx = model.nodes[i].x - x;
+            float dy = model.nodes[i].y - y;
+            if (dx * dx + dy * dy <= best) {
+                best = dx * dx + dy * dy;
+                nearest = static_cast<int>(i);
+            }
+        }
+        return nearest >= 0;
+    });
+    printf("Linear scan      : %10.2f us\n", t);
+
+    return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Generate a cantilever truss of nx*ny square cells with both diagonals
+void CreateLattice(FinitModel& model, int nx, int ny);
+
+// Compare iterative solvers on lattices of growing size, prints a table
+int RunBenchmark();
+
+// Measure redraw time of the model widget, a large lattice is used without a model file.
+// Runs with any OpenGL implementation including Mesa software rendering.
+int RunDrawBenchmark(const char* fileName, int frames);
+
+// Measure build and query times of the spatial index on a model or on a lattice
+// with about a million elements without a model file
+int RunPickBenchmark(const char* fileName, int queries);
@@ -0,0 +1,529 @@
+#include "pch.h"
+#include "LinAlgUtils.h"
+#include "ParallelUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "GraphPartition.h"
+#include "DomainDecomposition.h"
+#include "FEM.h"
+
+namespace DecompositionParams {
+    // Preferred number of DOFs in a subdomain. Work of a subdomain grows
+    // as square of its size while the interface system grows with their count.
+    constexpr int SubdomainSize = 4096;
+}
+
+namespace {
+
+    // Element belongs to this part, the node to several parts
+    constexpr int SharedNode = -2;
+
+#if !defined(WIN32)
+#if defined(MSG_NOSIGNAL)
+    // Failed worker must not terminate the application with SIGPIPE
+    constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int SendFlags = 0;
+#endif
+
+    bool WriteAll(int fd, const void* data, size_t size) {
+        auto p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = send(fd, p, size, SendFlags);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            p += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    bool ReadAll(int fd, void* data, size_t size) {
+        auto p = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t received = read(fd, p, size);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                return false;
+            }
+            p += received;
+            size -= received;
+        }
+        return true;
+    }
+#endif
+
+}
+
+void DomainDecomposition::setup(const FinitModel& model, int parts, int workers) {
+    clear();
+
+    // Processes beyond the threads would only compete for the cores
+    workers_ = (workers > 0) ? static_cast<size_t>(workers) : ThreadCount();
+
+    const size_t node_count = model.nodes.size();
+
+    std::vector<bool> fixed(model.component_count, false);
+    for (const auto& f : model.fixes) {
+        fixed[(f.node - 1) * 2 + 1 - (f.axis % 2)] = true;
+    }
+
+    // Node graph of the truss
+    Graph graph;
+    {
+        std::vector<std::vector<int>> adjacent(node_count);
+        for (const auto& e : model.elems) {
+            int n1 = e.nodes[0] - 1;
+            int n2 = e.nodes[1] - 1;
+            adjacent[n1].push_back(n2);
+            adjacent[n2].push_back(n1);
+        }
+        graph.offsets.push_back(0);
+        for (auto& a : adjacent) {
+            std::sort(a.begin(), a.end());
+            a.erase(std::unique(a.begin(), a.end()), a.end());
+            graph.adjacent.insert(graph.adjacent.end(), a.begin(), a.end());
+            graph.offsets.push_back(graph.adjacent.size());
+        }
+        graph.edge_weights.assign(graph.adjacent.size(), 1);
+        graph.vertex_weights.assign(node_count, 1);
+    }
+
+    if (parts <= 0) {
+        parts = std::max(static_cast<int>(ThreadCount()),
+            model.component_count / DecompositionParams::SubdomainSize);
+    }
+    parts = std::max(1, std::min(parts, static_cast<int>(node_count)));
+    auto node_part = PartitionGraph(graph, parts);
+
+    // Element goes to the lower of the parts of its nodes.
+    // Nodes touched by elements of different parts form the interface.
+    std::vector<int> elem_part(model.elems.size());
+    std::vector<int> node_owner(node_count, -1);
+    for (size_t k = 0; k < model.elems.size(); k++) {
+        const auto& e = model.elems[k];
+        int n1 = e.nodes[0] - 1;
+        int n2 = e.nodes[1] - 1;
+        int p = std::min(node_part[n1], node_part[n2]);
+        elem_part[k] = p;
+        for (int node : { n1, n2 }) {
+            if (node_owner[node] == -1) {
+                node_owner[node] = p;
+            }
+            else if (node_owner[node] != p) {
+                node_owner[node] = SharedNode;
+            }
+        }
+    }
+
+    std::vector<int> interface_index(model.component_count, -1);
+    for (size_t node = 0; node < node_count; node++) {
+        if (node_owner[node] != SharedNode) {
+            continue;
+        }
+        for (int d = 0; d < ModelDimensions; d++) {
+            int dof = static_cast<int>(node) * ModelDimensions + d;
+            if (!fixed[dof]) {
+                interface_index[dof] = static_cast<int>(interface_.size());
+                interface_.push_back(dof);
+            }
+        }
+    }
+
+    // Interior DOFs of every part
+    subdomains_.resize(parts);
+    for (size_t node = 0; node < node_count; node++) {
+        if (node_owner[node] < 0) {
+            continue;
+        }
+        for (int d = 0; d < ModelDimensions; d++) {
+            int dof = static_cast<int>(node) * ModelDimensions + d;
+            if (!fixed[dof]) {
+                subdomains_[node_owner[node]].interior.push_back(dof);
+            }
+        }
+    }
+
+    // Elements of every part and interface DOFs they touch. Local matrices
+    // are assembled by the workers from these lists.
+    for (size_t k = 0; k < model.elems.size(); k++) {
+        subdomains_[elem_part[k]].elems.push_back(k);
+    }
+
+    std::vector<int> interface_part(model.component_count, -1);
+    for (int p = 0; p < parts; p++) {
+        auto& s = subdomains_[p];
+        for (size_t k : s.elems) {
+            const auto& e = model.elems[k];
+            for (int node : { e.nodes[0] - 1, e.nodes[1] - 1 }) {
+                for (int d = 0; d < ModelDimensions; d++) {
+                    int dof = node * ModelDimensions + d;
+                    if (interface_index[dof] >= 0 && interface_part[dof] != p) {
+                        interface_part[dof] = p;
+                        s.interface.push_back(interface_index[dof]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Interface DOFs of a part are coupled with each other
+    std::vector<std::vector<int>> coupled(interface_.size());
+    for (const auto& s : subdomains_) {
+        for (int i : s.interface) {
+            coupled[i].insert(coupled[i].end(), s.interface.begin(), s.interface.end());
+        }
+    }
+    interface_rows_.assign(1, 0);
+    for (auto& c : coupled) {
+        std::sort(c.begin(), c.end());
+        c.erase(std::unique(c.begin(), c.end()), c.end());
+        interface_cols_.insert(interface_cols_.end(), c.begin(), c.end());
+        interface_rows_.push_back(interface_cols_.size());
+        std::vector<int>().swap(c);
+    }
+}
+
+void DomainDecomposition::clear() {
+    subdomains_.clear();
+    interface_.clear();
+    interface_rows_.clear();
+    interface_cols_.clear();
+}
+
+size_t DomainDecomposition::max_interior_size() const {
+    size_t size = 0;
+    for (const auto& s : subdomains_) {
+        size = std::max(size, s.interior.size());
+    }
+    return size;
+}
+
+SparseMatrix DomainDecomposition::assemble(const FinitModel& model, const Subdomain& s) const {
+    // Local numbering: interior DOFs first, then interface DOFs of the part
+    std::unordered_map<int, int> local;
+    for (size_t i = 0; i < s.interior.size(); i++) {
+        local[s.interior[i]] = static_cast<int>(i);
+    }
+    for (size_t i = 0; i < s.interface.size(); i++) {
+        local[interface_[s.interface[i]]] = static_cast<int>(s.interior.size() + i);
+    }
+
+    std::vector<SparseMatrix::Triplet> triplets;
+    for (size_t k : s.elems) {
+        const auto& e = model.elems[k];
+
+        std::array<int, 4> dofs = {
+            (e.nodes[0] - 1) * 2, (e.nodes[0] - 1) * 2 + 1,
+            (e.nodes[1] - 1) * 2, (e.nodes[1] - 1) * 2 + 1
+        };
+
+        // Fixed DOFs have no local index
+        std::array<int, 4> idx;
+        for (int j = 0; j < 4; j++) {
+            auto it = local.find(dofs[j]);
+            idx[j] = (it != local.end()) ? it->second : -1;
+        }
+
+        float k_xx = e.cosa * e.cosa / e.length;
+        float k_xy = e.cosa * e.sina / e.length;
+        float k_yy = e.sina * e.sina / e.length;
+        const float K[2][2] = { { k_xx, k_xy }, { k_xy, k_yy } };
+
+        for (int j = 0; j < 4; j++) {
+            for (int m = 0; m < 4; m++) {
+                if (idx[j] < 0 || idx[m] < 0) {
+                    continue;
+                }
+                float v = K[j % 2][m % 2];
+                triplets.push_back({ idx[j], idx[m], (j / 2 == m / 2) ? v : -v });
+            }
+        }
+    }
+
+    size_t size = s.interior.size() + s.interface.size();
+    return SparseMatrix::from_triplets(size, size, triplets);
+}
+
+bool DomainDecomposition::SubdomainSolver::condense(const Subdomain& s, const SparseMatrix& a,
+        const Vector& b, std::vector<double>& schur, std::vector<double>& rhs) {
+    const size_t ni = s.interior.size();
+    const size_t ng = s.interface.size();
+
+    // Split local matrix into interior and coupling blocks
+    std::vector<SparseMatrix::Triplet> ii, ig;
+    schur.assign(ng * ng, 0.0);
+    for (size_t i = 0; i < a.rows; i++) {
+        for (size_t k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++) {
+            size_t j = a.col_idx[k];
+            float v = a.values[k];
+            if (i < ni && j < ni) {
+                ii.push_back({ static_cast<int>(i), static_cast<int>(j), v });
+            }
+            else if (i < ni) {
+                ig.push_back({ static_cast<int>(i), static_cast<int>(j - ni), v });
+            }
+            else if (j >= ni) {
+                schur[(i - ni) * ng + (j - ni)] = v;
+            }
+        }
+    }
+    aii_ = SparseMatrix::from_triplets(ni, ni, ii);
+    aig_ = SparseMatrix::from_triplets(ni, ng, ig);
+
+    if (!factor_.factor(aii_)) {
+        return false;
+    }
+
+    bi_.resize(ni);
+    for (size_t i = 0; i < ni; i++) {
+        bi_[i] = b[s.interior[i]];
+    }
+
+    // S = Agg - Agi * Aii^-1 * Aig, column by column
+    SparseMatrix agi = aig_.transpose();
+    std::vector<double> x(ni);
+    for (size_t c = 0; c < ng; c++) {
+        std::fill(x.begin(), x.end(), 0.0);
+        for (size_t k = agi.row_ptr[c]; k < agi.row_ptr[c + 1]; k++) {
+            x[agi.col_idx[k]] = agi.values[k];
+        }
+        factor_.solve(x);
+        for (size_t r = 0; r < ng; r++) {
+            double sum = 0.0;
+            for (size_t k = agi.row_ptr[r]; k < agi.row_ptr[r + 1]; k++) {
+                sum += agi.values[k] * x[agi.col_idx[k]];
+            }
+            schur[r * ng + c] -= sum;
+        }
+    }
+
+    // g = -Agi * Aii^-1 * bi
+    x = bi_;
+    factor_.solve(x);
+    rhs.assign(ng, 0.0);
+    for (size_t r = 0; r < ng; r++) {
+        for (size_t k = agi.row_ptr[r]; k < agi.row_ptr[r + 1]; k++) {
+            rhs[r] -= agi.values[k] * x[agi.col_idx[k]];
+        }
+    }
+
+    return true;
+}
+
+void DomainDecomposition::SubdomainSolver::recover(
+        const std::vector<double>& u_interface, std::vector<double>& u_interior) const {
+    // Aii * ui = bi - Aig * ug
+    u_interior = bi_;
+    for (size_t i = 0; i < aig_.rows; i++) {
+        for (size_t k = aig_.row_ptr[i]; k < aig_.row_ptr[i + 1]; k++) {
+            u_interior[i] -= aig_.values[k] * u_interface[aig_.col_idx[k]];
+        }
+    }
+    factor_.solve(u_interior);
+}
+
+void DomainDecomposition::run_worker(const FinitModel& model, size_t first, size_t stride,
+        const Vector& b, int fd) const {
+#if !defined(WIN32)
+    // Factors of all subdomains of the worker are kept for the back substitution
+    std::vector<SubdomainSolver> solvers;
+    std::vector<double> schur, rhs;
+
+    for (size_t p = first; p < subdomains_.size(); p += stride) {
+        const auto& s = subdomains_[p];
+        solvers.emplace_back();
+
+        char status = solvers.back().condense(s, assemble(model, s), b, schur, rhs) ? 1 : 0;
+        if (!WriteAll(fd, &status, sizeof(status)) || !status) {
+            return;
+        }
+        if (!WriteAll(fd, schur.data(), schur.size() * sizeof(double)) ||
+            !WriteAll(fd, rhs.data(), rhs.size() * sizeof(double))) {
+            return;
+        }
+    }
+
+    std::vector<double> u_interface, u_interior;
+    for (size_t p = first, k = 0; p < subdomains_.size(); p += stride, k++) {
+        u_interface.resize(subdomains_[p].interface.size());
+        if (!ReadAll(fd, u_interface.data(), u_interface.size() * sizeof(double))) {
+            return;
+        }
+        solvers[k].recover(u_interface, u_interior);
+        if (!WriteAll(fd, u_interior.data(), u_interior.size() * sizeof(double))) {
+            return;
+        }
+    }
+#else
+    (void)model; (void)first; (void)stride; (void)b; (void)fd;
+#endif
+}
+
+bool DomainDecomposition::solve(const FinitModel& model, const Vector& b, Vector& u,
+        const ProgressFunc& progress) const {
+    const size_t parts = subdomains_.size();
+    const size_t workers = this->workers();
+    const size_t ng = interface_.size();
+
+    u.assign(b.size(), 0);
+
+    // Subdomains are processed by child processes when possible and by local
+    // solvers otherwise. Subdomain p goes to the worker p % workers, which
+    // sends its results in the order they are read here.
+    std::vector<int> fds(workers, -1);
+    std::vector<SubdomainSolver> local(parts);
+    auto worker_fd = [&](size_t p) { return fds[p % workers]; };
+#if !defined(WIN32)
+    std::vector<pid_t> pids(workers, -1);
+    for (size_t w = 0; w < workers; w++) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            continue;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Child only computes and never returns to the application
+            close(sv[0]);
+            for (size_t q = 0; q < w; q++) {
+                if (fds[q] >= 0) {
+                    close(fds[q]);
+                }
+            }
+            run_worker(model, w, workers, b, sv[1]);
+            _exit(0);
+        }
+        close(sv[1]);
+        if (pid < 0) {
+            close(sv[0]);
+            continue;
+        }
+        pids[w] = pid;
+        fds[w] = sv[0];
+    }
+#endif
+
+    bool ok = true;
+    std::vector<double> schur(interface_cols_.size(), 0.0);
+    std::vector<double> g(ng);
+    for (size_t i = 0; i < ng; i++) {
+        g[i] = b[interface_[i]];
+    }
+
+    // Sum up condensed subdomains into the interface system
+    std::vector<double> local_schur, local_rhs;
+    for (size_t p = 0; p < parts && ok; p++) {
+        const auto& s = subdomains_[p];
+        const size_t n = s.interface.size();
+
+        if (progress && !progress(static_cast<float>(p) / parts)) {
+            ok = false;
+            break;
+        }
+
+        if (worker_fd(p) < 0) {
+            ok = local[p].condense(s, assemble(model, s), b, local_schur, local_rhs);
+        }
+#if !defined(WIN32)
+        else {
+            char status = 0;
+            local_schur.resize(n * n);
+            local_rhs.resize(n);
+            ok = ReadAll(worker_fd(p), &status, sizeof(status)) && status &&
+                ReadAll(worker_fd(p), local_schur.data(), local_schur.size() * sizeof(double)) &&
+                ReadAll(worker_fd(p), local_rhs.data(), local_rhs.size() * sizeof(double));
+        }
+#endif
+        if (!ok) {
+            break;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            int row = s.interface[i];
+            auto first = interface_cols_.begin() + interface_rows_[row];
+            auto last = interface_cols_.begin() + interface_rows_[row + 1];
+            for (size_t j = 0; j < n; j++) {
+                auto it = std::lower_bound(first, last, s.interface[j]);
+                schur[it - interface_cols_.begin()] += local_schur[i * n + j];
+            }
+            g[row] += local_rhs[i];
+        }
+    }
+
+    // Interface system couples only DOFs of common subdomains and is
+    // factored as a band too. Zero entries (e.g. between disconnected pieces
+    // of a part) are dropped, so they do not widen the band.
+    std::vector<double> ug;
+    if (ok) {
+        std::vector<size_t> rows = { 0 };
+        std::vector<int> cols;
+        std::vector<double> values;
+        for (size_t i = 0; i < ng; i++) {
+            for (size_t k = interface_rows_[i]; k < interface_rows_[i + 1]; k++) {
+                if (schur[k] != 0.0) {
+                    cols.push_back(interface_cols_[k]);
+                    values.push_back(schur[k]);
+                }
+            }
+            rows.push_back(cols.size());
+        }
+        std::vector<double>().swap(schur);
+
+        BandCholesky factor;
+        ok = factor.factor(rows, cols, values);
+        if (ok) {
+            ug = g;
+            factor.solve(ug);
+            for (size_t i = 0; i < ng; i++) {
+                u[interface_[i]] = static_cast<float>(ug[i]);
+            }
+        }
+    }
+
+    // Back substitution of interior displacements
+    std::vector<double> local_ug, ui;
+    for (size_t p = 0; p < parts && ok; p++) {
+        const auto& s = subdomains_[p];
+        local_ug.resize(s.interface.size());
+        for (size_t i = 0; i < s.interface.size(); i++) {
+            local_ug[i] = ug[s.interface[i]];
+        }
+
+        if (worker_fd(p) < 0) {
+            local[p].recover(local_ug, ui);
+        }
+#if !defined(WIN32)
+        else {
+            ui.resize(s.interior.size());
+            ok = WriteAll(worker_fd(p), local_ug.data(), local_ug.size() * sizeof(double)) &&
+                ReadAll(worker_fd(p), ui.data(), ui.size() * sizeof(double));
+        }
+#endif
+        if (ok) {
+            for (size_t i = 0; i < s.interior.size(); i++) {
+                u[s.interior[i]] = static_cast<float>(ui[i]);
+            }
+        }
+    }
+
+#if !defined(WIN32)
+    // Closing the socket also stops a worker that still waits for input
+    for (size_t w = 0; w < workers; w++) {
+        if (fds[w] >= 0) {
+            close(fds[w]);
+            if (!ok) {
+                kill(pids[w], SIGTERM);
+            }
+            waitpid(pids[w], nullptr, 0);
+        }
+    }
+#endif
+
+    return ok;
+}
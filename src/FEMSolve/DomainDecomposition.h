@@ -0,0 +1,68 @@
+#pragma once
+
+struct FinitModel;
+
+/*
+ * Substructuring solver. The truss is split into subdomains by graph
+ * partitioning of its nodes. Subdomains are handled by a limited number of
+ * worker processes, each of them takes several subdomains in turn. A worker
+ * assembles and factors the interior of its subdomains, condenses them onto
+ * the interface (Schur complement) and recovers interior displacements once
+ * the interface is solved. The calling process keeps only the partition and
+ * assembles the interface system as a sparse matrix.
+ */
+class DomainDecomposition {
+public:
+    DomainDecomposition() = default;
+
+    // With non-positive number of parts it is chosen from the model size,
+    // with non-positive number of workers there is one per thread
+    void setup(const FinitModel& model, int parts, int workers);
+    void clear();
+
+    // Returns false if a subdomain or the interface system is singular
+    // or the solution is stopped by the progress function
+    bool solve(const FinitModel& model, const Vector& b, Vector& u,
+        const ProgressFunc& progress = nullptr) const;
+
+    size_t parts() const { return subdomains_.size(); }
+    size_t workers() const { return std::min(workers_, subdomains_.size()); }
+    size_t interface_size() const { return interface_.size(); }
+    size_t max_interior_size() const;
+
+private:
+    struct Subdomain {
+        std::vector<int> interior;   // Global DOFs of interior
+        std::vector<int> interface;  // Positions in the interface system
+        std::vector<size_t> elems;   // Elements of the part
+    };
+
+    // Work of a single subdomain
+    class SubdomainSolver {
+    public:
+        bool condense(const Subdomain& s, const SparseMatrix& a, const Vector& b,
+            std::vector<double>& schur, std::vector<double>& rhs);
+        void recover(const std::vector<double>& u_interface,
+            std::vector<double>& u_interior) const;
+
+    private:
+        SparseMatrix aii_, aig_;
+        std::vector<double> bi_;
+        BandCholesky factor_;
+    };
+
+    // Local stiffness of the part, interior DOFs first
+    SparseMatrix assemble(const FinitModel& model, const Subdomain& s) const;
+    // Subdomains from the first one stride apart
+    void run_worker(const FinitModel& model, size_t first, size_t stride,
+        const Vector& b, int fd) const;
+
+private:
+    size_t workers_{ 1 };
+    std::vector<Subdomain> subdomains_;
+    std::vector<int> interface_;  // Global DOFs of the interface system
+
+    // Sparsity of the interface system, DOFs of a common subdomain are coupled
+    std::vector<size_t> interface_rows_;
+    std::vector<int> interface_cols_;
+};
@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "Canvas.h"
+#include "Headless.h"
+#include "Painter.h"
+#include "GraphicsUtils.h"
+#include "LinAlgUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
+#include "FEM.h"
+#include "LodGrid.h"
+#include "SpatialIndex.h"
+#include "ModelWidget.h"
+#include "Export.h"
+
+namespace {
+    // Solves the model and rasterises it with the results
+    bool RenderModel(const char* modelFile, Canvas& canvas) {
+        FinitModel model;
+        model.load_from_file(modelFile);
+        if (model.nodes.empty()) {
+            fprintf(stderr, "Model %s is empty\n", modelFile);
+            return false;
+        }
+
+        // Multigrid scales to large models without assembling the dense matrix
+        model.method = SolverMethod::Multigrid;
+        if (!model.prepare_solve() || !model.solve()) {
+            fprintf(stderr, "Solution of %s failed\n", modelFile);
+            return false;
+        }
+
+        // Widget is never shown, the scene is rasterised on the CPU
+        ModelWidget widget(0, 0, canvas.width(), canvas.height(), model);
+        widget.reload_model();
+        widget.show_results(true);
+        widget.render(canvas);
+
+        return true;
+    }
+}
+
+int ExportImage(const char* modelFile, const char* imageFile, int width, int height) {
+    Canvas canvas(width, height);
+    if (!RenderModel(modelFile, canvas)) {
+        return 1;
+    }
+
+    if (!canvas.write_png(imageFile)) {
+        fprintf(stderr, "Unable to write %s\n", imageFile);
+        return 1;
+    }
+
+    return 0;
+}
+
+int ExportImages(const char* directory, const std::vector<std::string>& modelFiles,
+        int width, int height) {
+    bool solved = true;
+    int status = RenderFrames(directory, width, height, [&](int frame, Canvas& canvas) {
+        if (frame >= static_cast<int>(modelFiles.size())) {
+            return false;
+        }
+        printf("frame%04d.png: %s\n", frame, modelFiles[frame].c_str());
+        if (!RenderModel(modelFiles[frame].c_str(), canvas)) {
+            // Keep numbering of frames, the failed model is left blank
+            canvas.clear({ 0, 0, 0, 255 });
+            solved = false;
+        }
+        return true;
+    });
+
+    return (solved && status == 0) ? 0 : 1;
+}
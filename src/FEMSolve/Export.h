@@ -0,0 +1,10 @@
+#pragma once
+
+// Solve the model without a display and save the deformed shape with the force
+// colors to a PNG image, returns the exit code of the application
+int ExportImage(const char* modelFile, const char* imageFile, int width, int height);
+
+// Same for several models, images are written on a pool of encoder threads
+// to <directory>/frameNNNN.png in the order of the model files
+int ExportImages(const char* directory, const std::vector<std::string>& modelFiles,
+    int width, int height);
@@ -1,9 +1,18 @@
 #include "pch.h"
 #include "LinAlgUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
 #include "FEM.h"
 
 constexpr int BufferLen = 256;
 
+constexpr double SolverTolerance = 1e-6;
+constexpr int SolverIterationsPerDof = 10;
+
+// Assembly progress is reported once per this number of elements
+constexpr size_t ProgressElements = 1024;
+
 void ReadLine(FILE* f, char* string) {
     do {
         fgets(string, BufferLen, f);
@@ -22,9 +31,27 @@ void FinitModel::clear() {
     elems.clear();
 
     a.clear();
+    stiffness.clear();
+    sparse.clear();
+    amg.clear();
+    subdomains.clear();
     b.clear();
     u.clear();
-    a.clear();
+    n.clear();
+
+    solver_result = IterativeResult();
+}
+
+void FinitModel::update_element(Element& e) const {
+    // Calculate element parameters
+    auto n1 = nodes[e.nodes[0] - 1];
+    auto n2 = nodes[e.nodes[1] - 1];
+    float dx = n2.x - n1.x;
+    float dy = n2.y - n1.y;
+    e.length2 = dx * dx + dy * dy;
+    e.length = sqrt(e.length2);
+    e.cosa = dx / e.length;
+    e.sina = dy / e.length;
 }
 
 void FinitModel::load_from_file(const std::string& fileName) {
@@ -86,15 +113,7 @@ void FinitModel::load_from_file(const std::string& fileName) {
                 ReadLine(in, line);
                 sscanf(line, "%d %d %d", &e.elem, &e.nodes[0], &e.nodes[1]);
 
-                // Calculate element parameters
-                auto n1 = nodes[e.nodes[0] - 1];
-                auto n2 = nodes[e.nodes[1] - 1];
-                float dx = n2.x - n1.x;
-                float dy = n2.y - n1.y;
-                e.length2 = dx * dx + dy * dy;
-                e.length = sqrt(e.length2);
-                e.cosa = dx / e.length;
-                e.sina = dy / e.length;
+                update_element(e);
 
                 elems[i] = e;
             }
@@ -115,12 +134,8 @@ void FinitModel::load_from_file(const std::string& fileName) {
     fclose(in);
 }
 
-void FinitModel::prepare_solve() {
-    // Create vectors
-    a.resize(component_count, component_count, 0);
-    b.resize(component_count, 0);
-    u.resize(component_count, 0);
-    n.resize(elems.size(), 0);
+void FinitModel::apply_loads() {
+    b.assign(component_count, 0);
 
     // Fill B matrix
     for (const auto& l : loads) {
@@ -128,8 +143,103 @@ void FinitModel::prepare_solve() {
         b(l.node * 2 - 1) = l.py;
     }
 
+    for (const auto& f : fixes) {
+        b((f.node - 1) * 2 + 1 - (f.axis % 2)) = 0;
+    }
+}
+
+Matrix FinitModel::rigid_body_modes() const {
+    constexpr int ModeCount = 3;
+
+    float cx{ 0 }, cy{ 0 };
+    for (const auto& node : nodes) {
+        cx += node.x;
+        cy += node.y;
+    }
+    if (!nodes.empty()) {
+        cx /= nodes.size();
+        cy /= nodes.size();
+    }
+
+    // Translations along X and Y and rotation around the center
+    Matrix modes;
+    modes.resize(component_count, ModeCount, 0);
+    for (const auto& node : nodes) {
+        int i = (node.node - 1) * 2;
+        modes(i, 0) = 1;
+        modes(i + 1, 1) = 1;
+        modes(i, 2) = -(node.y - cy);
+        modes(i + 1, 2) = node.x - cx;
+    }
+    return modes;
+}
+
+bool FinitModel::report_progress(const char* stage, float fraction) {
+    if (progress && !progress(stage, fraction)) {
+        cancelled = true;
+    }
+    return !cancelled;
+}
+
+bool FinitModel::prepare_solve() {
+    cancelled = false;
+
+    // Create vectors
+    apply_loads();
+    u.assign(component_count, 0);
+    n.assign(elems.size(), 0);
+
+    if (method == SolverMethod::DomainDecomposition) {
+        // Subdomain matrices are assembled by the partitioned solver
+        a.clear();
+        stiffness.clear();
+        sparse.clear();
+        amg.clear();
+        if (!report_progress("Partitioning", 0)) {
+            return false;
+        }
+        subdomains.setup(*this, subdomain_count, worker_count);
+        return report_progress("Partitioning", 1);
+    }
+
+    subdomains.clear();
+
+    if (method != SolverMethod::Direct) {
+        // Matrix A is never assembled
+        a.clear();
+        if (!report_progress("Assembly", 0)) {
+            return false;
+        }
+        stiffness.build(*this);
+
+        if (method == SolverMethod::Multigrid) {
+            if (!report_progress("Multigrid setup", 0)) {
+                return false;
+            }
+            sparse = stiffness.assemble();
+            amg.setup(sparse, ModelDimensions, rigid_body_modes());
+            return report_progress("Multigrid setup", 1);
+        }
+
+        sparse.clear();
+        amg.clear();
+        return report_progress("Assembly", 1);
+    }
+
+    stiffness.clear();
+    sparse.clear();
+    amg.clear();
+    a.clear();
+    a.resize(component_count, component_count, 0);
+
     // Fill A matrix
+    size_t k = 0;
     for (const auto& e : elems) {
+        if (k++ % ProgressElements == 0 &&
+            !report_progress("Assembly", static_cast<float>(k) / elems.size())) {
+            return false;
+        }
+
         auto n1 = nodes[e.nodes[0] - 1];
         auto n2 = nodes[e.nodes[1] - 1];
         float sina = e.sina;
@@ -176,11 +286,60 @@ void FinitModel::prepare_solve() {
         a(node, node) = 1;
         b(node) = 0;
     }
+
+    return report_progress("Assembly", 1);
 }
 
-void FinitModel::solve() {
+bool FinitModel::solve() {
+    cancelled = false;
+
+    auto stage_progress = [this](const char* stage) {
+        return [this, stage](float fraction) {
+            return report_progress(stage, fraction);
+        };
+    };
+
     // Solve system of linear equations A*u=b
-    seqv(a, b, u, component_count);
+    if (method == SolverMethod::Multigrid) {
+        auto op = [this](const Vector& x, Vector& y) {
+            sparse.multiply(x, y);
+        };
+        auto precond = [this](const Vector& r, Vector& z) {
+            amg.apply(r, z);
+        };
+        u.assign(component_count, 0);
+        solver_result = cg(op, b, u, SolverTolerance,
+            SolverIterationsPerDof * component_count, precond,
+            stage_progress("Conjugate gradient"));
+    }
+    else if (method == SolverMethod::ConjugateGradient) {
+        Vector diag = stiffness.diagonal();
+        auto jacobi = [&diag](const Vector& r, Vector& z) {
+            z.resize(r.size());
+            for (size_t i = 0; i < r.size(); i++) {
+                z[i] = r[i] / diag[i];
+            }
+        };
+        auto op = [this](const Vector& x, Vector& y) {
+            stiffness.apply(x, y);
+        };
+        u.assign(component_count, 0);
+        solver_result = cg(op, b, u, SolverTolerance,
+            SolverIterationsPerDof * component_count, jacobi,
+            stage_progress("Conjugate gradient"));
+    }
+    else if (method == SolverMethod::DomainDecomposition) {
+        solver_result = IterativeResult();
+        solver_result.converged = subdomains.solve(*this, b, u, stage_progress("Subdomains"));
+    }
+    else {
+        seqv(a, b, u, component_count, stage_progress("Elimination"));
+        solver_result = IterativeResult();
+    }
+
+    if (cancelled) {
+        return false;
+    }
 
     u /= E * F;
 
@@ -192,4 +351,6 @@ void FinitModel::solve() {
         float ny = (u(2 * n1.node - 1) - u(2 * n2.node - 1) * (n1.y - n2.y));
         n(k++) = (nx + ny) / e.length2;
     }
+
+    return true;
 }
@@ -2,6 +2,23 @@
 
 constexpr int ModelDimensions = 2;
 
+enum class SolverMethod {
+    Direct,             // Gaussian elimination of the assembled matrix
+    ConjugateGradient,  // Matrix-free preconditioned conjugate gradient
+    Multigrid,          // Conjugate gradient with algebraic multigrid preconditioner
+    DomainDecomposition // Subdomains condensed in worker processes
+};
+
+// Receives name of the current stage and its completed fraction,
+// returns false to cancel the solution
+using SolveProgressFunc = std::function<bool(const char* stage, float fraction)>;
+
+// Number of subdomains is chosen from the model size
+constexpr int AutoSubdomainCount = 0;
+
+// One worker process of the domain decomposition per thread
+constexpr int AutoWorkerCount = 0;
+
 struct Node {
     int node;
     float x, y;
@@ -31,17 +48,43 @@ struct FinitModel {
     void load_from_file(const std::string& fileName);
     void clear();
 
-    void prepare_solve();
-    void solve();
+    // Calculate length and direction of the element from its nodes
+    void update_element(Element& e) const;
+
+    // Assemble the system and set up the solver. For iterative methods
+    // solve() may be called again after apply_loads() for other load cases.
+    // Both return false if cancelled by the progress function.
+    bool prepare_solve();
+    void apply_loads();
+    bool solve();
+
+    // Passes progress to the progress function if it is set
+    bool report_progress(const char* stage, float fraction);
+
+    // Rigid body modes of the model in columns
+    Matrix rigid_body_modes() const;
 
     int component_count{ 0 };
 
+    SolverMethod method{ SolverMethod::Direct };
+    IterativeResult solver_result;
+    int subdomain_count{ AutoSubdomainCount };
+    int worker_count{ AutoWorkerCount };
+
+    // May be called from a worker thread
+    SolveProgressFunc progress;
+    bool cancelled{ false };
+
     std::vector<Node> nodes;
     std::vector<Fixture> fixes;
     std::vector<Load> loads;
     std::vector<Element> elems;
 
     Matrix a;
+    StiffnessOperator stiffness;
+    SparseMatrix sparse;
+    AmgPreconditioner amg;
+    DomainDecomposition subdomains;
     Vector b;
     Vector u;
     Vector n;
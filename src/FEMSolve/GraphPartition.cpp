@@ -0,0 +1,287 @@
+#include "pch.h"
+#include "GraphPartition.h"
+
+namespace PartitionParams {
+    // Graphs smaller than this are bisected directly
+    constexpr size_t CoarsestSize = 64;
+
+    // Coarsening stops when a level shrinks less than this ratio
+    constexpr double MinCoarsening = 0.9;
+
+    // Allowed excess of part weight over its target
+    constexpr double Imbalance = 0.03;
+
+    constexpr int RefinementPasses = 8;
+}
+
+namespace {
+
+    // Heavy edge matching, returns index of coarse vertex of every vertex
+    std::vector<int> MatchVertices(const Graph& g, size_t& coarse_size) {
+        const size_t n = g.size();
+        std::vector<int> match(n, -1);
+
+        // Deterministic pseudo-random visiting order
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::mt19937 rng(static_cast<unsigned>(n));
+        std::shuffle(order.begin(), order.end(), rng);
+
+        for (int v : order) {
+            if (match[v] >= 0) {
+                continue;
+            }
+            int best = v;
+            int best_weight = -1;
+            for (size_t k = g.offsets[v]; k < g.offsets[v + 1]; k++) {
+                int u = g.adjacent[k];
+                if (match[u] < 0 && u != v && g.edge_weights[k] > best_weight) {
+                    best = u;
+                    best_weight = g.edge_weights[k];
+                }
+            }
+            match[v] = best;
+            match[best] = v;
+        }
+
+        std::vector<int> coarse(n, -1);
+        coarse_size = 0;
+        for (size_t v = 0; v < n; v++) {
+            if (coarse[v] < 0) {
+                coarse[v] = coarse[match[v]] = static_cast<int>(coarse_size++);
+            }
+        }
+        return coarse;
+    }
+
+    Graph Contract(const Graph& g, const std::vector<int>& coarse, size_t coarse_size) {
+        Graph c;
+        c.vertex_weights.assign(coarse_size, 0);
+        for (size_t v = 0; v < g.size(); v++) {
+            c.vertex_weights[coarse[v]] += g.vertex_weights[v];
+        }
+
+        std::vector<std::vector<int>> members(coarse_size);
+        for (size_t v = 0; v < g.size(); v++) {
+            members[coarse[v]].push_back(static_cast<int>(v));
+        }
+
+        std::vector<int> marker(coarse_size, -1);
+        std::vector<int> weight(coarse_size, 0);
+        std::vector<int> touched;
+
+        c.offsets.push_back(0);
+        for (size_t cv = 0; cv < coarse_size; cv++) {
+            touched.clear();
+            for (int v : members[cv]) {
+                for (size_t k = g.offsets[v]; k < g.offsets[v + 1]; k++) {
+                    int cu = coarse[g.adjacent[k]];
+                    if (cu == static_cast<int>(cv)) {
+                        continue;
+                    }
+                    if (marker[cu] != static_cast<int>(cv)) {
+                        marker[cu] = static_cast<int>(cv);
+                        weight[cu] = 0;
+                        touched.push_back(cu);
+                    }
+                    weight[cu] += g.edge_weights[k];
+                }
+            }
+            for (int cu : touched) {
+                c.adjacent.push_back(cu);
+                c.edge_weights.push_back(weight[cu]);
+            }
+            c.offsets.push_back(c.adjacent.size());
+        }
+
+        return c;
+    }
+
+    // Breadth-first search, returns the last reached vertex
+    int FarthestVertex(const Graph& g, int start) {
+        std::vector<bool> visited(g.size(), false);
+        std::vector<int> queue = { start };
+        visited[start] = true;
+        for (size_t i = 0; i < queue.size(); i++) {
+            int v = queue[i];
+            for (size_t k = g.offsets[v]; k < g.offsets[v + 1]; k++) {
+                int u = g.adjacent[k];
+                if (!visited[u]) {
+                    visited[u] = true;
+                    queue.push_back(u);
+                }
+            }
+        }
+        return queue.back();
+    }
+
+    // Greedy graph growing from a pseudo-peripheral vertex
+    std::vector<char> GrowBisection(const Graph& g, long target) {
+        const size_t n = g.size();
+        std::vector<char> side(n, 1);
+        long weight = 0;
+
+        int start = FarthestVertex(g, FarthestVertex(g, 0));
+        std::vector<bool> queued(n, false);
+        std::vector<int> queue;
+
+        // Disconnected components are grown one after another
+        size_t next_seed = 0;
+        while (weight < target) {
+            if (queue.empty()) {
+                while (next_seed < n && queued[next_seed]) {
+                    next_seed++;
+                }
+                if (queued[start]) {
+                    if (next_seed == n) {
+                        break;
+                    }
+                    start = static_cast<int>(next_seed);
+                }
+                queue.push_back(start);
+                queued[start] = true;
+            }
+
+            int v = queue.front();
+            queue.erase(queue.begin());
+
+            side[v] = 0;
+            weight += g.vertex_weights[v];
+
+            for (size_t k = g.offsets[v]; k < g.offsets[v + 1]; k++) {
+                int u = g.adjacent[k];
+                if (!queued[u]) {
+                    queued[u] = true;
+                    queue.push_back(u);
+                }
+            }
+        }
+
+        return side;
+    }
+
+    // Greedy boundary refinement that keeps the balance
+    void Refine(const Graph& g, std::vector<char>& side, long target0, long target1) {
+        using namespace PartitionParams;
+
+        long weight[2] = { 0, 0 };
+        for (size_t v = 0; v < g.size(); v++) {
+            weight[static_cast<int>(side[v])] += g.vertex_weights[v];
+        }
+        const long limit[2] = {
+            static_cast<long>(target0 * (1.0 + Imbalance)) + 1,
+            static_cast<long>(target1 * (1.0 + Imbalance)) + 1
+        };
+
+        for (int pass = 0; pass < RefinementPasses; pass++) {
+            bool moved = false;
+            for (size_t v = 0; v < g.size(); v++) {
+                int from = side[v];
+                int to = from ^ 1;
+
+                int gain = 0;
+                for (size_t k = g.offsets[v]; k < g.offsets[v + 1]; k++) {
+                    gain += (side[g.adjacent[k]] == to) ? g.edge_weights[k] : -g.edge_weights[k];
+                }
+
+                long w = g.vertex_weights[v];
+                bool balanced = weight[to] + w <= limit[to];
+                bool rebalance = weight[from] > limit[from] && weight[to] + w < weight[from];
+                if ((gain > 0 && balanced) || (gain >= 0 && rebalance)) {
+                    side[v] = static_cast<char>(to);
+                    weight[from] -= w;
+                    weight[to] += w;
+                    moved = true;
+                }
+            }
+            if (!moved) {
+                break;
+            }
+        }
+    }
+
+    // Split graph into two sides with weight of side 0 close to target0
+    std::vector<char> Bisect(const Graph& g, long target0, long target1) {
+        using namespace PartitionParams;
+
+        std::vector<char> side;
+        size_t coarse_size{ 0 };
+        std::vector<int> coarse;
+
+        if (g.size() > CoarsestSize) {
+            coarse = MatchVertices(g, coarse_size);
+        }
+
+        if (g.size() <= CoarsestSize || coarse_size > MinCoarsening * g.size()) {
+            side = GrowBisection(g, target0);
+        }
+        else {
+            Graph c = Contract(g, coarse, coarse_size);
+            auto coarse_side = Bisect(c, target0, target1);
+
+            side.resize(g.size());
+            for (size_t v = 0; v < g.size(); v++) {
+                side[v] = coarse_side[coarse[v]];
+            }
+        }
+
+        Refine(g, side, target0, target1);
+        return side;
+    }
+
+    Graph Subgraph(const Graph& g, const std::vector<int>& vertices) {
+        std::vector<int> local(g.size(), -1);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            local[vertices[i]] = static_cast<int>(i);
+        }
+
+        Graph s;
+        s.offsets.push_back(0);
+        for (int v : vertices) {
+            s.vertex_weights.push_back(g.vertex_weights[v]);
+            for (size_t k = g.offsets[v]; k < g.offsets[v + 1]; k++) {
+                int u = local[g.adjacent[k]];
+                if (u >= 0) {
+                    s.adjacent.push_back(u);
+                    s.edge_weights.push_back(g.edge_weights[k]);
+                }
+            }
+            s.offsets.push_back(s.adjacent.size());
+        }
+        return s;
+    }
+
+    void PartitionRecursive(const Graph& g, const std::vector<int>& vertices,
+            int parts, int first_part, std::vector<int>& result) {
+        if (parts <= 1 || vertices.size() <= 1) {
+            for (int v : vertices) {
+                result[v] = first_part;
+            }
+            return;
+        }
+
+        Graph s = Subgraph(g, vertices);
+        long total = std::accumulate(s.vertex_weights.begin(), s.vertex_weights.end(), 0L);
+
+        int parts0 = parts / 2;
+        long target0 = total * parts0 / parts;
+        auto side = Bisect(s, target0, total - target0);
+
+        std::vector<int> half[2];
+        for (size_t i = 0; i < vertices.size(); i++) {
+            half[static_cast<int>(side[i])].push_back(vertices[i]);
+        }
+
+        PartitionRecursive(g, half[0], parts0, first_part, result);
+        PartitionRecursive(g, half[1], parts - parts0, first_part + parts0, result);
+    }
+
+}
+
+std::vector<int> PartitionGraph(const Graph& graph, int parts) {
+    std::vector<int> result(graph.size(), 0);
+    std::vector<int> vertices(graph.size());
+    std::iota(vertices.begin(), vertices.end(), 0);
+    PartitionRecursive(graph, vertices, parts, 0, result);
+    return result;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Undirected weighted graph in compressed adjacency form
+struct Graph {
+    size_t size() const { return vertex_weights.size(); }
+
+    std::vector<size_t> offsets;
+    std::vector<int> adjacent;
+    std::vector<int> edge_weights;
+    std::vector<int> vertex_weights;
+};
+
+// Multilevel recursive bisection of the graph into the given number
+// of parts with balanced vertex weights. Returns part of every vertex.
+std::vector<int> PartitionGraph(const Graph& graph, int parts);
@@ -1,4 +1,6 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
 #include "GraphicsUtils.h"
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
@@ -118,3 +120,55 @@ void DrawArrow(float x1, float y1, float x2, float y2) {
         x2 + arrow_size * cos(-angle - M_PI / 6), y2 + arrow_size * sin(-angle - M_PI / 6));
 #endif
 }
+
+static_assert(sizeof(ColorVertex) == 4 * sizeof(unsigned char) + 2 * sizeof(float),
+    "ColorVertex must match GL_C4UB_V2F layout");
+
+PrimitiveBatch::PrimitiveBatch(PrimitiveType type)
+    : type_(type) {
+}
+
+void PrimitiveBatch::clear() {
+    vertices_.clear();
+}
+
+void PrimitiveBatch::set_color(Fl_Color c) {
+    Fl::get_color(c, color_.r, color_.g, color_.b);
+    color_.a = 255;
+}
+
+void PrimitiveBatch::set_color(unsigned char r, unsigned char g, unsigned char b) {
+    color_.r = r;
+    color_.g = g;
+    color_.b = b;
+    color_.a = 255;
+}
+
+void PrimitiveBatch::add_vertex(float x, float y) {
+    ColorVertex v = color_;
+    v.x = x;
+    v.y = y;
+    vertices_.push_back(v);
+}
+
+void PrimitiveBatch::add_line(float x1, float y1, float x2, float y2) {
+    add_vertex(x1, y1);
+    add_vertex(x2, y2);
+}
+
+void PrimitiveBatch::add_triangle(float x1, float y1, float x2, float y2, float x3, float y3) {
+    add_vertex(x1, y1);
+    add_vertex(x2, y2);
+    add_vertex(x3, y3);
+}
+
+void PrimitiveBatch::add_rectangle(float x1, float y1, float x2, float y2) {
+    add_vertex(x1, y1);
+    add_vertex(x2, y1);
+    add_vertex(x2, y2);
+    add_vertex(x1, y2);
+}
+
+void PrimitiveBatch::draw(Painter& painter) const {
+    painter.draw(type_, vertices_.data(), vertices_.size());
+}
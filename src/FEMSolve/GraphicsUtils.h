@@ -6,7 +6,7 @@
 #define DRAW_METHOD DRAW_METHOD_FLTK
 #endif
 
-using CoordinateFunc = std::function<float(float)>;
+class Painter;
 
 void DrawLine(float x1, float y1, float x2, float y2);
 void DrawTriangle(float x1, float y1, float x2, float y2, float x3, float y3);
@@ -18,3 +18,30 @@ void PrintText(void *font, float x, float y, const char *fmt, ...);
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
 void PrintText(int font, float x, float y, const char* fmt, ...);
 #endif
+
+// Primitives of one type kept in an interleaved vertex array
+// and drawn with a single call
+class PrimitiveBatch {
+public:
+    explicit PrimitiveBatch(PrimitiveType type);
+
+    void clear();
+
+    void set_color(Fl_Color c);
+    void set_color(unsigned char r, unsigned char g, unsigned char b);
+    void add_line(float x1, float y1, float x2, float y2);
+    void add_triangle(float x1, float y1, float x2, float y2, float x3, float y3);
+    void add_rectangle(float x1, float y1, float x2, float y2);
+
+    void draw(Painter& painter) const;
+
+    size_t vertex_count() const { return vertices_.size(); }
+
+private:
+    void add_vertex(float x, float y);
+
+private:
+    PrimitiveType type_;
+    ColorVertex color_{ 255, 255, 255, 255, 0, 0 };
+    std::vector<ColorVertex> vertices_;
+};
@@ -23,12 +23,16 @@ std::ostream& operator<<(std::ostream& os, const Matrix& m) {
     return os;
 }
 
-void seqv(Matrix& a, Vector& b, Vector& x, int N) {
+bool seqv(Matrix& a, Vector& b, Vector& x, int N, const ProgressFunc& progress) {
     // 1. Прямой ход
     // Приведение матрицы к треугольному виду
 
     // Перебираем все строки со 2-й
     for (int k = 1; k < N; k++) {
+        if (progress && !progress(static_cast<float>(k) / N)) {
+            return false;
+        }
+
         int imax = 0;
         float a11max = fabs(a(k - 1, 0));
         // Поиск наибольшего элемента в k-1-й строке
@@ -72,4 +76,459 @@ void seqv(Matrix& a, Vector& b, Vector& x, int N) {
             b(j) -= a(j, i) * x(i);
         }
     }
+
+    return true;
+}
+
+double dot(const Vector& a, const Vector& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        sum += static_cast<double>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+IterativeResult cg(const LinearOperator& a, const Vector& b, Vector& x,
+        double tolerance, int max_iterations, const LinearOperator& precond,
+        const ProgressFunc& progress) {
+    const size_t n = b.size();
+    IterativeResult result;
+
+    x.resize(n, 0.0f);
+
+    Vector r, z, p, q;
+    a(x, q);
+    r.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        r[i] = b[i] - q[i];
+    }
+
+    double norm_b = sqrt(dot(b, b));
+    if (norm_b == 0.0) {
+        norm_b = 1.0;
+    }
+
+    result.residual = sqrt(dot(r, r)) / norm_b;
+    if (result.residual <= tolerance) {
+        result.converged = true;
+        return result;
+    }
+
+    if (precond) {
+        precond(r, z);
+    }
+    else {
+        z = r;
+    }
+    p = z;
+    double rz = dot(r, z);
+
+    // Progress is measured by the residual reduction on a log scale
+    const double initial_residual = result.residual;
+    const double reduction = log(initial_residual / tolerance);
+
+    for (int k = 1; k <= max_iterations; k++) {
+        if (progress) {
+            double fraction = log(initial_residual / result.residual) / reduction;
+            if (!progress(static_cast<float>(std::max(0.0, std::min(1.0, fraction))))) {
+                break;
+            }
+        }
+
+        a(p, q);
+
+        double pq = dot(p, q);
+        if (pq == 0.0) {
+            break;
+        }
+        float alpha = static_cast<float>(rz / pq);
+
+        for (size_t i = 0; i < n; i++) {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+        }
+
+        result.iterations = k;
+        result.residual = sqrt(dot(r, r)) / norm_b;
+        if (result.residual <= tolerance) {
+            result.converged = true;
+            break;
+        }
+
+        if (precond) {
+            precond(r, z);
+        }
+        else {
+            z = r;
+        }
+
+        double rz_new = dot(r, z);
+        float beta = static_cast<float>(rz_new / rz);
+        rz = rz_new;
+
+        for (size_t i = 0; i < n; i++) {
+            p[i] = z[i] + beta * p[i];
+        }
+    }
+
+    return result;
+}
+
+SparseMatrix SparseMatrix::from_triplets(size_t rows, size_t cols, std::vector<Triplet>& triplets) {
+    std::sort(triplets.begin(), triplets.end(),
+        [](const Triplet& a, const Triplet& b) {
+            return (a.row < b.row) || (a.row == b.row && a.col < b.col);
+        });
+
+    SparseMatrix m;
+    m.rows = rows;
+    m.cols = cols;
+    m.row_ptr.assign(rows + 1, 0);
+    m.col_idx.reserve(triplets.size());
+    m.values.reserve(triplets.size());
+
+    for (size_t i = 0; i < triplets.size(); i++) {
+        const auto& t = triplets[i];
+        if (i > 0 && t.row == triplets[i - 1].row && t.col == triplets[i - 1].col) {
+            m.values.back() += t.value;
+            continue;
+        }
+        m.col_idx.push_back(t.col);
+        m.values.push_back(t.value);
+        m.row_ptr[t.row + 1]++;
+    }
+
+    for (size_t i = 0; i < rows; i++) {
+        m.row_ptr[i + 1] += m.row_ptr[i];
+    }
+
+    return m;
+}
+
+void SparseMatrix::clear() {
+    rows = cols = 0;
+    row_ptr.clear();
+    col_idx.clear();
+    values.clear();
+}
+
+void SparseMatrix::multiply(const Vector& x, Vector& y) const {
+    y.resize(rows);
+    for (size_t i = 0; i < rows; i++) {
+        float sum = 0.0f;
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            sum += values[k] * x[col_idx[k]];
+        }
+        y[i] = sum;
+    }
+}
+
+SparseMatrix SparseMatrix::transpose() const {
+    SparseMatrix t;
+    t.rows = cols;
+    t.cols = rows;
+    t.row_ptr.assign(cols + 1, 0);
+    t.col_idx.resize(nonzeros());
+    t.values.resize(nonzeros());
+
+    for (int c : col_idx) {
+        t.row_ptr[c + 1]++;
+    }
+    for (size_t i = 0; i < cols; i++) {
+        t.row_ptr[i + 1] += t.row_ptr[i];
+    }
+
+    std::vector<size_t> pos(t.row_ptr.begin(), t.row_ptr.end() - 1);
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            size_t p = pos[col_idx[k]]++;
+            t.col_idx[p] = static_cast<int>(i);
+            t.values[p] = values[k];
+        }
+    }
+
+    return t;
+}
+
+Vector SparseMatrix::diagonal() const {
+    Vector d;
+    d.resize(rows, 0.0f);
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            if (col_idx[k] == static_cast<int>(i)) {
+                d[i] += values[k];
+            }
+        }
+    }
+    return d;
+}
+
+SparseMatrix operator*(const SparseMatrix& a, const SparseMatrix& b) {
+    SparseMatrix c;
+    c.rows = a.rows;
+    c.cols = b.cols;
+    c.row_ptr.assign(a.rows + 1, 0);
+
+    // Row by row product with a dense accumulator
+    std::vector<int> marker(b.cols, -1);
+    std::vector<float> accum(b.cols, 0.0f);
+    std::vector<int> row_cols;
+
+    for (size_t i = 0; i < a.rows; i++) {
+        row_cols.clear();
+        for (size_t ka = a.row_ptr[i]; ka < a.row_ptr[i + 1]; ka++) {
+            int j = a.col_idx[ka];
+            float va = a.values[ka];
+            for (size_t kb = b.row_ptr[j]; kb < b.row_ptr[j + 1]; kb++) {
+                int col = b.col_idx[kb];
+                if (marker[col] != static_cast<int>(i)) {
+                    marker[col] = static_cast<int>(i);
+                    accum[col] = 0.0f;
+                    row_cols.push_back(col);
+                }
+                accum[col] += va * b.values[kb];
+            }
+        }
+
+        std::sort(row_cols.begin(), row_cols.end());
+        for (int col : row_cols) {
+            if (accum[col] != 0.0f) {
+                c.col_idx.push_back(col);
+                c.values.push_back(accum[col]);
+            }
+        }
+        c.row_ptr[i + 1] = c.values.size();
+    }
+
+    return c;
+}
+
+bool DenseLU::factor(const Matrix& a) {
+    const size_t n = a.rows();
+    lu_.clear();
+    lu_.resize(n, n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            lu_(i, j) = a(i, j);
+        }
+    }
+
+    pivots_.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        // Search for the pivot element in k-th column
+        size_t p = k;
+        for (size_t i = k + 1; i < n; i++) {
+            if (fabs(lu_(i, k)) > fabs(lu_(p, k))) {
+                p = i;
+            }
+        }
+        pivots_[k] = p;
+
+        if (lu_(p, k) == 0.0) {
+            return false;
+        }
+
+        if (p != k) {
+            for (size_t j = 0; j < n; j++) {
+                std::swap(lu_(k, j), lu_(p, j));
+            }
+        }
+
+        for (size_t i = k + 1; i < n; i++) {
+            lu_(i, k) /= lu_(k, k);
+            double m = lu_(i, k);
+            if (m == 0.0) {
+                continue;
+            }
+            for (size_t j = k + 1; j < n; j++) {
+                lu_(i, j) -= m * lu_(k, j);
+            }
+        }
+    }
+
+    return true;
+}
+
+void DenseLU::solve(const Vector& b, Vector& x) const {
+    const size_t n = pivots_.size();
+    std::vector<double> y(b.begin(), b.end());
+
+    for (size_t k = 0; k < n; k++) {
+        std::swap(y[k], y[pivots_[k]]);
+    }
+
+    // Forward substitution with unit lower triangle
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < i; j++) {
+            y[i] -= lu_(i, j) * y[j];
+        }
+    }
+
+    // Back substitution with upper triangle
+    for (size_t i = n; i-- > 0;) {
+        for (size_t j = i + 1; j < n; j++) {
+            y[i] -= lu_(i, j) * y[j];
+        }
+        y[i] /= lu_(i, i);
+    }
+
+    x.resize(n);
+    std::copy(y.begin(), y.end(), x.begin());
+}
+
+void DenseLU::clear() {
+    lu_.clear();
+    pivots_.clear();
+}
+
+bool BandCholesky::factor(const SparseMatrix& a) {
+    std::vector<double> values(a.values.begin(), a.values.end());
+    return factor(a.row_ptr, a.col_idx, values);
+}
+
+bool BandCholesky::factor(const std::vector<size_t>& row_ptr, const std::vector<int>& col_idx,
+        const std::vector<double>& values) {
+    const size_t n = row_ptr.size() - 1;
+    clear();
+
+    auto degree = [&row_ptr](int i) { return row_ptr[i + 1] - row_ptr[i]; };
+
+    // Breadth-first search over unvisited vertices, returns the last reached one
+    std::vector<size_t> stamp(n, 0);
+    std::vector<int> queue;
+    size_t search = 0;
+    std::vector<bool> visited(n, false);
+    auto farthest = [&](int start) {
+        search++;
+        queue.assign(1, start);
+        stamp[start] = search;
+        for (size_t head = 0; head < queue.size(); head++) {
+            int i = queue[head];
+            for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+                int j = col_idx[k];
+                if (!visited[j] && stamp[j] != search) {
+                    stamp[j] = search;
+                    queue.push_back(j);
+                }
+            }
+        }
+        return queue.back();
+    };
+
+    // Reverse Cuthill-McKee ordering, components started from pseudo-peripheral vertices
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [&degree](int i, int j) { return degree(i) < degree(j); });
+
+    std::vector<int> neighbours;
+    perm_.reserve(n);
+    for (int first : order) {
+        if (visited[first]) {
+            continue;
+        }
+        int start = farthest(farthest(first));
+        size_t head = perm_.size();
+        perm_.push_back(start);
+        visited[start] = true;
+        while (head < perm_.size()) {
+            int i = perm_[head++];
+            neighbours.clear();
+            for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+                int j = col_idx[k];
+                if (!visited[j]) {
+                    visited[j] = true;
+                    neighbours.push_back(j);
+                }
+            }
+            std::sort(neighbours.begin(), neighbours.end(),
+                [&degree](int i, int j) { return degree(i) < degree(j); });
+            perm_.insert(perm_.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+    std::reverse(perm_.begin(), perm_.end());
+
+    inverse_.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        inverse_[perm_[i]] = static_cast<int>(i);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            size_t d = std::abs(inverse_[i] - inverse_[col_idx[k]]);
+            band_ = std::max(band_, d);
+        }
+    }
+
+    // Lower triangle of the reordered matrix
+    l_.assign(n * (band_ + 1), 0.0);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; k++) {
+            size_t p = inverse_[i];
+            size_t q = inverse_[col_idx[k]];
+            if (q <= p) {
+                at(p, q) += values[k];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        size_t first = (i > band_) ? i - band_ : 0;
+        for (size_t j = first; j <= i; j++) {
+            double sum = at(i, j);
+            size_t from = std::max(first, (j > band_) ? j - band_ : 0);
+            for (size_t k = from; k < j; k++) {
+                sum -= at(i, k) * at(j, k);
+            }
+            if (i == j) {
+                if (sum <= 0.0) {
+                    return false;
+                }
+                at(i, i) = sqrt(sum);
+            }
+            else {
+                at(i, j) = sum / at(j, j);
+            }
+        }
+    }
+
+    return true;
+}
+
+void BandCholesky::solve(std::vector<double>& x) const {
+    const size_t n = perm_.size();
+    std::vector<double> y(n);
+    for (size_t i = 0; i < n; i++) {
+        y[i] = x[perm_[i]];
+    }
+
+    // Forward substitution with L
+    for (size_t i = 0; i < n; i++) {
+        size_t first = (i > band_) ? i - band_ : 0;
+        double sum = y[i];
+        for (size_t k = first; k < i; k++) {
+            sum -= at(i, k) * y[k];
+        }
+        y[i] = sum / at(i, i);
+    }
+
+    // Back substitution with transposed L
+    for (size_t i = n; i-- > 0;) {
+        y[i] /= at(i, i);
+        size_t first = (i > band_) ? i - band_ : 0;
+        for (size_t k = first; k < i; k++) {
+            y[k] -= at(i, k) * y[i];
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        x[perm_[i]] = y[i];
+    }
+}
+
+void BandCholesky::clear() {
+    perm_.clear();
+    inverse_.clear();
+    band_ = 0;
+    l_.clear();
 }
@@ -41,6 +41,11 @@ public:
         std::vector<T>::resize(rows * cols, v);
     }
 
+    void clear() {
+        rows_ = cols_ = 0;
+        std::vector<T>::clear();
+    }
+
     int rows() const { return rows_; }
     int cols() const { return cols_; }
 
@@ -64,7 +69,100 @@ private:
 using Vector = VectorT<float>;
 using Matrix = MatrixT<float>;
 
+// Matrix in compressed sparse row format
+struct SparseMatrix {
+    struct Triplet {
+        int row, col;
+        float value;
+    };
+
+    // Duplicate entries are summed up
+    static SparseMatrix from_triplets(size_t rows, size_t cols, std::vector<Triplet>& triplets);
+
+    void clear();
+
+    void multiply(const Vector& x, Vector& y) const;
+    SparseMatrix transpose() const;
+    Vector diagonal() const;
+
+    size_t nonzeros() const { return values.size(); }
+
+    size_t rows{ 0 }, cols{ 0 };
+    std::vector<size_t> row_ptr;
+    std::vector<int> col_idx;
+    std::vector<float> values;
+};
+
+SparseMatrix operator*(const SparseMatrix& a, const SparseMatrix& b);
+
+// LU decomposition with partial pivoting for repeated solves with one matrix
+class DenseLU {
+public:
+    DenseLU() = default;
+
+    bool factor(const Matrix& a);
+    void solve(const Vector& b, Vector& x) const;
+
+    void clear();
+
+private:
+    MatrixT<double> lu_;
+    std::vector<size_t> pivots_;
+};
+
+// Cholesky decomposition of a sparse symmetric positive definite matrix
+// stored as a band after reverse Cuthill-McKee reordering
+class BandCholesky {
+public:
+    BandCholesky() = default;
+
+    bool factor(const SparseMatrix& a);
+
+    // Compressed rows with values in double precision
+    bool factor(const std::vector<size_t>& row_ptr, const std::vector<int>& col_idx,
+        const std::vector<double>& values);
+
+    // Solves A*x=b in place, x holds b on entry
+    void solve(std::vector<double>& x) const;
+
+    void clear();
+
+    size_t size() const { return perm_.size(); }
+    size_t bandwidth() const { return band_; }
+
+private:
+    double& at(size_t i, size_t j) { return l_[i * (band_ + 1) + band_ + j - i]; }
+    double at(size_t i, size_t j) const { return l_[i * (band_ + 1) + band_ + j - i]; }
+
+private:
+    std::vector<int> perm_;     // New index to original index
+    std::vector<int> inverse_;  // Original index to new index
+    size_t band_{ 0 };
+    std::vector<double> l_;
+};
+
 std::ostream& operator<<(std::ostream& os, const Vector& v);
 std::ostream& operator<<(std::ostream& os, const Matrix& m);
 
-void seqv(Matrix& a, Vector& b, Vector& x, int N);
+// Receives completed fraction of the work, returns false to stop
+using ProgressFunc = std::function<bool(float fraction)>;
+
+// Returns false if stopped by the progress function
+bool seqv(Matrix& a, Vector& b, Vector& x, int N, const ProgressFunc& progress = nullptr);
+
+double dot(const Vector& a, const Vector& b);
+
+// Computes y = A*x for some linear operator A
+using LinearOperator = std::function<void(const Vector& x, Vector& y)>;
+
+struct IterativeResult {
+    int iterations{ 0 };
+    double residual{ 0.0 };
+    bool converged{ false };
+};
+
+// Preconditioned conjugate gradient method for symmetric positive definite A.
+// Vector x is used as the initial guess and receives the solution.
+IterativeResult cg(const LinearOperator& a, const Vector& b, Vector& x,
+    double tolerance, int max_iterations, const LinearOperator& precond = nullptr,
+    const ProgressFunc& progress = nullptr);
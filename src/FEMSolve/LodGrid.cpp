@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "LinAlgUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
+#include "FEM.h"
+#include "LodGrid.h"
+
+namespace LodParams {
+    // Number of cells along the larger side of the finest grid
+    constexpr int FinestCells = 1024;
+}
+
+void LodGrid::build(const FinitModel& model) {
+    using namespace LodParams;
+
+    clear();
+
+    const auto& nodes = model.nodes;
+    const auto& elems = model.elems;
+
+    // Level 0 keeps every node and element
+    Level exact;
+    exact.nodes.resize(nodes.size());
+    std::iota(exact.nodes.begin(), exact.nodes.end(), 0);
+    exact.elements.resize(elems.size());
+    std::iota(exact.elements.begin(), exact.elements.end(), 0);
+    for (const auto& e : elems) {
+        exact.edges.push_back({ e.nodes[0] - 1, e.nodes[1] - 1 });
+    }
+    levels_.push_back(std::move(exact));
+
+    if (nodes.empty()) {
+        return;
+    }
+
+    float xmin = nodes[0].x, xmax = nodes[0].x;
+    float ymin = nodes[0].y, ymax = nodes[0].y;
+    for (const auto& n : nodes) {
+        xmin = std::min(xmin, n.x);
+        xmax = std::max(xmax, n.x);
+        ymin = std::min(ymin, n.y);
+        ymax = std::max(ymax, n.y);
+    }
+    float extent = std::max(xmax - xmin, ymax - ymin);
+    if (extent == 0) {
+        return;
+    }
+
+    // Exact level is used for spacings below the finest grid
+    levels_.back().cell_size = extent / (2 * FinestCells);
+
+    std::unordered_map<uint64_t, int> cells;
+    std::unordered_set<uint64_t> edges;
+    std::vector<int> node_cell(nodes.size());
+
+    for (int count = FinestCells; count >= 1; count /= 2) {
+        Level level;
+        level.cell_size = extent / count;
+
+        const uint64_t side = static_cast<uint64_t>(count) + 1;
+        auto cell_key = [&](float x, float y) {
+            auto ix = static_cast<uint64_t>((x - xmin) / level.cell_size);
+            auto iy = static_cast<uint64_t>((y - ymin) / level.cell_size);
+            return std::min(ix, side - 1) * side + std::min(iy, side - 1);
+        };
+
+        // First node of a cell represents it
+        cells.clear();
+        for (size_t i = 0; i < nodes.size(); i++) {
+            auto it = cells.emplace(cell_key(nodes[i].x, nodes[i].y), static_cast<int>(i));
+            if (it.second) {
+                level.nodes.push_back(static_cast<int>(i));
+            }
+            node_cell[i] = it.first->second;
+        }
+
+        // Elements inside a cell disappear, parallel ones are merged
+        edges.clear();
+        for (const auto& e : elems) {
+            int a = node_cell[e.nodes[0] - 1];
+            int b = node_cell[e.nodes[1] - 1];
+            if (a == b) {
+                continue;
+            }
+            if (a > b) {
+                std::swap(a, b);
+            }
+            if (edges.insert(static_cast<uint64_t>(a) * nodes.size() + b).second) {
+                level.edges.push_back({ a, b });
+            }
+        }
+
+        cells.clear();
+        for (size_t i = 0; i < elems.size(); i++) {
+            const auto& n1 = nodes[elems[i].nodes[0] - 1];
+            const auto& n2 = nodes[elems[i].nodes[1] - 1];
+            if (cells.emplace(cell_key((n1.x + n2.x) * 0.5f, (n1.y + n2.y) * 0.5f),
+                    static_cast<int>(i)).second) {
+                level.elements.push_back(static_cast<int>(i));
+            }
+        }
+
+        // Coarser grid that merges nothing is the same as the previous level
+        const auto& prev = levels_.back();
+        if (level.nodes.size() == prev.nodes.size() &&
+            level.edges.size() == prev.edges.size() &&
+            level.elements.size() == prev.elements.size()) {
+            levels_.back().cell_size = level.cell_size;
+            continue;
+        }
+
+        levels_.push_back(std::move(level));
+    }
+}
+
+void LodGrid::clear() {
+    levels_.clear();
+}
+
+size_t LodGrid::select(float spacing) const {
+    for (size_t i = 0; i < levels_.size(); i++) {
+        if (levels_[i].cell_size >= spacing) {
+            return i;
+        }
+    }
+    return levels_.size() - 1;
+}
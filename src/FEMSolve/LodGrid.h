@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+ * Screen-space level of detail of a truss. Level 0 is the model itself. Every
+ * next level snaps nodes to a grid with two times larger cells and keeps one
+ * representative node per cell and one line per pair of connected cells.
+ */
+class LodGrid {
+public:
+    struct Level {
+        float cell_size{ 0 };
+        std::vector<int> nodes;                 // Representative nodes
+        std::vector<int> elements;              // Representative elements by their midpoints
+        std::vector<std::array<int, 2>> edges;  // Lines between representative nodes
+    };
+
+    LodGrid() = default;
+
+    void build(const FinitModel& model);
+    void clear();
+
+    // Finest level whose items are at least the spacing apart, in model units
+    size_t select(float spacing) const;
+
+    size_t levels() const { return levels_.size(); }
+    const Level& level(size_t i) const { return levels_[i]; }
+
+private:
+    std::vector<Level> levels_;
+};
@@ -1,7 +1,15 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
 #include "GraphicsUtils.h"
 #include "LinAlgUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
 #include "FEM.h"
+#include "SystemUtils.h"
+#include "LodGrid.h"
+#include "SpatialIndex.h"
 #include "ModelWidget.h"
 #include "MainWindow.h"
 
@@ -9,6 +17,12 @@
 
 constexpr auto FEMSOLVE_VERSION = "1.2";
 
+// Progress is passed to the UI thread not more often than this interval
+constexpr auto ProgressInterval = std::chrono::milliseconds(50);
+
+// Interval of memory usage updates in seconds
+constexpr double MemoryInterval = 0.5;
+
 MainWindow::MainWindow(int w, int h, const char* l)
     : Fl_Window(w, h, l) {
 
@@ -28,18 +42,40 @@ MainWindow::MainWindow(int w, int h, const char* l)
     report_dlg->end();
     report_dlg->set_non_modal();
 
+    // Progress window
+    progress_dlg = new Fl_Window(360, 120, "Solving");
+    progress_dlg->begin();
+
+    progress_label = new Fl_Box(10, 5, 340, 25);
+    progress_bar = new Fl_Progress(10, 30, 340, 25);
+    progress_bar->minimum(0);
+    progress_bar->maximum(1);
+    progress_bar->selection_color(FL_BLUE);
+    memory_label = new Fl_Box(10, 60, 340, 25);
+
+    auto cancel_btn = new Fl_Button(275, 90, 75, 23, "Cancel");
+    cancel_btn->callback(cancel_cb, static_cast<void*>(this));
+
+    progress_dlg->end();
+    progress_dlg->set_modal();
+
     // Main window
     begin();
 
     // Create main menu
     static const std::vector<Fl_Menu_Item> menu_items = {
         {"&File", 0, 0, 0, FL_SUBMENU},
-        {"&Open file...", FL_COMMAND + 'o', open_cb, static_cast<void*>(this), FL_MENU_DIVIDER},
-        {"E&xit", FL_COMMAND + 'x', exit_cb, 0},
+        {"&Open file...", FL_COMMAND + 'o', open_cb, static_cast<void*>(this)},
+        {"&Export image...", FL_COMMAND + 'e', export_cb, static_cast<void*>(this), FL_MENU_DIVIDER},
+        {"E&xit", FL_COMMAND + 'x', exit_cb, static_cast<void*>(this)},
         {0},
 
         {"&Solution", 0, 0, 0, FL_SUBMENU},
         {"Sol&ve", FL_COMMAND + 's', solve_cb, static_cast<void*>(this), FL_MENU_DIVIDER},
+        {"&Direct solver", 0, direct_method_cb, static_cast<void*>(this), FL_MENU_RADIO | FL_MENU_VALUE},
+        {"&Iterative solver", 0, iterative_method_cb, static_cast<void*>(this), FL_MENU_RADIO},
+        {"&Multigrid solver", 0, multigrid_method_cb, static_cast<void*>(this), FL_MENU_RADIO},
+        {"&Domain decomposition", 0, subdomain_method_cb, static_cast<void*>(this), FL_MENU_RADIO | FL_MENU_DIVIDER},
         {"Solution &report", FL_COMMAND + 'r', report_cb, static_cast<void*>(this)},
         {0},
 
@@ -64,6 +100,10 @@ MainWindow::MainWindow(int w, int h, const char* l)
     resizable(model_widget);
 }
 
+MainWindow::~MainWindow() {
+    stop_solve();
+}
+
 void MainWindow::open_cb(Fl_Widget*, void* p) {
     auto w = static_cast<MainWindow*>(p);
     w->open();
@@ -89,7 +129,43 @@ void MainWindow::open() {
     }
 }
 
-void MainWindow::exit_cb(Fl_Widget*, void*) {
+void MainWindow::export_cb(Fl_Widget*, void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->export_image();
+}
+
+void MainWindow::export_image() {
+    if (solving) {
+        return;
+    }
+
+    Fl_Native_File_Chooser fnfc;
+    fnfc.title("Export image");
+    fnfc.type(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
+    fnfc.filter("PNG\t*.png");
+    fnfc.options(Fl_Native_File_Chooser::SAVEAS_CONFIRM);
+    switch (fnfc.show()) {
+    case -1:
+        fl_message("Error selecting a file\n%s", fnfc.errmsg());
+        break;
+
+    case 1:
+        return;
+
+    default: {
+        Canvas canvas(model_widget->w(), model_widget->h());
+        model_widget->render(canvas);
+        if (!canvas.write_png(fnfc.filename())) {
+            fl_message("Unable to write image\n%s", fnfc.filename());
+        }
+        break;
+    }
+    }
+}
+
+void MainWindow::exit_cb(Fl_Widget*, void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->stop_solve();
     exit(0);
 }
 
@@ -99,7 +175,27 @@ void MainWindow::solve_cb(Fl_Widget*, void* p) {
 }
 
 void MainWindow::solve() {
-    solve_model();
+    start_solve();
+}
+
+void MainWindow::direct_method_cb(Fl_Widget*, void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->model.method = SolverMethod::Direct;
+}
+
+void MainWindow::iterative_method_cb(Fl_Widget*, void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->model.method = SolverMethod::ConjugateGradient;
+}
+
+void MainWindow::multigrid_method_cb(Fl_Widget*, void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->model.method = SolverMethod::Multigrid;
+}
+
+void MainWindow::subdomain_method_cb(Fl_Widget*, void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->model.method = SolverMethod::DomainDecomposition;
 }
 
 void MainWindow::report_cb(Fl_Widget*, void* p) {
@@ -121,21 +217,165 @@ void MainWindow::report_close() {
 }
 
 void MainWindow::load_model(const char* filename) {
+    if (solving) {
+        return;
+    }
+
     model.load_from_file(filename);
     model_widget->reload_model();
     model_widget->redraw();
 }
 
-void MainWindow::solve_model() {
-    model.prepare_solve();
+void MainWindow::start_solve() {
+    if (solving) {
+        return;
+    }
+
+    solving = true;
+    cancel_requested = false;
+    model_widget->show_results(false);
+    progress_stage.clear();
+    progress_fraction = 0;
+    progress_time = std::chrono::steady_clock::now();
+
+    progress_label->copy_label("Starting");
+    progress_bar->value(0);
+    update_memory();
+    progress_dlg->show();
+    Fl::add_timeout(MemoryInterval, memory_timeout_cb, static_cast<void*>(this));
+
+    model.progress = [this](const char* stage, float fraction) {
+        return solve_progress(stage, fraction);
+    };
+
+    solver_thread = std::thread([this]() {
+        solve_completed = model.prepare_solve();
+        if (solve_completed) {
+            std::cout << "A : " << std::endl;
+            std::cout << model.a << std::endl << std::endl;
+
+            std::cout << "B : " << std::endl;
+            std::cout << model.b << std::endl << std::endl;
+
+            solve_completed = model.solve();
+        }
+        Fl::awake(solve_done_cb, static_cast<void*>(this));
+    });
+}
+
+void MainWindow::stop_solve() {
+    cancel_requested = true;
+    if (solver_thread.joinable()) {
+        solver_thread.join();
+    }
+}
 
-    std::cout << "A : " << std::endl;
-    std::cout << model.a << std::endl << std::endl;
+bool MainWindow::solve_progress(const char* stage, float fraction) {
+    auto now = std::chrono::steady_clock::now();
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        if (progress_stage != stage || now - progress_time >= ProgressInterval) {
+            progress_stage = stage;
+            progress_fraction = fraction;
+            progress_time = now;
+            notify = true;
+        }
+    }
+    if (notify) {
+        Fl::awake(progress_awake_cb, static_cast<void*>(this));
+    }
+    return !cancel_requested;
+}
+
+void MainWindow::progress_awake_cb(void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->update_progress();
+}
 
-    std::cout << "B : " << std::endl;
-    std::cout << model.b << std::endl << std::endl;
+void MainWindow::update_progress() {
+    std::string stage;
+    float fraction{ 0 };
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        stage = progress_stage;
+        fraction = progress_fraction;
+    }
 
-    model.solve();
+    constexpr size_t BufferLen = 256;
+    char str[BufferLen] = { 0 };
+    snprintf(str, BufferLen-1, "%s: %.0f%%", stage.c_str(), fraction * 100.0f);
+    progress_label->copy_label(str);
+    progress_bar->value(fraction);
+}
+
+void MainWindow::memory_timeout_cb(void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->update_memory();
+    if (w->solving) {
+        Fl::repeat_timeout(MemoryInterval, memory_timeout_cb, p);
+    }
+}
+
+void MainWindow::update_memory() {
+    constexpr size_t BufferLen = 256;
+    char str[BufferLen] = { 0 };
+    size_t memory = ResidentMemorySize();
+    if (memory > 0) {
+        snprintf(str, BufferLen-1, "Memory: %.1f MB", memory / (1024.0 * 1024.0));
+    }
+    else {
+        snprintf(str, BufferLen-1, "Memory: n/a");
+    }
+    memory_label->copy_label(str);
+}
+
+void MainWindow::cancel_cb(Fl_Widget*, void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->cancel();
+}
+
+void MainWindow::cancel() {
+    cancel_requested = true;
+    progress_label->copy_label("Cancelling");
+}
+
+void MainWindow::solve_done_cb(void* p) {
+    auto w = static_cast<MainWindow*>(p);
+    w->solve_done();
+}
+
+void MainWindow::solve_done() {
+    if (solver_thread.joinable()) {
+        solver_thread.join();
+    }
+    solving = false;
+    model.progress = nullptr;
+
+    Fl::remove_timeout(memory_timeout_cb, static_cast<void*>(this));
+    progress_dlg->hide();
+
+    if (!solve_completed) {
+        buffer->select(0, buffer->length());
+        buffer->remove_selection();
+        fl_message("Solution is cancelled");
+        return;
+    }
+
+    model_widget->show_results(true);
+    report_solution();
+}
+
+void MainWindow::report_solution() {
+    if (model.method == SolverMethod::DomainDecomposition) {
+        std::cout << "Subdomains : " << model.subdomains.parts()
+            << ", workers : " << model.subdomains.workers()
+            << ", interface DOFs : " << model.subdomains.interface_size() << std::endl << std::endl;
+    }
+    else if (model.method != SolverMethod::Direct) {
+        std::cout << "CG iterations : " << model.solver_result.iterations
+            << ", residual : " << model.solver_result.residual << std::endl << std::endl;
+    }
 
     std::cout << "U : " << std::endl;
     std::cout << model.u << std::endl << std::endl;
@@ -151,6 +391,26 @@ void MainWindow::solve_model() {
     constexpr size_t BufferLen = 256;
     char str[BufferLen] = { 0 };
 
+    if (model.method == SolverMethod::DomainDecomposition) {
+        snprintf(str, BufferLen-1, "Domain decomposition: %zu subdomains in %zu workers, %zu interface DOFs%s\n\n",
+            model.subdomains.parts(), model.subdomains.workers(), model.subdomains.interface_size(),
+            model.solver_result.converged ? "" : " (failed)");
+        buffer->append(str);
+    }
+    else if (model.method != SolverMethod::Direct) {
+        snprintf(str, BufferLen-1, "Conjugate gradient: %d iterations, residual %12.4e%s\n",
+            model.solver_result.iterations, model.solver_result.residual,
+            model.solver_result.converged ? "" : " (not converged)");
+        buffer->append(str);
+        if (model.method == SolverMethod::Multigrid) {
+            snprintf(str, BufferLen-1, "Multigrid: %zu levels, coarse size %zu, complexity %.2f%s\n",
+                model.amg.levels(), model.amg.coarse_size(), model.amg.operator_complexity(),
+                model.amg.coarse_direct() ? "" : " (singular coarse level, Jacobi)");
+            buffer->append(str);
+        }
+        buffer->append("\n");
+    }
+
     buffer->append("Node displacements:\n");
     for (int i = 0; i < model.nodes.size(); i++) {
         int node = model.nodes[i].node;
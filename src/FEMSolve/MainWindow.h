@@ -3,19 +3,36 @@
 class MainWindow : public Fl_Window {
 public:
     MainWindow(int w, int h, const char* l = nullptr);
+    ~MainWindow();
 
 private:
     void load_model(const char* filename);
-    void solve_model();
+
+    // Solution runs on a worker thread, results are passed back with Fl::awake
+    void start_solve();
+    void stop_solve();
+    void report_solution();
+
+    // Called from the worker thread
+    bool solve_progress(const char* stage, float fraction);
 
     static void open_cb(Fl_Widget*, void*);
     void open();
 
+    // Scene with results is rasterised on the CPU at the widget size
+    static void export_cb(Fl_Widget*, void*);
+    void export_image();
+
     static void exit_cb(Fl_Widget*, void*);
 
     static void solve_cb(Fl_Widget*, void*);
     void solve();
 
+    static void direct_method_cb(Fl_Widget*, void*);
+    static void iterative_method_cb(Fl_Widget*, void*);
+    static void multigrid_method_cb(Fl_Widget*, void*);
+    static void subdomain_method_cb(Fl_Widget*, void*);
+
     static void report_cb(Fl_Widget*, void*);
     void report();
 
@@ -24,6 +41,18 @@ private:
 
     static void about_cb(Fl_Widget*, void*);
 
+    static void cancel_cb(Fl_Widget*, void*);
+    void cancel();
+
+    static void progress_awake_cb(void*);
+    void update_progress();
+
+    static void solve_done_cb(void*);
+    void solve_done();
+
+    static void memory_timeout_cb(void*);
+    void update_memory();
+
 private:
     FinitModel model;
 
@@ -31,4 +60,20 @@ private:
 
     Fl_Window* report_dlg{ nullptr };
     Fl_Text_Buffer* buffer{ nullptr };
+
+    Fl_Window* progress_dlg{ nullptr };
+    Fl_Box* progress_label{ nullptr };
+    Fl_Progress* progress_bar{ nullptr };
+    Fl_Box* memory_label{ nullptr };
+
+    std::thread solver_thread;
+    std::atomic<bool> solving{ false };
+    std::atomic<bool> cancel_requested{ false };
+    bool solve_completed{ false };
+
+    // Latest progress of the worker thread
+    std::mutex progress_mutex;
+    std::string progress_stage;
+    float progress_fraction{ 0 };
+    std::chrono::steady_clock::time_point progress_time;
 };
@@ -1,7 +1,14 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
 #include "LinAlgUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
 #include "FEM.h"
 #include "GraphicsUtils.h"
+#include "LodGrid.h"
+#include "SpatialIndex.h"
 #include "ModelWidget.h"
 
 const Fl_Color TitleColor = fl_rgb_color(255);
@@ -10,14 +17,28 @@ const Fl_Color ElementColor = fl_rgb_color(0, 255, 255);
 const Fl_Color TextColor = fl_rgb_color(255, 0, 255);
 const Fl_Color NodeColor = fl_rgb_color(255);
 const Fl_Color ForceColor = fl_rgb_color(255, 165, 0);
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-#define SET_FL_COLOR_TO_GL(c) { \
-    GLubyte r, g, b, a; \
-    Fl::get_color((c), r, g, b, a); \
-    glColor4ub(r, g, b, a); \
-    }
-#endif
+const Fl_Color SelectionColor = fl_rgb_color(255, 255, 0);
+
+// Diverging colors from compression (blue) through zero (white) to tension (red)
+const std::array<std::array<unsigned char, 3>, 256>& ForceColors() {
+    static const auto colors = [] {
+        constexpr float Compression[3] = { 59, 76, 192 };
+        constexpr float Zero[3] = { 221, 221, 221 };
+        constexpr float Tension[3] = { 180, 4, 38 };
+
+        std::array<std::array<unsigned char, 3>, 256> lut;
+        for (size_t i = 0; i < lut.size(); i++) {
+            float t = static_cast<float>(i) / (lut.size() - 1) * 2.0f - 1.0f;
+            const float* end = (t < 0) ? Compression : Tension;
+            float a = std::fabs(t);
+            for (int k = 0; k < 3; k++) {
+                lut[i][k] = static_cast<unsigned char>(Zero[k] + (end[k] - Zero[k]) * a);
+            }
+        }
+        return lut;
+    }();
+    return colors;
+}
 
 ModelWidget::ModelWidget(int X, int Y, int W, int H, FinitModel& model, const char* l)
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
@@ -26,23 +47,6 @@ ModelWidget::ModelWidget(int X, int Y, int W, int H, FinitModel& model, const ch
     : Fl_Widget(X, Y, W, H, l)
 #endif
     , model_(model) {
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    xFunc = [=](float x) -> float {
-        return x;
-    };
-    yFunc = [=](float y) -> float {
-        return y;
-    };
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    xFunc = [=](float x) -> float {
-        return (x - this->xmin_) / this->pixelX_;
-    };
-    yFunc = [=](float y) -> float {
-        return (this->ymax_ - y) / this->pixelY_;
-    };
-#endif
-
     update_size();
 }
 
@@ -71,7 +75,8 @@ void ModelWidget::reload_model() {
         xmax_ = XMax;
         ymin_ = YMin;
         ymax_ = YMax;
-        this->redraw();
+        build_batches();
+        refresh();
         return;
     }
 
@@ -100,11 +105,152 @@ void ModelWidget::reload_model() {
     ymax_ = ymax + ymargin;
 
     update_size();
+    build_batches();
+
+#if DRAW_METHOD==DRAW_METHOD_OPENGL
+    // Projection depends on the model extents
+    this->invalidate();
+#endif
+    refresh();
+}
 
+void ModelWidget::refresh() {
+#if DRAW_METHOD==DRAW_METHOD_FLTK
+    sceneValid_ = false;
+#endif
     this->redraw();
 }
 
+void ModelWidget::build_batches() {
+    using namespace PlotDefaults;
+
+    lod_.build(model_);
+    index_.build(model_);
+    selectedNode_ = -1;
+    selectedElement_ = -1;
+    showResults_ = false;
+
+    elements_.clear();
+    nodes_.clear();
+    for (size_t i = 0; i < lod_.levels(); i++) {
+        const auto& level = lod_.level(i);
+
+        elements_.emplace_back(PrimitiveType::Lines);
+        elements_.back().set_color(ElementColor);
+        for (const auto& edge : level.edges) {
+            const Node& n1 = model_.nodes[edge[0]];
+            const Node& n2 = model_.nodes[edge[1]];
+            elements_.back().add_line(n1.x, n1.y, n2.x, n2.y);
+        }
+
+        nodes_.emplace_back(PrimitiveType::Quads);
+        nodes_.back().set_color(NodeColor);
+        for (int node : level.nodes) {
+            const Node& n = model_.nodes[node];
+            nodes_.back().add_rectangle(n.x - xsize_ * NodeSize, n.y - ysize_ * NodeSize,
+                n.x + xsize_ * NodeSize, n.y + ysize_ * NodeSize);
+        }
+    }
+
+    fixes_.clear();
+    fixes_.set_color(FixedColor);
+    for (const auto& f : model_.fixes) {
+        const Node& n = model_.nodes[f.node - 1];
+        if (f.axis == 1) {
+            // X
+            fixes_.add_triangle(n.x, n.y,
+                n.x - xsize_ * FixSize, n.y + ysize_ * FixSize2,
+                n.x - xsize_ * FixSize, n.y - ysize_ * FixSize2);
+        }
+        else if (f.axis == 2) {
+            // Y
+            fixes_.add_triangle(n.x, n.y,
+                n.x - xsize_ * FixSize2, n.y - ysize_ * FixSize,
+                n.x + xsize_ * FixSize2, n.y - ysize_ * FixSize);
+        }
+    }
+
+    // Forces and loads
+    loads_.clear();
+    loadHeads_.clear();
+    loads_.set_color(ForceColor);
+    loadHeads_.set_color(ForceColor);
+    for (const auto& l : model_.loads) {
+        const Node& n = model_.nodes[l.node - 1];
+        double angle = atan2(l.py, l.px);
+        float cosa = cos(angle);
+        float sina = sin(angle);
+
+        float dx = xsize_ * ForceSize * cosa;
+        float dy = ysize_ * ForceSize * sina;
+        loads_.add_line(n.x - dx, n.y - dy, n.x, n.y);
+
+        // Arrow head points to the node
+        float hx = dx * ArrowSize;
+        float hy = dy * ArrowSize;
+        loadHeads_.add_triangle(n.x, n.y,
+            n.x - hx - hy, n.y - hy + hx,
+            n.x - hx + hy, n.y - hy - hx);
+    }
+}
+
+void ModelWidget::build_results() {
+    using namespace PlotDefaults;
+
+    deformed_.clear();
+    colorBar_.clear();
+    forceRange_ = 0;
+
+    size_t count = model_.nodes.size() * ModelDimensions;
+    if (model_.u.size() < count || model_.n.size() < model_.elems.size()) {
+        return;
+    }
+
+    // Largest displacement is drawn as a fixed part of the model size
+    float umax = 0;
+    for (size_t i = 0; i < count; i++) {
+        umax = std::max(umax, std::fabs(model_.u[i]));
+    }
+    float scale = (umax > 0) ? DeformedSize * std::max(xsize_, ysize_) / umax : 0;
+
+    // Colors of all elements are looked up in one pass over the forces
+    for (size_t i = 0; i < model_.elems.size(); i++) {
+        forceRange_ = std::max(forceRange_, std::fabs(model_.n[i]));
+    }
+    const auto& colors = ForceColors();
+    const float lutScale = (forceRange_ > 0) ? (colors.size() - 1) * 0.5f / forceRange_ : 0;
+    const float lutMiddle = (colors.size() - 1) * 0.5f;
+
+    for (size_t i = 0; i < model_.elems.size(); i++) {
+        const Element& e = model_.elems[i];
+        const Node& n1 = model_.nodes[e.nodes[0] - 1];
+        const Node& n2 = model_.nodes[e.nodes[1] - 1];
+        int k1 = (n1.node - 1) * 2;
+        int k2 = (n2.node - 1) * 2;
+
+        const auto& c = colors[static_cast<size_t>(lutMiddle + model_.n[i] * lutScale + 0.5f)];
+        deformed_.set_color(c[0], c[1], c[2]);
+        deformed_.add_line(n1.x + model_.u[k1] * scale, n1.y + model_.u[k1 + 1] * scale,
+            n2.x + model_.u[k2] * scale, n2.y + model_.u[k2 + 1] * scale);
+    }
+
+    // Color bar from the largest compression on the left to the largest tension
+    float x1 = (xmin_ + xmax_) * 0.5f;
+    float x2 = xmax_ - xsize_ * Margin;
+    float y1 = ymin_ + ysize_ * Margin * 0.35f;
+    float y2 = y1 + ysize_ * ColorBarHeight;
+    for (int i = 0; i < ColorBarSteps; i++) {
+        size_t j = static_cast<size_t>((i + 0.5f) / ColorBarSteps * colors.size());
+        const auto& c = colors[j];
+        colorBar_.set_color(c[0], c[1], c[2]);
+        colorBar_.add_rectangle(x1 + (x2 - x1) * i / ColorBarSteps, y1,
+            x1 + (x2 - x1) * (i + 1) / ColorBarSteps, y2);
+    }
+}
+
 void ModelWidget::draw() {
+    auto start = std::chrono::steady_clock::now();
+
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
     if (!this->valid()) {
         glViewport(0, 0, this->w(), this->h());
@@ -127,150 +273,232 @@ void ModelWidget::draw() {
     if (!initOffscreen_) {
         initOffscreen_ = true;
         offscreen_ = fl_create_offscreen(this->w(), this->h());
+        sceneValid_ = false;
     }
 #endif
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
+
+    draw_scene();
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_begin_offscreen(offscreen_);
+    // Scene is kept in the offscreen buffer until the model or size changes
+    if (!sceneValid_) {
+        fl_begin_offscreen(offscreen_);
 
-    fl_color(fl_rgb_color(0));
-    fl_rectf(0, 0, this->w(), this->h());
-#endif
+        fl_color(fl_rgb_color(0));
+        fl_rectf(0, 0, this->w(), this->h());
 
-    draw_legend();
-    draw_elements();
-    draw_fixes();
-    draw_nodes();
-    draw_loads();
+        draw_scene();
 
-#if DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_end_offscreen();
+        fl_end_offscreen();
+        sceneValid_ = true;
+    }
 
     fl_copy_offscreen(this->x(), this->y(), this->w(), this->h(),
         offscreen_, 0, 0);
 #endif
-}
 
-void ModelWidget::draw_legend() {
-    using namespace PlotDefaults;
+    draw_frame_time();
 
-    // Print model title
+    // Exponential moving average of frame times
+    constexpr double FrameTimeSmoothing = 0.1;
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    frameTime_ = (frameTime_ == 0) ? elapsed.count() :
+        frameTime_ + (elapsed.count() - frameTime_) * FrameTimeSmoothing;
+}
+
+void ModelWidget::draw_scene() {
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(TitleColor);
+    // Model coordinates are set by the projection
+    ScreenPainter painter([](double x) { return x; }, [](double y) { return y; });
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(TitleColor);
+    ScreenPainter painter(PlotToPixelX(xmin_, pixelX_, 0), PlotToPixelY(ymax_, pixelY_, 0));
 #endif
-    PrintText(largeFont,
-        xFunc(xmin_ + xsize_ * TextMargin * 1.5),
-        yFunc(ymax_ - ysize_ * TextMargin * 1.5),
-        "TITLE: %s", model_.title.c_str());
+    paint_scene(painter, std::max(pixelX_, pixelY_));
+    draw_selection(painter);
 }
 
-void ModelWidget::draw_elements() {
+void ModelWidget::paint_scene(Painter& painter, float pixel) const {
     using namespace PlotDefaults;
 
-    for (int i = 0; i < model_.elems.size(); i++) {
-        Element e = model_.elems[i];
-        Node n1 = model_.nodes[e.nodes[0] - 1], n2 = model_.nodes[e.nodes[1] - 1];
+    // Print model title
+    painter.set_color(TitleColor);
+    painter.set_text_size(LargeTextSize);
+    painter.text(xmin_ + xsize_ * TextMargin * 1.5f, ymax_ - ysize_ * TextMargin * 1.5f, 0,
+        "TITLE: %s", model_.title.c_str());
+    painter.set_text_size(NormalTextSize);
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        SET_FL_COLOR_TO_GL(ElementColor);
-        glLineWidth(1.0);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_color(ElementColor);
-        fl_line_style(FL_SOLID, 1);
-#endif
-        DrawLine(
-            xFunc(n1.x), yFunc(n1.y),
-            xFunc(n2.x), yFunc(n2.y));
+    if (lod_.levels() == 0) {
+        return;
+    }
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        SET_FL_COLOR_TO_GL(TextColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_color(TextColor);
-#endif
-        PrintText(normalFont,
-            xFunc((n1.x + n2.x) * 0.5 - xsize_ * TextMargin),
-            yFunc((n1.y + n2.y) * 0.5 + ysize_ * TextMargin),
-            "%d", e.elem);
+    // Levels of detail are chosen so that drawn items are apart on the screen
+    float nodeSize = 2.0f * std::max(xsize_, ysize_) * NodeSize;
+    size_t lineLevel = lod_.select(pixel * LineSpacing);
+    size_t nodeLevel = lod_.select(std::max(nodeSize, pixel * LineSpacing));
+    size_t labelLevel = lod_.select(pixel * LabelSpacing);
+
+    painter.set_line_width(1);
+    elements_[lineLevel].draw(painter);
+    fixes_.draw(painter);
+    nodes_[nodeLevel].draw(painter);
+
+    painter.set_line_width(3);
+    loads_.draw(painter);
+    loadHeads_.draw(painter);
+
+    if (showResults_) {
+        painter.set_line_width(2);
+        deformed_.draw(painter);
+    }
+    painter.set_line_width(1);
+
+    if (showResults_) {
+        colorBar_.draw(painter);
+        painter.set_color(TitleColor);
+        float y = ymin_ + ysize_ * Margin * 0.1f;
+        painter.text((xmin_ + xmax_) * 0.5f, y, 0, "%.3e", -forceRange_);
+        painter.text((xmin_ + 3.0f * xmax_) * 0.25f - xsize_ * Margin * 0.5f, y, 0, "0");
+        painter.text(xmax_ - xsize_ * Margin, y, 0, "%.3e", forceRange_);
+    }
+
+    painter.set_color(TextColor);
+    for (int i : lod_.level(labelLevel).elements) {
+        const Element& e = model_.elems[i];
+        const Node& n1 = model_.nodes[e.nodes[0] - 1];
+        const Node& n2 = model_.nodes[e.nodes[1] - 1];
+        painter.text((n1.x + n2.x) * 0.5f - xsize_ * TextMargin,
+            (n1.y + n2.y) * 0.5f + ysize_ * TextMargin, 0, "%d", e.elem);
+    }
+    for (int i : lod_.level(labelLevel).nodes) {
+        const Node& n = model_.nodes[i];
+        painter.text(n.x - xsize_ * (NodeSize + TextMargin),
+            n.y - ysize_ * (NodeSize + TextMargin), 0, "%d", n.node);
     }
 }
 
-void ModelWidget::draw_fixes() {
+void ModelWidget::draw_frame_time() {
     using namespace PlotDefaults;
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(FixedColor);
+    ScreenPainter painter([](double x) { return x; }, [](double y) { return y; });
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(FixedColor);
+    // Drawn over the cached scene in window coordinates
+    ScreenPainter painter(PlotToPixelX(xmin_, pixelX_, this->x()),
+        PlotToPixelY(ymax_, pixelY_, this->y()));
 #endif
-    for (int i = 0; i < model_.fixes.size(); i++) {
-        Fixture f = model_.fixes[i];
-        Node n = model_.nodes[f.node - 1];
-        if (f.axis == 1) {
-            // X
-            DrawTriangle(xFunc(n.x), yFunc(n.y),
-                xFunc(n.x - xsize_ * FixSize), yFunc(n.y + ysize_ * FixSize2),
-                xFunc(n.x - xsize_ * FixSize), yFunc(n.y - ysize_ * FixSize2));
+    painter.set_color(TitleColor);
+    painter.set_text_size(NormalTextSize);
+    painter.text(xmin_ + xsize_ * TextMargin * 1.5, ymin_ + ysize_ * TextMargin * 1.5, 0,
+        "Frame: %.1f ms", frameTime_);
+}
+
+void ModelWidget::draw_selection(Painter& painter) const {
+    using namespace PlotDefaults;
+
+    constexpr size_t BufferLen = 256;
+    char str[BufferLen] = { 0 };
+
+    if (selectedNode_ >= 0) {
+        const Node& n = model_.nodes[selectedNode_];
+        int k = (n.node - 1) * 2;
+        if (showResults_ && static_cast<size_t>(k + 1) < model_.u.size()) {
+            snprintf(str, BufferLen - 1, "Node %d (%g, %g): U = (%.4e, %.4e)",
+                n.node, n.x, n.y, model_.u(k), model_.u(k + 1));
         }
-        else if (f.axis == 2) {
-            // Y
-            DrawTriangle(xFunc(n.x), yFunc(n.y),
-                xFunc(n.x - xsize_ * FixSize2), yFunc(n.y - ysize_ * FixSize),
-                xFunc(n.x + xsize_ * FixSize2), yFunc(n.y - ysize_ * FixSize));
+        else {
+            snprintf(str, BufferLen - 1, "Node %d (%g, %g)", n.node, n.x, n.y);
+        }
+    }
+    else if (selectedElement_ >= 0) {
+        const Element& e = model_.elems[selectedElement_];
+        if (showResults_ && static_cast<size_t>(selectedElement_) < model_.n.size()) {
+            snprintf(str, BufferLen - 1, "Element %d (%d-%d): N = %.4e",
+                e.elem, e.nodes[0], e.nodes[1], model_.n(selectedElement_));
+        }
+        else {
+            snprintf(str, BufferLen - 1, "Element %d (%d-%d), L = %g",
+                e.elem, e.nodes[0], e.nodes[1], e.length);
         }
     }
+    else {
+        return;
+    }
+
+    painter.set_color(SelectionColor);
+    painter.set_line_width(3);
+    if (selectedNode_ >= 0) {
+        const Node& n = model_.nodes[selectedNode_];
+        float dx = xsize_ * NodeSize * 2;
+        float dy = ysize_ * NodeSize * 2;
+        painter.rectangle(n.x - dx, n.y - dy, n.x + dx, n.y + dy);
+    }
+    else {
+        const Element& e = model_.elems[selectedElement_];
+        const Node& n1 = model_.nodes[e.nodes[0] - 1];
+        const Node& n2 = model_.nodes[e.nodes[1] - 1];
+        painter.line(n1.x, n1.y, n2.x, n2.y);
+    }
+    painter.set_line_width(1);
+
+    painter.text(xmin_ + xsize_ * TextMargin * 1.5, ymin_ + ysize_ * TextMargin * 4.0, 0,
+        "%s", str);
+}
+
+void ModelWidget::show_results(bool show) {
+    showResults_ = show;
+    if (show) {
+        build_results();
+    }
+    refresh();
+}
+
+void ModelWidget::render(Canvas& canvas) const {
+    if (canvas.width() <= 0 || canvas.height() <= 0) {
+        return;
+    }
+
+    float pixelX = (xmax_ - xmin_) / canvas.width();
+    float pixelY = (ymax_ - ymin_) / canvas.height();
+
+    canvas.clear({ 0, 0, 0, 255 });
+
+    CanvasPainter painter(canvas, PlotToPixelX(xmin_, pixelX, 0), PlotToPixelY(ymax_, pixelY, 0));
+    paint_scene(painter, std::max(pixelX, pixelY));
 }
 
-void ModelWidget::draw_nodes() {
+bool ModelWidget::pick(int x, int y) {
     using namespace PlotDefaults;
 
-    for (int i = 0; i < model_.nodes.size(); i++) {
-        Node n = model_.nodes[i];
+    // Widget point in model coordinates
+    float mx = xmin_ + x * pixelX_;
+    float my = ymax_ - y * pixelY_;
+    float radius = PickRadius * std::max(pixelX_, pixelY_);
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        SET_FL_COLOR_TO_GL(NodeColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_color(NodeColor);
-#endif
-        DrawRectangle(xFunc(n.x - xsize_ * NodeSize), yFunc(n.y - ysize_ * NodeSize),
-            xFunc(n.x + xsize_ * NodeSize), yFunc(n.y + ysize_ * NodeSize));
+    selectedNode_ = index_.nearest_node(mx, my, radius);
+    selectedElement_ = (selectedNode_ < 0) ? index_.nearest_element(mx, my, radius) : -1;
+    refresh();
 
+    return selectedNode_ >= 0 || selectedElement_ >= 0;
+}
+
+int ModelWidget::handle(int event) {
+    if (event == FL_PUSH && Fl::event_button() == FL_LEFT_MOUSE) {
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
-        SET_FL_COLOR_TO_GL(TextColor);
+        pick(Fl::event_x(), Fl::event_y());
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_color(TextColor);
+        pick(Fl::event_x() - this->x(), Fl::event_y() - this->y());
 #endif
-        PrintText(normalFont,
-            xFunc(n.x - xsize_ * (NodeSize + TextMargin)),
-            yFunc(n.y - ysize_ * (NodeSize + TextMargin)),
-            "%d", n.node);
+        return 1;
     }
-}
 
-void ModelWidget::draw_loads() {
-    using namespace PlotDefaults;
-
-    // Forces and loads
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(ForceColor);
-    glLineWidth(3.0);
+    return Fl_Gl_Window::handle(event);
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(ForceColor);
-    fl_line_style(FL_SOLID, 3);
+    return Fl_Widget::handle(event);
 #endif
-    for (int i = 0; i < model_.loads.size(); i++) {
-        Load l = model_.loads[i];
-        Node n = model_.nodes[l.node - 1];
-        double angle = atan2(l.py, l.px);
-        float cosa = cos(angle);
-        float sina = sin(angle);
-        DrawArrow(xFunc(n.x - xsize_ * ForceSize * cosa), yFunc(n.y - ysize_ * ForceSize * sina),
-            xFunc(n.x), yFunc(n.y));
-    }
 }
 
 void ModelWidget::update_size() {
@@ -279,11 +507,12 @@ void ModelWidget::update_size() {
     pixelY_ = (ymax_ - ymin_) / static_cast<float>(this->h());
 
 #if DRAW_METHOD==DRAW_METHOD_FLTK
+    // Offscreen buffer is created on the next draw, so a widget that is never
+    // shown renders to the canvas without a display
     if (initOffscreen_) {
         fl_delete_offscreen(offscreen_);
+        initOffscreen_ = false;
     }
-
-    offscreen_ = fl_create_offscreen(this->w(), this->h());
-    initOffscreen_ = true;
+    sceneValid_ = false;
 #endif
 }
@@ -13,8 +13,29 @@ namespace PlotDefaults {
     constexpr float FixSize = 0.05;
     constexpr float FixSize2 = FixSize / 2.0;
     constexpr float ForceSize = 0.15;
+    constexpr float ArrowSize = 0.2;
+
+    // Minimal distances between drawn items in pixels
+    constexpr float LineSpacing = 1.0;
+    constexpr float LabelSpacing = 40.0;
+
+    // Largest distance from the cursor to a picked item in pixels
+    constexpr float PickRadius = 6.0;
+
+    // Largest displacement of the deformed shape relative to the model size
+    constexpr float DeformedSize = 0.1;
+
+    // Force color bar in the bottom margin relative to the model size
+    constexpr float ColorBarHeight = 0.03;
+    constexpr int ColorBarSteps = 32;
+
+    // Text sizes of the scene in pixels
+    constexpr int NormalTextSize = 12;
+    constexpr int LargeTextSize = 18;
 }
 
+class Painter;
+
 class ModelWidget :
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
     public Fl_Gl_Window {
@@ -28,15 +49,39 @@ public:
     void resize(int x, int y, int w, int h) FL_OVERRIDE;
 
     void draw() FL_OVERRIDE;
+    int handle(int event) FL_OVERRIDE;
 
     void reload_model();
 
+    // Redraws the whole scene, also when it is cached
+    void refresh();
+
+    // Displacements and forces of picked items are shown only for a valid solution
+    void show_results(bool show);
+
+    // Draws the scene with results into an image of the canvas size
+    void render(Canvas& canvas) const;
+
+    // Selects the node or element under the widget point, returns true if found
+    bool pick(int x, int y);
+
+    // Average time of draw() in milliseconds
+    double frame_time() const { return frameTime_; }
+
 private:
-    void draw_legend();
-    void draw_elements();
-    void draw_fixes();
-    void draw_nodes();
-    void draw_loads();
+    // Vertex arrays are built once per model
+    void build_batches();
+
+    // Deformed shape and per-element force colors from the solution
+    void build_results();
+
+    // Scene shared by the screen and rendered images: levels of detail,
+    // layers, line widths and labels
+    void paint_scene(Painter& painter, float pixel) const;
+
+    void draw_scene();
+    void draw_selection(Painter& painter) const;
+    void draw_frame_time();
 
     void update_size();
 
@@ -47,16 +92,30 @@ private:
     float xsize_{ 0 }, ysize_{ 0 };
     float pixelX_{ 0 }, pixelY_{ 0 };
 
-    CoordinateFunc xFunc, yFunc;
+    // Elements and nodes for every level of detail
+    LodGrid lod_;
+    std::vector<PrimitiveBatch> elements_;
+    std::vector<PrimitiveBatch> nodes_;
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    void* normalFont{ GLUT_BITMAP_HELVETICA_12 };
-    void* largeFont{ GLUT_BITMAP_HELVETICA_18 };
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
+    // Index for picking, built with the batches
+    SpatialIndex index_;
+    int selectedNode_{ -1 };
+    int selectedElement_{ -1 };
+    bool showResults_{ false };
+
+    PrimitiveBatch fixes_{ PrimitiveType::Triangles };
+    PrimitiveBatch loads_{ PrimitiveType::Lines };
+    PrimitiveBatch loadHeads_{ PrimitiveType::Triangles };
+
+    PrimitiveBatch deformed_{ PrimitiveType::Lines };
+    PrimitiveBatch colorBar_{ PrimitiveType::Quads };
+    float forceRange_{ 0 };
+
+    double frameTime_{ 0 };
+
+#if DRAW_METHOD==DRAW_METHOD_FLTK
     bool initOffscreen_{ false };
+    bool sceneValid_{ false };
     Fl_Offscreen offscreen_;
-
-    int normalFont{ 12 };
-    int largeFont{ 18 };
 #endif
 };
@@ -0,0 +1,504 @@
+#include "pch.h"
+#include "LinAlgUtils.h"
+#include "Multigrid.h"
+
+namespace AmgParams {
+    // Hierarchy stops when the level is small enough for a dense solve
+    constexpr size_t CoarseSize = 300;
+    constexpr size_t MaxLevels = 12;
+
+    // Stop if the coarsening is slower than this ratio
+    constexpr double MinCoarsening = 0.8;
+
+    // Threshold of strong connection between nodes
+    constexpr double StrengthThreshold = 0.08;
+
+    // Prolongator smoothing weight is Omega / rho(D^-1 A)
+    constexpr double Omega = 4.0 / 3.0;
+    constexpr int PowerIterations = 15;
+
+    // Damped Jacobi replaces the dense solve if the coarsest level is singular
+    constexpr int CoarseSweeps = 20;
+    constexpr float JacobiWeight = 2.0f / 3.0f;
+}
+
+namespace {
+
+    constexpr int Unaggregated = -1;
+    constexpr int Isolated = -2;
+
+    // Row with a single diagonal entry is a fixed (Dirichlet) DOF
+    std::vector<bool> FindDirichletRows(const SparseMatrix& a) {
+        std::vector<bool> fixed(a.rows, false);
+        for (size_t i = 0; i < a.rows; i++) {
+            bool off_diagonal = false;
+            for (size_t k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++) {
+                if (a.col_idx[k] != static_cast<int>(i) && a.values[k] != 0.0f) {
+                    off_diagonal = true;
+                    break;
+                }
+            }
+            fixed[i] = !off_diagonal;
+        }
+        return fixed;
+    }
+
+    // Build strength-of-connection graph between nodes and group nodes
+    // into aggregates. Returns aggregate index of every node.
+    std::vector<int> Aggregate(const SparseMatrix& a, int block_size, double threshold,
+            int& aggregate_count) {
+        const size_t nodes = a.rows / block_size;
+
+        // Block norms of node-node couplings
+        std::vector<std::vector<std::pair<int, double>>> couplings(nodes);
+        std::vector<double> block(nodes, 0.0);
+        std::vector<int> marker(nodes, -1);
+        std::vector<int> touched;
+
+        for (size_t ni = 0; ni < nodes; ni++) {
+            touched.clear();
+            for (int d = 0; d < block_size; d++) {
+                size_t row = ni * block_size + d;
+                for (size_t k = a.row_ptr[row]; k < a.row_ptr[row + 1]; k++) {
+                    int nj = a.col_idx[k] / block_size;
+                    if (marker[nj] != static_cast<int>(ni)) {
+                        marker[nj] = static_cast<int>(ni);
+                        block[nj] = 0.0;
+                        touched.push_back(nj);
+                    }
+                    block[nj] += fabs(a.values[k]);
+                }
+            }
+            for (int nj : touched) {
+                couplings[ni].push_back({ nj, block[nj] });
+            }
+        }
+
+        std::vector<double> self(nodes, 0.0);
+        for (size_t ni = 0; ni < nodes; ni++) {
+            for (const auto& c : couplings[ni]) {
+                if (c.first == static_cast<int>(ni)) {
+                    self[ni] = c.second;
+                }
+            }
+        }
+
+        std::vector<std::vector<int>> strong(nodes);
+        for (size_t ni = 0; ni < nodes; ni++) {
+            for (const auto& c : couplings[ni]) {
+                int nj = c.first;
+                if (nj != static_cast<int>(ni) &&
+                        c.second > threshold * sqrt(self[ni] * self[nj])) {
+                    strong[ni].push_back(nj);
+                }
+            }
+        }
+        couplings.clear();
+
+        std::vector<int> agg(nodes, Unaggregated);
+        for (size_t ni = 0; ni < nodes; ni++) {
+            if (strong[ni].empty()) {
+                agg[ni] = Isolated;
+            }
+        }
+
+        aggregate_count = 0;
+
+        // 1. Nodes with all neighbours free become roots of new aggregates
+        for (size_t ni = 0; ni < nodes; ni++) {
+            if (agg[ni] != Unaggregated) {
+                continue;
+            }
+            bool free_neighbourhood = true;
+            for (int nj : strong[ni]) {
+                if (agg[nj] >= 0) {
+                    free_neighbourhood = false;
+                    break;
+                }
+            }
+            if (!free_neighbourhood) {
+                continue;
+            }
+            agg[ni] = aggregate_count;
+            for (int nj : strong[ni]) {
+                if (agg[nj] == Unaggregated) {
+                    agg[nj] = aggregate_count;
+                }
+            }
+            aggregate_count++;
+        }
+
+        // 2. Remaining nodes join a neighbouring aggregate
+        std::vector<int> first_pass(agg);
+        for (size_t ni = 0; ni < nodes; ni++) {
+            if (agg[ni] != Unaggregated) {
+                continue;
+            }
+            for (int nj : strong[ni]) {
+                if (first_pass[nj] >= 0) {
+                    agg[ni] = first_pass[nj];
+                    break;
+                }
+            }
+        }
+
+        // 3. Leftovers form aggregates with their free neighbours
+        for (size_t ni = 0; ni < nodes; ni++) {
+            if (agg[ni] != Unaggregated) {
+                continue;
+            }
+            agg[ni] = aggregate_count;
+            for (int nj : strong[ni]) {
+                if (agg[nj] == Unaggregated) {
+                    agg[nj] = aggregate_count;
+                }
+            }
+            aggregate_count++;
+        }
+
+        return agg;
+    }
+
+    // Tentative prolongator from local QR decomposition of near null space
+    // over every aggregate. Coarse near null space is written to coarse_b.
+    SparseMatrix TentativeProlongator(const std::vector<int>& agg, int aggregate_count,
+            int block_size, const Matrix& b, Matrix& coarse_b) {
+        const size_t k = b.cols();
+        const size_t n = b.rows();
+
+        std::vector<std::vector<int>> dofs(aggregate_count);
+        for (size_t ni = 0; ni < agg.size(); ni++) {
+            if (agg[ni] < 0) {
+                continue;
+            }
+            for (int d = 0; d < block_size; d++) {
+                dofs[agg[ni]].push_back(static_cast<int>(ni) * block_size + d);
+            }
+        }
+
+        coarse_b.clear();
+        coarse_b.resize(aggregate_count * k, k, 0.0f);
+
+        std::vector<SparseMatrix::Triplet> triplets;
+        triplets.reserve(n * k);
+
+        std::vector<double> q;
+        for (int ai = 0; ai < aggregate_count; ai++) {
+            const auto& rows = dofs[ai];
+            const size_t m = rows.size();
+
+            q.assign(m * k, 0.0);
+            for (size_t i = 0; i < m; i++) {
+                for (size_t j = 0; j < k; j++) {
+                    q[i * k + j] = b(rows[i], j);
+                }
+            }
+
+            // Modified Gram-Schmidt, dependent columns are dropped
+            for (size_t j = 0; j < k; j++) {
+                for (size_t l = 0; l < j; l++) {
+                    double r = 0.0;
+                    for (size_t i = 0; i < m; i++) {
+                        r += q[i * k + l] * q[i * k + j];
+                    }
+                    coarse_b(ai * k + l, j) = static_cast<float>(r);
+                    for (size_t i = 0; i < m; i++) {
+                        q[i * k + j] -= r * q[i * k + l];
+                    }
+                }
+
+                double norm = 0.0;
+                for (size_t i = 0; i < m; i++) {
+                    norm += q[i * k + j] * q[i * k + j];
+                }
+                norm = sqrt(norm);
+
+                if (norm < 1e-10) {
+                    for (size_t i = 0; i < m; i++) {
+                        q[i * k + j] = 0.0;
+                    }
+                    continue;
+                }
+
+                coarse_b(ai * k + j, j) = static_cast<float>(norm);
+                for (size_t i = 0; i < m; i++) {
+                    q[i * k + j] /= norm;
+                }
+            }
+
+            for (size_t i = 0; i < m; i++) {
+                for (size_t j = 0; j < k; j++) {
+                    if (q[i * k + j] != 0.0) {
+                        triplets.push_back({ rows[i], static_cast<int>(ai * k + j),
+                            static_cast<float>(q[i * k + j]) });
+                    }
+                }
+            }
+        }
+
+        return SparseMatrix::from_triplets(n, aggregate_count * k, triplets);
+    }
+
+    // Estimate spectral radius of D^-1 A with power iterations
+    double SpectralRadius(const SparseMatrix& a, const Vector& diag) {
+        Vector x, y;
+        x.resize(a.rows);
+        for (size_t i = 0; i < a.rows; i++) {
+            x[i] = 1.0f + static_cast<float>(i % 7) * 0.1f;
+        }
+
+        double rho = 1.0;
+        for (int it = 0; it < AmgParams::PowerIterations; it++) {
+            a.multiply(x, y);
+            for (size_t i = 0; i < a.rows; i++) {
+                y[i] /= diag[i];
+            }
+            double norm = sqrt(dot(y, y));
+            double xnorm = sqrt(dot(x, x));
+            if (norm == 0.0 || xnorm == 0.0) {
+                break;
+            }
+            rho = norm / xnorm;
+            for (size_t i = 0; i < a.rows; i++) {
+                x[i] = static_cast<float>(y[i] / norm);
+            }
+        }
+        return rho;
+    }
+
+    // P = (I - w D^-1 A) P_tent
+    SparseMatrix SmoothProlongator(const SparseMatrix& a, const Vector& diag,
+            const SparseMatrix& tentative) {
+        double omega = AmgParams::Omega / SpectralRadius(a, diag);
+
+        SparseMatrix ap = a * tentative;
+        std::vector<SparseMatrix::Triplet> triplets;
+        triplets.reserve(ap.nonzeros() + tentative.nonzeros());
+
+        for (size_t i = 0; i < tentative.rows; i++) {
+            for (size_t k = tentative.row_ptr[i]; k < tentative.row_ptr[i + 1]; k++) {
+                triplets.push_back({ static_cast<int>(i), tentative.col_idx[k], tentative.values[k] });
+            }
+            float scale = static_cast<float>(omega / diag[i]);
+            for (size_t k = ap.row_ptr[i]; k < ap.row_ptr[i + 1]; k++) {
+                triplets.push_back({ static_cast<int>(i), ap.col_idx[k], -scale * ap.values[k] });
+            }
+        }
+
+        return SparseMatrix::from_triplets(tentative.rows, tentative.cols, triplets);
+    }
+
+    // Decouple rows of coarse matrix left without any coupling
+    void FixEmptyDiagonal(SparseMatrix& a) {
+        std::vector<SparseMatrix::Triplet> triplets;
+        Vector diag = a.diagonal();
+        bool fix = false;
+        for (size_t i = 0; i < a.rows; i++) {
+            for (size_t k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++) {
+                triplets.push_back({ static_cast<int>(i), a.col_idx[k], a.values[k] });
+            }
+            if (diag[i] == 0.0f) {
+                triplets.push_back({ static_cast<int>(i), static_cast<int>(i), 1.0f });
+                fix = true;
+            }
+        }
+        if (fix) {
+            a = SparseMatrix::from_triplets(a.rows, a.cols, triplets);
+        }
+    }
+
+    void ForwardGaussSeidel(const SparseMatrix& a, const Vector& diag, const Vector& b, Vector& x) {
+        for (size_t i = 0; i < a.rows; i++) {
+            float sum = b[i];
+            for (size_t k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++) {
+                sum -= a.values[k] * x[a.col_idx[k]];
+            }
+            x[i] += sum / diag[i];
+        }
+    }
+
+    void BackwardGaussSeidel(const SparseMatrix& a, const Vector& diag, const Vector& b, Vector& x) {
+        for (size_t i = a.rows; i-- > 0;) {
+            float sum = b[i];
+            for (size_t k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++) {
+                sum -= a.values[k] * x[a.col_idx[k]];
+            }
+            x[i] += sum / diag[i];
+        }
+    }
+
+    void JacobiSweeps(const SparseMatrix& a, const Vector& diag, const Vector& b, Vector& x, Vector& t) {
+        std::fill(x.begin(), x.end(), 0.0f);
+        for (int it = 0; it < AmgParams::CoarseSweeps; it++) {
+            a.multiply(x, t);
+            for (size_t i = 0; i < a.rows; i++) {
+                x[i] += AmgParams::JacobiWeight * (b[i] - t[i]) / diag[i];
+            }
+        }
+    }
+
+}
+
+void AmgPreconditioner::clear() {
+    levels_.clear();
+    coarse_.clear();
+    coarse_direct_ = false;
+}
+
+void AmgPreconditioner::setup(const SparseMatrix& a, int block_size, const Matrix& near_nullspace) {
+    using namespace AmgParams;
+
+    clear();
+
+    Matrix b;
+    if (near_nullspace.rows() == static_cast<int>(a.rows) && near_nullspace.cols() > 0) {
+        b = near_nullspace;
+    }
+    else {
+        b.resize(a.rows, block_size, 0.0f);
+        for (size_t i = 0; i < a.rows; i++) {
+            b(i, i % block_size) = 1.0f;
+        }
+    }
+
+    // Fixed DOFs do not take part in the coarse space
+    auto fixed = FindDirichletRows(a);
+    for (size_t i = 0; i < a.rows; i++) {
+        if (fixed[i]) {
+            for (int j = 0; j < b.cols(); j++) {
+                b(i, j) = 0.0f;
+            }
+        }
+    }
+
+    levels_.push_back(Level());
+    levels_.back().a = a;
+
+    double threshold = StrengthThreshold;
+    while (levels_.size() < MaxLevels) {
+        Level& fine = levels_.back();
+        fine.diag = fine.a.diagonal();
+        for (auto& d : fine.diag) {
+            if (d == 0.0f) {
+                d = 1.0f;
+            }
+        }
+
+        if (fine.a.rows <= CoarseSize || fine.a.rows % block_size != 0) {
+            break;
+        }
+
+        int aggregate_count{ 0 };
+        auto agg = Aggregate(fine.a, block_size, threshold, aggregate_count);
+        if (aggregate_count == 0) {
+            break;
+        }
+
+        Matrix coarse_b;
+        SparseMatrix tentative = TentativeProlongator(agg, aggregate_count, block_size, b, coarse_b);
+        if (tentative.cols >= MinCoarsening * fine.a.rows) {
+            break;
+        }
+
+        Level coarse;
+        fine.p = SmoothProlongator(fine.a, fine.diag, tentative);
+        fine.r = fine.p.transpose();
+        coarse.a = fine.r * (fine.a * fine.p);
+        FixEmptyDiagonal(coarse.a);
+
+        levels_.push_back(std::move(coarse));
+
+        b = coarse_b;
+        block_size = b.cols();
+        threshold *= 0.5;
+    }
+
+    // Dense factorization of the coarsest level
+    Level& last = levels_.back();
+    const SparseMatrix& ac = last.a;
+    Matrix dense;
+    dense.resize(ac.rows, ac.cols, 0.0f);
+    for (size_t i = 0; i < ac.rows; i++) {
+        for (size_t k = ac.row_ptr[i]; k < ac.row_ptr[i + 1]; k++) {
+            dense(i, ac.col_idx[k]) = ac.values[k];
+        }
+    }
+    coarse_direct_ = coarse_.factor(dense);
+    if (!coarse_direct_) {
+        // Singular coarse matrix, e.g. a mechanism with too few supports
+        coarse_.clear();
+        last.diag = ac.diagonal();
+        for (auto& d : last.diag) {
+            if (d == 0.0f) {
+                d = 1.0f;
+            }
+        }
+    }
+
+    for (auto& l : levels_) {
+        l.x.resize(l.a.rows);
+        l.b.resize(l.a.rows);
+        l.t.resize(l.a.rows);
+    }
+}
+
+size_t AmgPreconditioner::coarse_size() const {
+    return levels_.empty() ? 0 : levels_.back().a.rows;
+}
+
+double AmgPreconditioner::operator_complexity() const {
+    if (levels_.empty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (const auto& l : levels_) {
+        sum += l.a.nonzeros();
+    }
+    return sum / levels_.front().a.nonzeros();
+}
+
+void AmgPreconditioner::apply(const Vector& r, Vector& z) const {
+    if (levels_.empty()) {
+        z = r;
+        return;
+    }
+
+    std::copy(r.begin(), r.end(), levels_[0].b.begin());
+    cycle(0);
+    z = levels_[0].x;
+}
+
+void AmgPreconditioner::cycle(size_t level) const {
+    const Level& l = levels_[level];
+
+    if (level + 1 == levels_.size()) {
+        if (coarse_direct_) {
+            coarse_.solve(l.b, l.x);
+        }
+        else {
+            JacobiSweeps(l.a, l.diag, l.b, l.x, l.t);
+        }
+        return;
+    }
+
+    std::fill(l.x.begin(), l.x.end(), 0.0f);
+    ForwardGaussSeidel(l.a, l.diag, l.b, l.x);
+
+    // Restrict residual to the coarse level
+    l.a.multiply(l.x, l.t);
+    for (size_t i = 0; i < l.t.size(); i++) {
+        l.t[i] = l.b[i] - l.t[i];
+    }
+    const Level& c = levels_[level + 1];
+    l.r.multiply(l.t, c.b);
+
+    cycle(level + 1);
+
+    // Coarse grid correction
+    l.p.multiply(c.x, l.t);
+    for (size_t i = 0; i < l.x.size(); i++) {
+        l.x[i] += l.t[i];
+    }
+
+    BackwardGaussSeidel(l.a, l.diag, l.b, l.x);
+}
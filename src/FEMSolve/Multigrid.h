@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+ * Smoothed aggregation algebraic multigrid preconditioner.
+ *
+ * Setup builds the level hierarchy from the assembled matrix once, after
+ * that apply() performs a single symmetric V-cycle and can be used
+ * as a preconditioner for the conjugate gradient method for any number
+ * of right-hand sides (load cases).
+ */
+class AmgPreconditioner {
+public:
+    AmgPreconditioner() = default;
+
+    // Matrix rows are grouped into nodes of block_size DOFs. Near null space
+    // (e.g. rigid body modes) is given as columns of near_nullspace; if it is
+    // empty then translations along each of block_size axes are used.
+    void setup(const SparseMatrix& a, int block_size, const Matrix& near_nullspace = Matrix());
+    void clear();
+
+    void apply(const Vector& r, Vector& z) const;
+
+    size_t levels() const { return levels_.size(); }
+    size_t coarse_size() const;
+    double operator_complexity() const;
+
+    // False if the coarsest level is singular and smoothed by Jacobi sweeps
+    bool coarse_direct() const { return coarse_direct_; }
+
+private:
+    struct Level {
+        SparseMatrix a;
+        SparseMatrix p; // Prolongation from the next coarser level
+        SparseMatrix r; // Restriction to the next coarser level
+        Vector diag;
+
+        // Work vectors of V-cycle
+        mutable Vector x, b, t;
+    };
+
+    void cycle(size_t level) const;
+
+private:
+    std::vector<Level> levels_;
+    DenseLU coarse_;
+    bool coarse_direct_{ false };
+};
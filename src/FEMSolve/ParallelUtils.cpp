@@ -0,0 +1,36 @@
+#include "pch.h"
+#include "ThreadPool.h"
+#include "ParallelUtils.h"
+
+size_t ThreadCount() {
+    return ThreadPool::shared().threads();
+}
+
+void ParallelFor(size_t begin, size_t end, const RangeFunc& func) {
+    if (end <= begin) {
+        return;
+    }
+
+    size_t count = end - begin;
+    size_t threads = std::min(ThreadCount(), count / MinParallelWork);
+    if (threads <= 1) {
+        func(begin, end);
+        return;
+    }
+
+    size_t chunk = (count + threads - 1) / threads;
+
+    // Chunks run on the shared pool, threads are not created per call
+    TaskGroup tasks;
+    for (size_t i = 1; i < threads; i++) {
+        size_t b = begin + i * chunk;
+        size_t e = std::min(end, b + chunk);
+        if (b < e) {
+            tasks.submit([&func, b, e]() { func(b, e); });
+        }
+    }
+
+    // First chunk is processed by the calling thread
+    func(begin, std::min(end, begin + chunk));
+    tasks.wait();
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// Ranges shorter than this are processed on the calling thread
+constexpr size_t MinParallelWork = 4096;
+
+using RangeFunc = std::function<void(size_t begin, size_t end)>;
+
+size_t ThreadCount();
+
+// Split [begin, end) into contiguous chunks and process them on the shared pool
+void ParallelFor(size_t begin, size_t end, const RangeFunc& func);
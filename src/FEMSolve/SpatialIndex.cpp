@@ -0,0 +1,203 @@
+#include "pch.h"
+#include "LinAlgUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
+#include "FEM.h"
+#include "SpatialIndex.h"
+
+namespace SpatialParams {
+    // Resolution of the Hilbert curve along each axis
+    constexpr uint32_t HilbertBits = 16;
+}
+
+// Position of the cell on the Hilbert curve filling the 2^bits square
+static uint64_t HilbertIndex(uint32_t x, uint32_t y, uint32_t bits) {
+    uint64_t d = 0;
+    for (uint32_t s = 1u << (bits - 1); s > 0; s /= 2) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+void PackedRTree::build(const std::vector<BoundingBox>& boxes) {
+    using namespace SpatialParams;
+
+    clear();
+    if (boxes.empty()) {
+        return;
+    }
+
+    BoundingBox extent = boxes[0];
+    for (const auto& b : boxes) {
+        extent.xmin = std::min(extent.xmin, b.xmin);
+        extent.ymin = std::min(extent.ymin, b.ymin);
+        extent.xmax = std::max(extent.xmax, b.xmax);
+        extent.ymax = std::max(extent.ymax, b.ymax);
+    }
+
+    // Sort items by the Hilbert index of their box centers
+    const float cells = static_cast<float>((1u << HilbertBits) - 1);
+    float sx = (extent.xmax > extent.xmin) ? cells / (extent.xmax - extent.xmin) : 0;
+    float sy = (extent.ymax > extent.ymin) ? cells / (extent.ymax - extent.ymin) : 0;
+
+    std::vector<std::pair<uint64_t, int>> order(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++) {
+        const auto& b = boxes[i];
+        auto hx = static_cast<uint32_t>(((b.xmin + b.xmax) * 0.5f - extent.xmin) * sx);
+        auto hy = static_cast<uint32_t>(((b.ymin + b.ymax) * 0.5f - extent.ymin) * sy);
+        order[i] = { HilbertIndex(hx, hy, HilbertBits), static_cast<int>(i) };
+    }
+    std::sort(order.begin(), order.end());
+
+    ids_.resize(boxes.size());
+    levels_.emplace_back(boxes.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        ids_[i] = order[i].second;
+        levels_[0][i] = boxes[order[i].second];
+    }
+
+    // Parents enclose consecutive groups of children up to a single root
+    while (levels_.back().size() > 1) {
+        const auto& children = levels_.back();
+        std::vector<BoundingBox> parents((children.size() + NodeCapacity - 1) / NodeCapacity);
+        for (size_t i = 0; i < parents.size(); i++) {
+            size_t last = std::min((i + 1) * NodeCapacity, children.size());
+            BoundingBox b = children[i * NodeCapacity];
+            for (size_t j = i * NodeCapacity + 1; j < last; j++) {
+                b.xmin = std::min(b.xmin, children[j].xmin);
+                b.ymin = std::min(b.ymin, children[j].ymin);
+                b.xmax = std::max(b.xmax, children[j].xmax);
+                b.ymax = std::max(b.ymax, children[j].ymax);
+            }
+            parents[i] = b;
+        }
+        levels_.push_back(std::move(parents));
+    }
+}
+
+void PackedRTree::clear() {
+    levels_.clear();
+    ids_.clear();
+}
+
+void SpatialIndex::build(const FinitModel& model) {
+    clear();
+
+    std::vector<BoundingBox> boxes(model.nodes.size());
+    points_.resize(model.nodes.size());
+    for (size_t i = 0; i < model.nodes.size(); i++) {
+        const auto& n = model.nodes[i];
+        points_[i] = { n.x, n.y };
+        boxes[i] = { n.x, n.y, n.x, n.y };
+    }
+    nodeTree_.build(boxes);
+
+    boxes.resize(model.elems.size());
+    segments_.resize(model.elems.size());
+    for (size_t i = 0; i < model.elems.size(); i++) {
+        const auto& n1 = model.nodes[model.elems[i].nodes[0] - 1];
+        const auto& n2 = model.nodes[model.elems[i].nodes[1] - 1];
+        segments_[i] = { n1.x, n1.y, n2.x, n2.y };
+        boxes[i] = {
+            std::min(n1.x, n2.x), std::min(n1.y, n2.y),
+            std::max(n1.x, n2.x), std::max(n1.y, n2.y)
+        };
+    }
+    elementTree_.build(boxes);
+}
+
+void SpatialIndex::clear() {
+    points_.clear();
+    segments_.clear();
+    nodeTree_.clear();
+    elementTree_.clear();
+}
+
+int SpatialIndex::nearest_node(float x, float y, float max_distance) const {
+    return nodeTree_.nearest(x, y, max_distance * max_distance, [&](int i) {
+        float dx = points_[i][0] - x;
+        float dy = points_[i][1] - y;
+        return dx * dx + dy * dy;
+    });
+}
+
+int SpatialIndex::nearest_element(float x, float y, float max_distance) const {
+    return elementTree_.nearest(x, y, max_distance * max_distance, [&](int i) {
+        const auto& s = segments_[i];
+        float ex = s.x2 - s.x1;
+        float ey = s.y2 - s.y1;
+        float len2 = ex * ex + ey * ey;
+        float t = (len2 > 0) ? ((x - s.x1) * ex + (y - s.y1) * ey) / len2 : 0;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        float dx = s.x1 + t * ex - x;
+        float dy = s.y1 + t * ey - y;
+        return dx * dx + dy * dy;
+    });
+}
+
+void SpatialIndex::nodes_in_rect(const BoundingBox& rect, std::vector<int>& result) const {
+    result.clear();
+    nodeTree_.search(rect, [&result](int i) {
+        result.push_back(i);
+    });
+}
+
+void SpatialIndex::elements_in_rect(const BoundingBox& rect, std::vector<int>& result) const {
+    result.clear();
+    elementTree_.search(rect, [&](int i) {
+        // Clip the segment with the rectangle (Liang-Barsky)
+        const auto& s = segments_[i];
+        const float d[2] = { s.x2 - s.x1, s.y2 - s.y1 };
+        const float lo[2] = { rect.xmin - s.x1, rect.ymin - s.y1 };
+        const float hi[2] = { rect.xmax - s.x1, rect.ymax - s.y1 };
+        float t0 = 0, t1 = 1;
+        for (int k = 0; k < 2; k++) {
+            if (d[k] == 0) {
+                continue;
+            }
+            float ta = lo[k] / d[k];
+            float tb = hi[k] / d[k];
+            t0 = std::max(t0, std::min(ta, tb));
+            t1 = std::min(t1, std::max(ta, tb));
+        }
+        if (t0 <= t1) {
+            result.push_back(i);
+        }
+    });
+}
+
+int SpatialIndex::ray_hit(float x, float y, float dx, float dy, float& t) const {
+    int hit = -1;
+    t = std::numeric_limits<float>::max();
+    elementTree_.raycast(x, y, dx, dy, t, [&](int i) {
+        // Solve x+t*dx = x1+s*ex for t>=0 and 0<=s<=1
+        const auto& s = segments_[i];
+        float ex = s.x2 - s.x1;
+        float ey = s.y2 - s.y1;
+        float det = ex * dy - ey * dx;
+        if (det != 0) {
+            float qx = s.x1 - x;
+            float qy = s.y1 - y;
+            float ti = (ex * qy - ey * qx) / det;
+            float si = (dx * qy - dy * qx) / det;
+            if (ti >= 0 && ti < t && si >= 0 && si <= 1) {
+                t = ti;
+                hit = i;
+            }
+        }
+        return t;
+    });
+    return hit;
+}
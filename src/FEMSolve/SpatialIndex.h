@@ -0,0 +1,201 @@
+#pragma once
+
+struct BoundingBox {
+    float xmin, ymin, xmax, ymax;
+
+    bool intersects(const BoundingBox& b) const {
+        return xmin <= b.xmax && b.xmin <= xmax && ymin <= b.ymax && b.ymin <= ymax;
+    }
+
+    // Squared distance from a point, zero inside the box
+    float distance2(float x, float y) const {
+        float dx = std::max(std::max(xmin - x, x - xmax), 0.0f);
+        float dy = std::max(std::max(ymin - y, y - ymax), 0.0f);
+        return dx * dx + dy * dy;
+    }
+};
+
+/*
+ * Static R-tree packed bottom-up from boxes sorted along the Hilbert curve.
+ * Every tree node holds a fixed number of consecutive children, so no child
+ * pointers are stored and the tree is built in O(n log n) by a single sort.
+ */
+class PackedRTree {
+public:
+    PackedRTree() = default;
+
+    void build(const std::vector<BoundingBox>& boxes);
+    void clear();
+
+    size_t size() const { return ids_.size(); }
+
+    // Calls visit(id) for every item whose box intersects the rectangle
+    template <typename Visitor>
+    void search(const BoundingBox& rect, Visitor visit) const;
+
+    // Item with the smallest distance2(id) not larger than max_distance2, or -1.
+    // distance2 must not be smaller than the distance to the item box.
+    template <typename Distance>
+    int nearest(float x, float y, float max_distance2, Distance distance2) const;
+
+    // Calls hit(id) for items whose box may be crossed by the ray before
+    // the parameter returned by the previous hits, hit returns the new limit
+    template <typename Hit>
+    void raycast(float x, float y, float dx, float dy, float t_max, Hit hit) const;
+
+private:
+    static constexpr size_t NodeCapacity = 16;
+
+    // Level 0 keeps boxes of the items, the last level keeps the root
+    std::vector<std::vector<BoundingBox>> levels_;
+    std::vector<int> ids_;
+};
+
+/*
+ * Spatial index over nodes and elements of a model built once when the model
+ * is loaded. Serves picking, viewport queries and probing of results.
+ * Returned values are indices in model.nodes and model.elems.
+ */
+class SpatialIndex {
+public:
+    SpatialIndex() = default;
+
+    void build(const FinitModel& model);
+    void clear();
+
+    int nearest_node(float x, float y, float max_distance) const;
+    int nearest_element(float x, float y, float max_distance) const;
+
+    void nodes_in_rect(const BoundingBox& rect, std::vector<int>& result) const;
+    void elements_in_rect(const BoundingBox& rect, std::vector<int>& result) const;
+
+    // First element crossed by the ray x+t*dx, y+t*dy with t>=0, or -1
+    int ray_hit(float x, float y, float dx, float dy, float& t) const;
+
+private:
+    struct Segment {
+        float x1, y1, x2, y2;
+    };
+
+    std::vector<std::array<float, 2>> points_;
+    std::vector<Segment> segments_;
+    PackedRTree nodeTree_;
+    PackedRTree elementTree_;
+};
+
+template <typename Visitor>
+void PackedRTree::search(const BoundingBox& rect, Visitor visit) const {
+    if (levels_.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (size_t i = 0; i < levels_.back().size(); i++) {
+        stack.push_back({ levels_.size() - 1, i });
+    }
+
+    while (!stack.empty()) {
+        auto [level, i] = stack.back();
+        stack.pop_back();
+        if (!levels_[level][i].intersects(rect)) {
+            continue;
+        }
+        if (level == 0) {
+            visit(ids_[i]);
+            continue;
+        }
+        size_t last = std::min((i + 1) * NodeCapacity, levels_[level - 1].size());
+        for (size_t j = i * NodeCapacity; j < last; j++) {
+            stack.push_back({ level - 1, j });
+        }
+    }
+}
+
+template <typename Distance>
+int PackedRTree::nearest(float x, float y, float max_distance2, Distance distance2) const {
+    if (levels_.empty()) {
+        return -1;
+    }
+
+    // Best-first search, items are queued with their exact distances
+    struct Entry {
+        float distance2;
+        size_t level, index;
+        bool operator<(const Entry& e) const { return distance2 > e.distance2; }
+    };
+
+    std::priority_queue<Entry> queue;
+    auto push = [&](size_t level, size_t i) {
+        float d = (level == 0) ? distance2(ids_[i]) : levels_[level][i].distance2(x, y);
+        if (d <= max_distance2) {
+            queue.push({ d, level, i });
+        }
+    };
+
+    for (size_t i = 0; i < levels_.back().size(); i++) {
+        push(levels_.size() - 1, i);
+    }
+
+    while (!queue.empty()) {
+        Entry e = queue.top();
+        queue.pop();
+        if (e.level == 0) {
+            return ids_[e.index];
+        }
+        size_t last = std::min((e.index + 1) * NodeCapacity, levels_[e.level - 1].size());
+        for (size_t j = e.index * NodeCapacity; j < last; j++) {
+            push(e.level - 1, j);
+        }
+    }
+    return -1;
+}
+
+template <typename Hit>
+void PackedRTree::raycast(float x, float y, float dx, float dy, float t_max, Hit hit) const {
+    if (levels_.empty()) {
+        return;
+    }
+
+    // Parameter where the ray enters the box, negative if it misses
+    auto enter = [&](const BoundingBox& b) {
+        float t0 = 0, t1 = t_max;
+        const float o[2] = { x, y };
+        const float d[2] = { dx, dy };
+        const float lo[2] = { b.xmin, b.ymin };
+        const float hi[2] = { b.xmax, b.ymax };
+        for (int k = 0; k < 2; k++) {
+            if (d[k] == 0) {
+                if (o[k] < lo[k] || o[k] > hi[k]) {
+                    return -1.0f;
+                }
+                continue;
+            }
+            float ta = (lo[k] - o[k]) / d[k];
+            float tb = (hi[k] - o[k]) / d[k];
+            t0 = std::max(t0, std::min(ta, tb));
+            t1 = std::min(t1, std::max(ta, tb));
+        }
+        return (t0 <= t1) ? t0 : -1.0f;
+    };
+
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (size_t i = 0; i < levels_.back().size(); i++) {
+        stack.push_back({ levels_.size() - 1, i });
+    }
+
+    while (!stack.empty()) {
+        auto [level, i] = stack.back();
+        stack.pop_back();
+        if (enter(levels_[level][i]) < 0) {
+            continue;
+        }
+        if (level == 0) {
+            t_max = std::min(t_max, hit(ids_[i]));
+            continue;
+        }
+        size_t last = std::min((i + 1) * NodeCapacity, levels_[level - 1].size());
+        for (size_t j = i * NodeCapacity; j < last; j++) {
+            stack.push_back({ level - 1, j });
+        }
+    }
+}
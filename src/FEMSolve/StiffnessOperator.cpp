@@ -0,0 +1,189 @@
+#include "pch.h"
+#include "LinAlgUtils.h"
+#include "ParallelUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
+#include "FEM.h"
+
+void StiffnessOperator::clear() {
+    dof1_.clear();
+    dof2_.clear();
+    kxx_.clear();
+    kxy_.clear();
+    kyy_.clear();
+    colorOffsets_.clear();
+    free_.clear();
+}
+
+void StiffnessOperator::build(const FinitModel& model) {
+    clear();
+
+    const size_t node_count = model.nodes.size();
+    const size_t elem_count = model.elems.size();
+
+    // Node to element adjacency
+    std::vector<size_t> offsets(node_count + 1, 0);
+    for (const auto& e : model.elems) {
+        offsets[e.nodes[0]]++;
+        offsets[e.nodes[1]]++;
+    }
+    for (size_t i = 0; i < node_count; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<int> adjacent(offsets[node_count]);
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < elem_count; i++) {
+        for (int node : model.elems[i].nodes) {
+            adjacent[fill[node - 1]++] = static_cast<int>(i);
+        }
+    }
+
+    // Greedy coloring so that elements of one color do not share nodes
+    std::vector<int> color(elem_count, -1);
+    std::vector<size_t> stamp;
+    int color_count = 0;
+    for (size_t i = 0; i < elem_count; i++) {
+        for (int node : model.elems[i].nodes) {
+            for (size_t k = offsets[node - 1]; k < offsets[node]; k++) {
+                int c = color[adjacent[k]];
+                if (c >= 0) {
+                    stamp[c] = i + 1;
+                }
+            }
+        }
+
+        int c = 0;
+        while (c < color_count && stamp[c] == i + 1) {
+            c++;
+        }
+        if (c == color_count) {
+            color_count++;
+            stamp.push_back(0);
+        }
+        color[i] = c;
+    }
+
+    colorOffsets_.assign(color_count + 1, 0);
+    for (int c : color) {
+        colorOffsets_[c + 1]++;
+    }
+    for (int c = 0; c < color_count; c++) {
+        colorOffsets_[c + 1] += colorOffsets_[c];
+    }
+
+    dof1_.resize(elem_count);
+    dof2_.resize(elem_count);
+    kxx_.resize(elem_count);
+    kxy_.resize(elem_count);
+    kyy_.resize(elem_count);
+
+    std::vector<size_t> pos(colorOffsets_.begin(), colorOffsets_.end() - 1);
+    for (size_t i = 0; i < elem_count; i++) {
+        const auto& e = model.elems[i];
+        size_t k = pos[color[i]]++;
+
+        dof1_[k] = (model.nodes[e.nodes[0] - 1].node - 1) * ModelDimensions;
+        dof2_[k] = (model.nodes[e.nodes[1] - 1].node - 1) * ModelDimensions;
+        kxx_[k] = e.cosa * e.cosa / e.length;
+        kxy_[k] = e.cosa * e.sina / e.length;
+        kyy_[k] = e.sina * e.sina / e.length;
+    }
+
+    free_.resize(model.component_count, 1.0f);
+    for (const auto& f : model.fixes) {
+        free_((f.node - 1) * 2 + 1 - (f.axis % 2)) = 0.0f;
+    }
+}
+
+void StiffnessOperator::apply(const Vector& x, Vector& y) const {
+    const size_t n = size();
+    y.resize(n);
+    std::fill(y.begin(), y.end(), 0.0f);
+
+    for (size_t c = 0; c + 1 < colorOffsets_.size(); c++) {
+        ParallelFor(colorOffsets_[c], colorOffsets_[c + 1],
+            [&](size_t begin, size_t end) {
+                apply_range(x, y, begin, end);
+            });
+    }
+
+    // Fixed DOFs keep the unit diagonal of the assembled matrix
+    for (size_t i = 0; i < n; i++) {
+        y[i] = free_[i] * y[i] + (1.0f - free_[i]) * x[i];
+    }
+}
+
+void StiffnessOperator::apply_range(const Vector& x, Vector& y, size_t begin, size_t end) const {
+    const float* xp = x.data();
+    const float* fp = free_.data();
+    float* yp = y.data();
+
+    // Branch-free gather/scatter loop, fixed DOFs are masked out by free_
+    for (size_t k = begin; k < end; k++) {
+        const int i = dof1_[k];
+        const int j = dof2_[k];
+
+        float dx = xp[i] * fp[i] - xp[j] * fp[j];
+        float dy = xp[i + 1] * fp[i + 1] - xp[j + 1] * fp[j + 1];
+
+        float fx = kxx_[k] * dx + kxy_[k] * dy;
+        float fy = kxy_[k] * dx + kyy_[k] * dy;
+
+        yp[i] += fx;
+        yp[i + 1] += fy;
+        yp[j] -= fx;
+        yp[j + 1] -= fy;
+    }
+}
+
+Vector StiffnessOperator::diagonal() const {
+    Vector d;
+    d.resize(size(), 0.0f);
+
+    for (size_t k = 0; k < dof1_.size(); k++) {
+        d[dof1_[k]] += kxx_[k];
+        d[dof1_[k] + 1] += kyy_[k];
+        d[dof2_[k]] += kxx_[k];
+        d[dof2_[k] + 1] += kyy_[k];
+    }
+
+    for (size_t i = 0; i < d.size(); i++) {
+        if (free_[i] == 0.0f || d[i] == 0.0f) {
+            d[i] = 1.0f;
+        }
+    }
+
+    return d;
+}
+
+SparseMatrix StiffnessOperator::assemble() const {
+    std::vector<SparseMatrix::Triplet> triplets;
+    triplets.reserve(dof1_.size() * 16 + free_.size());
+
+    for (size_t k = 0; k < dof1_.size(); k++) {
+        const int dofs[4] = { dof1_[k], dof1_[k] + 1, dof2_[k], dof2_[k] + 1 };
+        const float block[2][2] = {
+            { kxx_[k], kxy_[k] },
+            { kxy_[k], kyy_[k] }
+        };
+
+        for (int j = 0; j < 4; j++) {
+            for (int m = 0; m < 4; m++) {
+                if (free_[dofs[j]] == 0.0f || free_[dofs[m]] == 0.0f) {
+                    continue;
+                }
+                float sign = ((j < 2) == (m < 2)) ? 1.0f : -1.0f;
+                triplets.push_back({ dofs[j], dofs[m], sign * block[j % 2][m % 2] });
+            }
+        }
+    }
+
+    for (size_t i = 0; i < free_.size(); i++) {
+        if (free_[i] == 0.0f) {
+            triplets.push_back({ static_cast<int>(i), static_cast<int>(i), 1.0f });
+        }
+    }
+
+    return SparseMatrix::from_triplets(size(), size(), triplets);
+}
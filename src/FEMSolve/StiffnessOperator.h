@@ -0,0 +1,38 @@
+#pragma once
+
+struct FinitModel;
+
+/*
+ * Matrix-free stiffness operator of a truss model. Applies y = K*x element
+ * by element without assembling K. Fixed DOFs behave like in the assembled
+ * matrix: their rows and columns are zero except for a unit diagonal.
+ */
+class StiffnessOperator {
+public:
+    StiffnessOperator() = default;
+
+    void build(const FinitModel& model);
+    void clear();
+
+    void apply(const Vector& x, Vector& y) const;
+    Vector diagonal() const;
+
+    // Assembled matrix with the same action as apply()
+    SparseMatrix assemble() const;
+
+    size_t size() const { return free_.size(); }
+    size_t colors() const { return colorOffsets_.empty() ? 0 : colorOffsets_.size() - 1; }
+
+private:
+    void apply_range(const Vector& x, Vector& y, size_t begin, size_t end) const;
+
+private:
+    // Element data as structure of arrays sorted by color. Elements
+    // of the same color share no nodes and can be scattered concurrently.
+    std::vector<int> dof1_, dof2_;
+    std::vector<float> kxx_, kxy_, kyy_;
+    std::vector<size_t> colorOffsets_;
+
+    // 1 for free DOFs and 0 for fixed ones
+    Vector free_;
+};
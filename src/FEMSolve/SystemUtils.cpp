@@ -0,0 +1,20 @@
+#include "pch.h"
+#include "SystemUtils.h"
+
+size_t ResidentMemorySize() {
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+
+    // Total program size and resident set size in pages
+    unsigned long size{ 0 }, resident{ 0 };
+    int count = fscanf(f, "%lu %lu", &size, &resident);
+    fclose(f);
+
+    return (count == 2) ? resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
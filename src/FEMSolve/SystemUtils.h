@@ -0,0 +1,4 @@
+#pragma once
+
+// Resident memory of the process in bytes, 0 if not available
+size_t ResidentMemorySize();
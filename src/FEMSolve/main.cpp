@@ -4,13 +4,54 @@
  */
 
 #include "pch.h"
+#include "Canvas.h"
+#include "Headless.h"
+#include "Painter.h"
 #include "GraphicsUtils.h"
 #include "LinAlgUtils.h"
+#include "StiffnessOperator.h"
+#include "Multigrid.h"
+#include "DomainDecomposition.h"
 #include "FEM.h"
+#include "Benchmark.h"
+#include "Export.h"
+#include "LodGrid.h"
+#include "SpatialIndex.h"
 #include "ModelWidget.h"
 #include "MainWindow.h"
 
 int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        return RunBenchmark();
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--draw-benchmark") == 0) {
+        constexpr int DrawFrames = 100;
+        return RunDrawBenchmark((argc > 2) ? argv[2] : nullptr, DrawFrames);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--pick-benchmark") == 0) {
+        constexpr int PickQueries = 100000;
+        return RunPickBenchmark((argc > 2) ? argv[2] : nullptr, PickQueries);
+    }
+
+    constexpr int ExportWidth = 1024;
+    constexpr int ExportHeight = 768;
+
+    if (argc > 3 && strcmp(argv[1], "--export") == 0) {
+        int width = (argc > 5) ? atoi(argv[4]) : ExportWidth;
+        int height = (argc > 5) ? atoi(argv[5]) : ExportHeight;
+        return ExportImage(argv[2], argv[3], width, height);
+    }
+
+    if (argc > 3 && strcmp(argv[1], "--export-batch") == 0) {
+        std::vector<std::string> modelFiles(argv + 3, argv + argc);
+        return ExportImages(argv[2], modelFiles, ExportWidth, ExportHeight);
+    }
+
+    // Enable awake callbacks from the solver thread
+    Fl::lock();
+
     auto window = new MainWindow(700, 500, "FEMSolve");
     window->show(argc, argv);
     return Fl::run();
@@ -1,11 +1,20 @@
 #include "stdafx.h"
+#include "TiledMatrix.h"
 #include "Model.h"
 
 Model::Model()
-    : E_(1.0)
+    : outOfCore_(false)
+    , memoryBudget_(0)
+    , E_(1.0)
     , F_(1.0) {
 }
 
+void Model::SetOutOfCore(const std::string& scratchFile, size_t memoryBudget) {
+    outOfCore_ = true;
+    scratchFile_ = scratchFile;
+    memoryBudget_ = memoryBudget;
+}
+
 bool Model::LoadFromFile(const std::string& fileName) {
     std::ifstream in(fileName, std::ios::in);
     
@@ -87,21 +96,25 @@ bool Model::LoadFromFile(const std::string& fileName) {
     return true;
 }
 
-void Model::PrepareSolve() {
+bool Model::PrepareSolve() {
     component_count_ = nodes_.size() * g_modelDimensions;
     
     b_ = arma::vec(component_count_, arma::fill::zeros);
     u_ = arma::vec(component_count_, arma::fill::zeros);
     n_ = arma::vec(elements_.size(), arma::fill::zeros);
     
-    a_ = arma::mat(component_count_, component_count_, arma::fill::zeros);
-    
     // Fill B matrix
     for (const auto& load : loads_) {
         b_(load.node * 2 - 2) = load.px;
         b_(load.node * 2 - 1) = load.py;
     }
     
+    if (outOfCore_) {
+        return PrepareOutOfCore();
+    }
+    
+    a_ = arma::mat(component_count_, component_count_, arma::fill::zeros);
+    
     // Fill A matrix
     for (const auto& elem : elements_) {
         NODE n1 = nodes_[elem.nodes[0] - 1];
@@ -150,11 +163,72 @@ void Model::PrepareSolve() {
         a_(node, node) = 1.0;
         b_(node) = 0.0;
     }
+    
+    return true;
+}
+
+bool Model::PrepareOutOfCore() {
+    a_.reset();
+    if (!tiled_.Create(component_count_, scratchFile_, memoryBudget_)) {
+        return false;
+    }
+    
+    std::vector<bool> fixed(component_count_, false);
+    for (const auto& fix : fixes_) {
+        int node = (fix.node - 1) * 2 + 1 - (fix.axis % 2);
+        fixed[node] = true;
+        b_(node) = 0.0;
+    }
+    
+    // Lower triangle of A matrix is written directly into tiles,
+    // rows and columns of fixed components are skipped
+    for (const auto& elem : elements_) {
+        NODE n1 = nodes_[elem.nodes[0] - 1];
+        NODE n2 = nodes_[elem.nodes[1] - 1];
+        
+        double K[2][2];
+        K[0][0] = elem.cosa * elem.cosa / elem.length;
+        K[0][1] = K[1][0] = elem.cosa * elem.sina / elem.length;
+        K[1][1] = elem.sina * elem.sina / elem.length;
+        
+        int globalIndices[4] = {
+            n1.node * 2 - 2, n1.node * 2 - 1,
+            n2.node * 2 - 2, n2.node * 2 - 1
+        };
+        
+        for (int j=0; j<4; j++) {
+            for (int m=0; m<4; m++) {
+                int p = globalIndices[j];
+                int q = globalIndices[m];
+                if (p < q || fixed[p] || fixed[q]) {
+                    continue;
+                }
+                double k = K[j % 2][m % 2];
+                tiled_.Add(p, q, (j / 2 == m / 2) ? k : -k);
+            }
+        }
+    }
+    
+    for (int i = 0; i < component_count_; ++i) {
+        if (fixed[i]) {
+            tiled_.Add(i, i, 1.0);
+        }
+    }
+    tiled_.Flush();
+    
+    return true;
 }
 
-void Model::Solve() {
+bool Model::Solve() {
     // Solve system of linear equations A*u=b
-    u_ = a_.i() * b_;
+    if (outOfCore_) {
+        if (!tiled_.Factorize()) {
+            return false;
+        }
+        u_ = tiled_.Solve(b_);
+    } else {
+        u_ = a_.i() * b_;
+    }
     
     u_ /= (E_ * F_);
     
@@ -166,4 +240,6 @@ void Model::Solve() {
         double ny = (u_(2*n1.node - 1) - u_(2*n2.node - 1)*(n1.y - n2.y));
         n_(idx++) = (nx + ny) / (elem.length * elem.length);
     }
+    
+    return true;
 }
@@ -29,12 +29,25 @@ public:
     Model();
     
     bool LoadFromFile(const std::string& fileName);
-    void PrepareSolve();
-    void Solve();
+    
+    // Stiffness matrix is kept in the scratch file with the given
+    // memory budget in bytes instead of arma::mat
+    void SetOutOfCore(const std::string& scratchFile, size_t memoryBudget);
+    
+    bool PrepareSolve();
+    bool Solve();
+    
+private:
+    bool PrepareOutOfCore();
         
 public:
     int component_count_;
     
+    bool outOfCore_;
+    std::string scratchFile_;
+    size_t memoryBudget_;
+    TiledMatrix tiled_;
+    
     double E_, F_;
     
     std::vector<NODE> nodes_;
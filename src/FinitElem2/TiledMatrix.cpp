@@ -0,0 +1,270 @@
+#include "stdafx.h"
+#include "TiledMatrix.h"
+
+// Memory budget holds at least this number of mapped tiles
+static const size_t g_minMappedTiles = 16;
+
+static const size_t g_minTileSize = 32;
+
+// Tiles of this number of following steps are read ahead
+static const size_t g_prefetchSteps = 4;
+
+TiledMatrix::TiledMatrix()
+    : size_(0)
+    , tileSize_(0)
+    , tileCount_(0)
+    , tileBytes_(0)
+    , maxMapped_(0)
+    , loads_(0)
+    , fd_(-1) {
+}
+
+TiledMatrix::~TiledMatrix() {
+    Release();
+}
+
+bool TiledMatrix::Create(size_t size, const std::string& scratchFile, size_t memoryBudget) {
+    Release();
+
+#if !defined(WIN32)
+    size_ = size;
+    fileName_ = scratchFile;
+
+    tileSize_ = static_cast<size_t>(sqrt(memoryBudget / (sizeof(double) * g_minMappedTiles)));
+    tileSize_ = std::max(g_minTileSize, std::min(tileSize_, size_));
+    tileCount_ = (size_ + tileSize_ - 1) / tileSize_;
+
+    // Tiles are mapped separately, so every tile starts at a page boundary
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    tileBytes_ = (tileSize_ * tileSize_ * sizeof(double) + page - 1) / page * page;
+    maxMapped_ = std::max(g_minMappedTiles, memoryBudget / tileBytes_);
+
+    fd_ = open(fileName_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    // Scratch file is removed right away and its space is freed once closed
+    unlink(fileName_.c_str());
+
+    // Sparse file reads as zeros
+    off_t fileSize = static_cast<off_t>(tileCount_ * (tileCount_ + 1) / 2 * tileBytes_);
+    if (ftruncate(fd_, fileSize) != 0) {
+        Release();
+        return false;
+    }
+
+    return true;
+#else
+    (void)size; (void)scratchFile; (void)memoryBudget;
+    return false;
+#endif
+}
+
+void TiledMatrix::Release() {
+    while (!mappedOrder_.empty()) {
+        Unmap(mappedOrder_.front());
+    }
+    pending_.clear();
+
+#if !defined(WIN32)
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+    fd_ = -1;
+    size_ = tileSize_ = tileCount_ = tileBytes_ = 0;
+    loads_ = 0;
+}
+
+size_t TiledMatrix::TileRows(size_t i) const {
+    return std::min(tileSize_, size_ - i * tileSize_);
+}
+
+size_t TiledMatrix::TileIndex(size_t i, size_t j) const {
+    return i * (i + 1) / 2 + j;
+}
+
+double* TiledMatrix::Map(size_t i, size_t j) {
+    size_t index = TileIndex(i, j);
+
+    auto it = mapped_.find(index);
+    if (it != mapped_.end()) {
+        mappedOrder_.splice(mappedOrder_.end(), mappedOrder_, it->second.second);
+        return it->second.first;
+    }
+
+    // Least recently used tiles are unmapped. Every step uses at most
+    // three tiles, so tiles of the current step are never unmapped.
+    while (mapped_.size() >= maxMapped_) {
+        Unmap(mappedOrder_.front());
+    }
+
+    double* data = nullptr;
+#if !defined(WIN32)
+    void* p = mmap(nullptr, tileBytes_, PROT_READ | PROT_WRITE, MAP_SHARED,
+        fd_, static_cast<off_t>(index * tileBytes_));
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("Unable to map tile of the scratch file");
+    }
+    data = static_cast<double*>(p);
+#endif
+
+    loads_++;
+    mappedOrder_.push_back(index);
+    mapped_[index] = std::make_pair(data, std::prev(mappedOrder_.end()));
+    return data;
+}
+
+void TiledMatrix::Unmap(size_t index) {
+    auto it = mapped_.find(index);
+    if (it == mapped_.end()) {
+        return;
+    }
+
+#if !defined(WIN32)
+    // Start writing back modified pages without waiting for it
+    msync(it->second.first, tileBytes_, MS_ASYNC);
+    munmap(it->second.first, tileBytes_);
+#endif
+
+    mappedOrder_.erase(it->second.second);
+    mapped_.erase(it);
+}
+
+void TiledMatrix::Prefetch(size_t i, size_t j) {
+    size_t index = TileIndex(i, j);
+    if (mapped_.count(index)) {
+        return;
+    }
+
+#if !defined(WIN32) && !defined(__APPLE__)
+    // Asynchronous read ahead overlaps loading of the tile with the current step
+    posix_fadvise(fd_, static_cast<off_t>(index * tileBytes_),
+        static_cast<off_t>(tileBytes_), POSIX_FADV_WILLNEED);
+#endif
+}
+
+arma::mat TiledMatrix::Tile(size_t i, size_t j) {
+    return arma::mat(Map(i, j), TileRows(i), TileRows(j), false, true);
+}
+
+void TiledMatrix::Add(size_t row, size_t col, double value) {
+    pending_.push_back({row, col, value});
+
+    // Contributions kept in memory take no more than a tile
+    if (pending_.size() * sizeof(Pending) >= tileBytes_) {
+        ApplyPending();
+    }
+}
+
+void TiledMatrix::Flush() {
+    ApplyPending();
+}
+
+void TiledMatrix::ApplyPending() {
+    // Contributions to the same tile are written together
+    std::sort(pending_.begin(), pending_.end(), [this](const Pending& a, const Pending& b) {
+        return TileIndex(a.row / tileSize_, a.col / tileSize_) < TileIndex(b.row / tileSize_, b.col / tileSize_);
+    });
+
+    for (const auto& p : pending_) {
+        size_t i = p.row / tileSize_;
+        size_t j = p.col / tileSize_;
+        double* tile = Map(i, j);
+        tile[(p.col - j * tileSize_) * TileRows(i) + (p.row - i * tileSize_)] += p.value;
+    }
+
+    pending_.clear();
+}
+
+bool TiledMatrix::Factorize() {
+    ApplyPending();
+
+    // Right-looking schedule of tile operations
+    std::vector<Step> steps;
+    for (size_t k = 0; k < tileCount_; ++k) {
+        steps.push_back({Operation::Factor, k, k, k});
+        for (size_t i = k + 1; i < tileCount_; ++i) {
+            steps.push_back({Operation::Solve, i, k, k});
+        }
+        for (size_t j = k + 1; j < tileCount_; ++j) {
+            for (size_t i = j; i < tileCount_; ++i) {
+                steps.push_back({Operation::Update, i, j, k});
+            }
+        }
+    }
+
+    auto prefetch = [this](const Step& s) {
+        Prefetch(s.i, s.j);
+        if (s.op != Operation::Factor) {
+            Prefetch(s.i, s.k);
+            Prefetch(s.j, s.k);
+        }
+    };
+
+    for (size_t s = 0; s < std::min(g_prefetchSteps, steps.size()); ++s) {
+        prefetch(steps[s]);
+    }
+
+    for (size_t s = 0; s < steps.size(); ++s) {
+        if (s + g_prefetchSteps < steps.size()) {
+            prefetch(steps[s + g_prefetchSteps]);
+        }
+
+        const Step& step = steps[s];
+        switch (step.op) {
+        case Operation::Factor: {
+            // Only lower triangle of diagonal tiles is assembled
+            arma::mat akk = Tile(step.k, step.k);
+            arma::mat l;
+            if (!arma::chol(l, arma::symmatl(akk), "lower")) {
+                return false;
+            }
+            akk = l;
+            break;
+        }
+        case Operation::Solve: {
+            arma::mat lkk = Tile(step.k, step.k);
+            arma::mat aik = Tile(step.i, step.k);
+            aik = arma::trans(arma::solve(arma::trimatl(lkk), arma::trans(aik)));
+            break;
+        }
+        case Operation::Update: {
+            arma::mat lik = Tile(step.i, step.k);
+            arma::mat ljk = Tile(step.j, step.k);
+            arma::mat aij = Tile(step.i, step.j);
+            aij -= lik * arma::trans(ljk);
+            break;
+        }
+        }
+    }
+
+    return true;
+}
+
+arma::vec TiledMatrix::Solve(const arma::vec& b) {
+    arma::vec y = b;
+
+    // Forward substitution L*y = b
+    for (size_t i = 0; i < tileCount_; ++i) {
+        arma::vec yi = y.subvec(i * tileSize_, i * tileSize_ + TileRows(i) - 1);
+        for (size_t k = 0; k < i; ++k) {
+            yi -= Tile(i, k) * y.subvec(k * tileSize_, k * tileSize_ + TileRows(k) - 1);
+        }
+        y.subvec(i * tileSize_, i * tileSize_ + TileRows(i) - 1) =
+            arma::solve(arma::trimatl(Tile(i, i)), yi);
+    }
+
+    // Back substitution L^T*x = y
+    for (size_t i = tileCount_; i-- > 0;) {
+        arma::vec xi = y.subvec(i * tileSize_, i * tileSize_ + TileRows(i) - 1);
+        for (size_t k = i + 1; k < tileCount_; ++k) {
+            xi -= arma::trans(Tile(k, i)) * y.subvec(k * tileSize_, k * tileSize_ + TileRows(k) - 1);
+        }
+        y.subvec(i * tileSize_, i * tileSize_ + TileRows(i) - 1) =
+            arma::solve(arma::trimatu(arma::trans(Tile(i, i))), xi);
+    }
+
+    return y;
+}
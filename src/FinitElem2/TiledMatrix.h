@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+ * Symmetric positive definite matrix that is kept out of core. Lower triangle
+ * is split into square tiles stored in a memory-mapped scratch file, and only
+ * the tiles fitting into the memory budget are mapped at a time.
+ */
+class TiledMatrix {
+public:
+    TiledMatrix();
+    ~TiledMatrix();
+
+    TiledMatrix(const TiledMatrix&) = delete;
+    TiledMatrix& operator=(const TiledMatrix&) = delete;
+
+    // Creates zero matrix, tile size is chosen from the memory budget in bytes
+    bool Create(size_t size, const std::string& scratchFile, size_t memoryBudget);
+    void Release();
+
+    // Adds value to the element of lower triangle, row >= col
+    void Add(size_t row, size_t col, double value);
+    void Flush();
+
+    // In-place tiled Cholesky decomposition A = L*L^T
+    bool Factorize();
+    arma::vec Solve(const arma::vec& b);
+
+    size_t Size() const { return size_; }
+    size_t TileSize() const { return tileSize_; }
+    size_t TileCount() const { return tileCount_; }
+    size_t Loads() const { return loads_; }
+
+private:
+    struct Pending {
+        size_t row, col;
+        double value;
+    };
+
+    enum class Operation {
+        Factor,    // L_kk = chol(A_kk)
+        Solve,     // L_ik = A_ik * L_kk^-T
+        Update     // A_ij -= L_ik * L_jk^T
+    };
+
+    struct Step {
+        Operation op;
+        size_t i, j, k;
+    };
+
+    size_t TileRows(size_t i) const;
+    size_t TileIndex(size_t i, size_t j) const;
+
+    // Tile as a matrix over the mapped memory
+    arma::mat Tile(size_t i, size_t j);
+    double* Map(size_t i, size_t j);
+    void Unmap(size_t index);
+    void Prefetch(size_t i, size_t j);
+
+    void ApplyPending();
+
+private:
+    size_t size_;
+    size_t tileSize_;
+    size_t tileCount_;
+    size_t tileBytes_;
+    size_t maxMapped_;
+    size_t loads_;
+
+    std::string fileName_;
+    int fd_;
+
+    // Mapped tiles in the order of use, last used at the back
+    std::list<size_t> mappedOrder_;
+    std::unordered_map<size_t, std::pair<double*, std::list<size_t>::iterator>> mapped_;
+
+    // Assembly contributions grouped by tile before writing
+    std::vector<Pending> pending_;
+};
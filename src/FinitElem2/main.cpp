@@ -1,13 +1,31 @@
 #include "stdafx.h"
+#include "TiledMatrix.h"
 #include "Model.h"
 
+// Default memory budget of out-of-core mode in megabytes
+static const size_t g_defaultMemoryBudget = 1024;
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " [model file]" << std::endl;
+    std::string modelFile;
+    std::string scratchFile;
+    size_t memoryBudget = g_defaultMemoryBudget;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--out-of-core" && i + 1 < argc) {
+            scratchFile = argv[++i];
+        } else if (arg == "--memory" && i + 1 < argc) {
+            memoryBudget = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            modelFile = arg;
+        }
+    }
+    
+    if (modelFile.empty()) {
+        std::cout << "Usage: " << argv[0] << " [--out-of-core scratch file] [--memory MB] [model file]" << std::endl;
         return 0;
     }
     
-    std::string modelFile(argv[1]);
     Model model;
     if (!model.LoadFromFile(modelFile)) {
         std::cerr << "Unable to load model from file " << modelFile << std::endl;
@@ -20,16 +38,40 @@ int main(int argc, char* argv[]) {
     std::cout << "Loads: " << model.loads_.size() << std::endl;
     std::cout << "Elements: " << model.elements_.size() << std::endl;
     
-    model.PrepareSolve();
-    std::cout << "Prepared solution" << std::endl;
-    std::cout << "Created A and B" << std::endl;
-    std::cout << "Matrix A: " << std::endl << model.a_ << std::endl;
-    std::cout << "vector B: " << std::endl << model.b_ << std::endl;
+    if (!scratchFile.empty()) {
+        model.SetOutOfCore(scratchFile, memoryBudget * 1024 * 1024);
+    }
     
-    model.Solve();
-    std::cout << "Solved model" << std::endl;
-    std::cout << "Vector U: " << std::endl << model.u_ << std::endl;
-    std::cout << "vector N: " << std::endl << model.n_ << std::endl;
+    // Tiles of the scratch file are mapped while the system is built and solved
+    try {
+        if (!model.PrepareSolve()) {
+            std::cerr << "Unable to create scratch file " << scratchFile << std::endl;
+            return 0;
+        }
+        std::cout << "Prepared solution" << std::endl;
+        std::cout << "Created A and B" << std::endl;
+        if (model.outOfCore_) {
+            std::cout << "Matrix A: " << model.tiled_.TileCount() << "x" << model.tiled_.TileCount()
+                << " tiles of size " << model.tiled_.TileSize() << std::endl;
+        } else {
+            std::cout << "Matrix A: " << std::endl << model.a_ << std::endl;
+        }
+        std::cout << "vector B: " << std::endl << model.b_ << std::endl;
+        
+        if (!model.Solve()) {
+            std::cerr << "Matrix A is not positive definite" << std::endl;
+            return 0;
+        }
+        std::cout << "Solved model" << std::endl;
+        if (model.outOfCore_) {
+            std::cout << "Tile loads: " << model.tiled_.Loads() << std::endl;
+        }
+        std::cout << "Vector U: " << std::endl << model.u_ << std::endl;
+        std::cout << "vector N: " << std::endl << model.n_ << std::endl;
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
     
     return 0;
 }
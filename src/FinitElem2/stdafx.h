@@ -1,6 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include <armadillo>
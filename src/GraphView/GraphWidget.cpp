@@ -1,4 +1,5 @@
 #include "pch.h"
+#include "SearchStats.h"
 #include "GeometryUtils.h"
 #include "OptimizationModel.h"
 #include "GraphWidget.h"
@@ -19,6 +19,7 @@ public:
     void draw() FL_OVERRIDE;
 
     void set_model(const std::unique_ptr<Model>& m) { this->model_ = m.get(); }
+    void set_model(const Model* m) { this->model_ = m; }
 
     void set_plot(Function1D func, Area functionArea);
 
@@ -34,7 +35,7 @@ private:
     CoordinateFunction coordFunc_;
 
     Area area_ = {-1.0, 1.0, -1.0, 1.0};
-    Model *model_ = nullptr;
+    const Model *model_ = nullptr;
 
     double pixelX_ = 0.0, pixelY_ = 0.0;
 
@@ -1,4 +1,5 @@
 #include "pch.h"
+#include "SearchStats.h"
 #include "GeometryUtils.h"
 #include "OptimizationModel.h"
 
@@ -9,7 +10,7 @@
 
 void Model::init_search(Area functionArea, double e, Function1D f) {
     search_ = false;
-    counter_ = 0;
+    stats_.reset();
 
     area_ = functionArea;
     min_ = area_.xmin;
@@ -23,6 +24,29 @@ void Model::reset() {
     y1_ = y2_ = 0.0;
 }
 
+void Model::search_start() {
+    stats_.reset();
+    start();
+}
+
+void Model::search_step() {
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+
+    if (!search_) {
+        return;
+    }
+
+    auto t0 = Clock::now();
+    step();
+    stats_.add_step(Seconds(Clock::now() - t0).count());
+}
+
+double Model::evaluate(double x) {
+    stats_.add_evaluations(1);
+    return f_(x);
+}
+
 
 void Model::draw(CoordinateFunction coordFunc) const {
     // Draw current minimum
@@ -57,30 +81,23 @@ void Model::draw(CoordinateFunction coordFunc) const {
 
 void ScanModel::start() {
     search_ = true;
-    counter_ = 0;
 
     double len = max_ - min_;
     int N = 2 * len / e_ - 1;
     dx_ = len / (double)(N);
 
     x1_ = x2_ = min_;
-    y1_ = y2_ = f_(min_);
-    counter_++;
+    y1_ = y2_ = evaluate(min_);
 }
 
 void ScanModel::step() {
-    if (!search_) {
-        return;
-    }
-
     x2_ += dx_;
     if (x2_>max_) {
         x2_ = max_;
         stop();
     }
 
-    y2_ = f_(x2_);
-    counter_++;
+    y2_ = evaluate(x2_);
 
     if (y2_<y1_) {
         x1_ = x2_;
@@ -95,7 +112,6 @@ void ScanModel::step() {
 
 void FibModel::start() {
     search_ = true;
-    counter_ = 0;
 
     double len = max_ - min_;
     int N = int(len / e_);
@@ -110,16 +126,11 @@ void FibModel::start() {
     dm_ = len / double(fib_[k_]);
 
     x1_ = x2_ = min_;
-    y1_ = y2_ = f_(min_);
+    y1_ = y2_ = evaluate(min_);
     k_ -= 2;
-    counter_++;
 }
 
 void FibModel::step() {
-    if (!search_) {
-        return;
-    }
-
     if (k_<=1) {
         stop();
         return;
@@ -129,7 +140,7 @@ void FibModel::step() {
     y1_ = y2_;
 
     double x1 = x2_+dm_*fib_[k_];
-    double y1 = f_(x1), y2 = f_(x2_);
+    double y1 = evaluate(x1), y2 = evaluate(x2_);
 
     if (y1 < y2) {
         x2_ = x1 + dm_ * fib_[k_ - 1];
@@ -141,8 +152,7 @@ void FibModel::step() {
     y1_ = y2;
     k_ -= 2;
 
-    y2_ = f_(x2_);
-    counter_ += 3;
+    y2_ = evaluate(x2_);
 }
 
 
@@ -152,24 +162,17 @@ void FibModel::step() {
 
 void GradModel::start() {
     search_ = true;
-    counter_ = 0;
 
     dx_ = 100.0 * e_;
 
     x1_ = min_;
-    y1_ = f_(x1_);
+    y1_ = evaluate(x1_);
 
     x2_ = min_ + dx_;
-    y2_ = f_(x2_);
-
-    counter_ += 2;
+    y2_ = evaluate(x2_);
 }
 
 void GradModel::step() {
-    if (!search_) {
-        return;
-    }
-
     if (y1_<=y2_) {
         stop();
         return;
@@ -179,16 +182,14 @@ void GradModel::step() {
 
     if (x>max_) {
         x1_ = max_;
-        y1_ = f_(x1_);
-        counter_++;
+        y1_ = evaluate(x1_);
 
         stop();
         return;
     }
 
     x1_ = x2_; y1_ = y2_;
-    x2_ = x; y2_ = f_(x);
-    counter_++;
+    x2_ = x; y2_ = evaluate(x);
 }
 
 
@@ -198,24 +199,17 @@ void GradModel::step() {
 
 void BounceModel::start() {
     search_ = true;
-    counter_ = 0;
 
     dx_ = 100.0 * e_;
 
     x1_ = min_;
-    y1_ = f_(x1_);
+    y1_ = evaluate(x1_);
 
     x2_ = min_ + dx_;
-    y2_ = f_(x2_);
-
-    counter_ += 2;
+    y2_ = evaluate(x2_);
 }
 
 void BounceModel::step() {
-    if (!search_) {
-        return;
-    }
-
     if (y1_<=y2_) {
         stop();
         return;
@@ -225,16 +219,14 @@ void BounceModel::step() {
 
     if (x>max_) {
         x1_ = max_;
-        y1_ = f_(x1_);
-        counter_++;
+        y1_ = evaluate(x1_);
 
         stop();
         return;
     }
 
     x1_ = x2_; y1_ = y2_;
-    x2_ = x; y2_ = f_(x);
-    counter_++;
+    x2_ = x; y2_ = evaluate(x);
 }
 
 
@@ -244,25 +236,20 @@ void BounceModel::step() {
 
 void BolzanoModel::start() {
     search_ = true;
-    counter_ = 0;
 
     a_ = min_;
     b_ = max_;
     l_ = (b_ - a_) / 2.0;
 }
 
-void BolzanoModel::step(){
-    if (!search_) {
-        return;
-    }
-
+void BolzanoModel::step() {
     if (l_<=e_) {
         stop();
         return;
     }
 
     x1_ = (a_ + b_) / 2.0;
-    if (f_(x1_+e_)>=f_(x1_-e_)) {
+    if (evaluate(x1_+e_)>=evaluate(x1_-e_)) {
         b_ = x1_;
         a_ = a_;
     }
@@ -273,7 +260,5 @@ void BolzanoModel::step(){
     l_ = (b_ - a_) / 2.0;
 
     x2_ = x1_;
-    y2_ = y1_ = f_(x1_);
-
-    counter_ += 3;
+    y2_ = y1_ = evaluate(x1_);
 }
@@ -10,10 +10,15 @@ public:
     Model() = default;
     virtual ~Model() { }
 
-    virtual void start() { }
-    virtual void step() { }
+    // Restart the statistics and the search, steps are timed
+    void search_start();
+    void search_step();
+
     virtual double timer_interval() const { return DefaultTimerInterval; }
 
+    // Copy of the model drawn while the model runs on another thread
+    virtual std::unique_ptr<Model> clone() const { return std::make_unique<Model>(*this); }
+
     // Name of the model displayed in the program UI
     virtual const char* name() const { return "Unimplemented"; }
 
@@ -24,7 +29,10 @@ public:
     void stop() { search_ = false; }
 
     bool search() const { return search_; }
-    int counter() const { return counter_; }
+
+    // Evaluations of the function and times of the steps since the start
+    const SearchStats& stats() const { return stats_; }
+    int counter() const { return static_cast<int>(stats_.evaluations()); }
 
     double x1() const { return x1_; }
     double y1() const { return y1_; }
@@ -32,9 +40,16 @@ public:
     void init_search(Area functionArea, double e, Function1D f);
     void reset();
 
+protected:
+    virtual void start() { }
+    virtual void step() { }
+
+    // The function of the search, every evaluation is counted
+    double evaluate(double x);
+
 protected:
     bool search_ = false;
-    int counter_ = 0;
+    SearchStats stats_;
 
     Area area_ = {-1.0, 1.0, -1.0, 1.0};
     double min_ = 0.0, max_ = 0.0;
@@ -51,13 +66,15 @@ protected:
 class ScanModel: public Model {
 public:
     ScanModel() = default;
-    void start();
-    void step();
 
     double timer_interval() const { return 0.0025; }
     const char* name() const override { return "Scanning"; }
+    std::unique_ptr<Model> clone() const override { return std::make_unique<ScanModel>(*this); }
 
 protected:
+    void start() override;
+    void step() override;
+
     double dx_ = 0.0;
 };
 
@@ -68,12 +85,14 @@ class FibModel: public Model {
 public:
     FibModel() = default;
 
-    void start();
-    void step();
     double timer_interval() const { return 1.0; }
     const char* name() const override { return "Fibonacci"; }
+    std::unique_ptr<Model> clone() const override { return std::make_unique<FibModel>(*this); }
 
 protected:
+    void start() override;
+    void step() override;
+
     int fib_[50] = { 1 };
     int k_ = 0;
 
@@ -87,12 +106,14 @@ class GradModel: public Model {
 public:
     GradModel() = default;
 
-    void start();
-    void step();
     double timer_interval() const { return 0.1; }
     const char* name() const override { return "Gradient descent"; }
+    std::unique_ptr<Model> clone() const override { return std::make_unique<GradModel>(*this); }
 
 protected:
+    void start() override;
+    void step() override;
+
     double dx_ = 0.0;
 };
 
@@ -103,12 +124,14 @@ class BounceModel: public Model {
 public:
     BounceModel() = default;
 
-    void start();
-    void step();
     double timer_interval() const { return 0.1; }
     const char* name() const override { return "Heavy-ball method"; }
+    std::unique_ptr<Model> clone() const override { return std::make_unique<BounceModel>(*this); }
 
 protected:
+    void start() override;
+    void step() override;
+
     double dx_ = 0.0;
 };
 
@@ -119,12 +142,14 @@ class BolzanoModel: public Model {
 public:
     BolzanoModel() = default;
 
-    void start();
-    void step();
     double timer_interval() const { return 0.5; }
     const char* name() const override { return "Bolzano"; }
+    std::unique_ptr<Model> clone() const override { return std::make_unique<BolzanoModel>(*this); }
 
 protected:
+    void start() override;
+    void step() override;
+
     double l_ = 0.0;
     double a_ = 0.0, b_ = 0.0;
 };
@@ -6,6 +6,9 @@
  ****************************************************************************/
 
 #include "pch.h"
+#include "SnapshotSlot.h"
+#include "BackgroundSolver.h"
+#include "SearchStats.h"
 #include "GeometryUtils.h"
 #include "OptimizationModel.h"
 #include "GraphWidget.h"
@@ -21,6 +24,9 @@ const Area FunctionArea = {
 
 constexpr double Epsilon = 1e-3;
 
+// Models run on a worker thread, the window shows their latest state at the display rate
+constexpr double DisplayInterval = 1.0 / 60.0;
+
 
 /*****************************************************************************
  * Functions to evaluate
@@ -61,15 +67,19 @@ private:
 
     const ModelPtr& GetCurrentModel() const { return models[currentModel]; }
 
-private:
-    double timerInterval = 0.0025;
+    // Latest copy of the model while the solver runs, the model otherwise
+    const Model* GetShownModel();
 
+private:
     int currentFunction = 0;
 
     int currentModel = 0;
     std::vector<ModelPtr> models;
 
+    BackgroundSolver<Model> solver;
+
     GraphWidget *graph = nullptr;
+    Fl_Check_Button *fullSpeedButton = nullptr;
     Fl_Text_Buffer *buffer = nullptr;
     std::vector<Fl_Button*> modelButtons;
 };
@@ -121,9 +131,12 @@ MainWindow::MainWindow(int w, int h, const char* lbl)
 
     modelChooser->end();
 
-    auto btn = new Fl_Button(550, 275, 90, 25, "Search");
+    auto btn = new Fl_Button(500, 275, 90, 25, "Search");
     btn->callback(MainWindow::SearchCb, static_cast<void *>(this));
 
+    // Steps are paced by the model unless the search runs at full speed
+    fullSpeedButton = new Fl_Check_Button(600, 275, 90, 25, "Full speed");
+
     // Output
     buffer = new Fl_Text_Buffer(1024);
 
@@ -142,12 +155,22 @@ void MainWindow::SearchCb(Fl_Widget * /*w*/, void *p) {
 }
 
 void MainWindow::SearchFunc() {
-    if (GetCurrentModel()->search()) {
-        StopSearch();
-    }
+    StopSearch();
+
+    const auto& model = GetCurrentModel();
+    model->search_start();
+
+    double interval = fullSpeedButton->value() ? 0.0 : model->timer_interval();
+    solver.start(*model, [](Model& m) {
+        m.search_step();
+        return m.search();
+    }, interval, DisplayInterval);
+
+    // The model belongs to the worker now, the graph shows its first copy
+    solver.update();
+    Refresh();
 
-    GetCurrentModel()->start();
-    Fl::add_timeout(timerInterval, TimerCb, static_cast<void *>(this));
+    Fl::add_timeout(DisplayInterval, TimerCb, static_cast<void *>(this));
 }
 
 void MainWindow::TimerCb(void *p) {
@@ -156,11 +179,17 @@ void MainWindow::TimerCb(void *p) {
 }
 
 void MainWindow::TimerFunc() {
-    GetCurrentModel()->step();
-    Refresh();
-    if (GetCurrentModel()->search()) {
-        Fl::repeat_timeout(timerInterval, MainWindow::TimerCb, static_cast<void*>(this));
+    if (solver.running()) {
+        Fl::repeat_timeout(DisplayInterval, MainWindow::TimerCb, static_cast<void*>(this));
+        if (solver.update()) {
+            Refresh();
+        }
+        return;
     }
+
+    // The search is over, the worker is joined and the model is shown
+    solver.stop();
+    Refresh();
 }
 
 void MainWindow::SetFuncCb(Fl_Widget *w, void *p) {
@@ -172,9 +201,7 @@ void MainWindow::SetFuncCb(Fl_Widget *w, void *p) {
 }
 
 void MainWindow::SetFunc(int n) {
-    if (GetCurrentModel()->search()) {
-        StopSearch();
-    }
+    StopSearch();
 
     currentFunction = n;
 
@@ -197,24 +224,29 @@ void MainWindow::SetModelCb(Fl_Widget * /*w*/, void *p) {
 }
 
 void MainWindow::SetModelFunc() {
-    if (GetCurrentModel()->search()) {
-        StopSearch();
-    }
+    StopSearch();
 
     currentModel = GetSelectedModelId();
 
-    timerInterval = GetCurrentModel()->timer_interval();
     GetCurrentModel()->reset();
-    graph->set_model(GetCurrentModel());
     Refresh();
 }
 
 void MainWindow::StopSearch() {
     Fl::remove_timeout(MainWindow::TimerCb);
+    solver.stop();
     GetCurrentModel()->stop();
 }
 
+const Model* MainWindow::GetShownModel() {
+    auto snapshot = solver.running() ? solver.snapshot() : nullptr;
+    return snapshot ? snapshot : GetCurrentModel().get();
+}
+
 void MainWindow::Refresh() {
+    auto model = GetShownModel();
+
+    graph->set_model(model);
     graph->redraw();
 
     buffer->select(0, buffer->length());
@@ -223,14 +255,14 @@ void MainWindow::Refresh() {
     auto funcData = FunctionsData[currentFunction];
     auto funcName = std::get<1>(funcData);
 
-    const auto& model = GetCurrentModel();
-
     std::stringstream s;
     s << "Funcion: " << funcName << std::endl <<
         "Epsilon: " << std::fixed << std::setprecision(6) << Epsilon << std::endl <<
         "Min X: " << std::fixed << std::setprecision(6) << model->x1() << std::endl <<
         "Min Y: " << std::fixed << std::setprecision(6) << model->y1() << std::endl <<
         "FuncCalcCount: " << model->counter() << std::endl <<
+        "Step P50/P99: " << std::setprecision(0) << model->stats().percentile(0.5) * 1e6 <<
+            "/" << model->stats().percentile(0.99) * 1e6 << " us" << std::endl <<
         "Status: " << (model->search() ? "Searching" : "Complete") << std::endl;
 
     buffer->insert(0, s.str().c_str());
@@ -1,4 +1,6 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
 #include "MathUtils.h"
 #include "PlotWidget.h"
 
@@ -16,14 +18,6 @@ static const std::vector<Fl_Color> Palette = {
     fl_rgb_color(0x31, 0x36, 0x95),
 };
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-#define SET_FL_COLOR_TO_GL(c) { \
-    GLubyte r, g, b, a; \
-    Fl::get_color((c), r, g, b, a); \
-    glColor4ub(r, g, b, a); \
-    }
-#endif
-
 PlotWidget::PlotWidget(int X, int Y, int W, int H, const char* lbl)
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
     : Fl_Gl_Window(X, Y, W, H, lbl) {
@@ -86,330 +80,134 @@ void PlotWidget::ticks(int count, int size) {
     this->tick_count_ = count;
     this->tick_size_ = size;
 
-    ticks_x.resize((tick_count_ + 1) * 2);
-    ticks_y.resize((tick_count_ + 1) * 2);
-
     pixel_scale();
-
-    // Calculate x&y tick positions
-    float dtick;
-    float x, y, tick_scale;
-
-    // Y ticks
-    dtick = (ymax_ - ymin_) / tick_count_;
-    for (int i = 0; i <= tick_count_; i++) {
-        y = ymin_ + i * dtick;
-
-        ticks_y[i * 2].x = xmin_;
-        ticks_y[i * 2].y = y;
-
-        tick_scale = (i % 2) ? 0.5 : 1.0;
-        ticks_y[i * 2 + 1].x = xmin_ - tick_size_ * pixel_x * tick_scale;
-        ticks_y[i * 2 + 1].y = y;
-    }
-
-    // X ticks
-    dtick = (xmax_ - xmin_) / tick_count_;
-    for (int i = 0; i <= tick_count_; i++) {
-        x = xmin_ + i * dtick;
-
-        ticks_x[i * 2].x = x;
-        ticks_x[i * 2].y = ymin_;
-
-        tick_scale = (i % 2) ? 0.5 : 1.0; // 1.0
-        ticks_x[i * 2 + 1].x = x;
-        ticks_x[i * 2 + 1].y = ymin_ - tick_size_ * pixel_y * tick_scale;
-    }
 }
 
 void PlotWidget::margin(int m) {
     this->margin_ = m;
 }
 
-void PlotWidget::print_text(float x, float y, uint8_t align, const char* fmt, ...) {
-    const size_t BufferLen = 256;
-    char text[BufferLen] = { 0 };
-    va_list ap;
-
-    if (!fmt) {
-        return;
-    }
-
-    va_start(ap, fmt);
-    vsnprintf(text, BufferLen-1, fmt, ap);
-    va_end(ap);
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    void* font = GLUT_BITMAP_HELVETICA_12;
-
-    int w, h;
-    h = glutBitmapHeight(font);
-
-    w = 0;
-    char* p = (char*)text;
-    while (*p != '\0') {
-        w += glutBitmapWidth(font, *p);
-        p++;
-    }
-
-    float tx, ty, tw, th;
-    tx = x;
-    ty = y;
-    tw = w * pixel_x;
-    th = h * pixel_y;
-
-    if (align == TextAlign::Unspecified) align = TextAlign::Default;
-
-    if (align & TextAlign::Left) tx -= tw;
-    else if (align & TextAlign::Center) tx -= tw / 2;
-
-    if (align & TextAlign::Bottom) ty -= th;
-    else if (align & TextAlign::Middle) ty -= th / 2;
-
-    glRasterPos2d(tx, ty);
-    glutBitmapString(font, (const unsigned char*)text);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_font(FL_HELVETICA, 14);
-
-    int w{ 0 }, h{ 0 };
-    fl_measure(text, w, h);
-
-    float x0{ get_x(x) }, y0{ get_y(y) };
-
-    if (align & TextAlign::Left) {
-        x0 -= w;
-    }
-    else if (align & TextAlign::Center) {
-        x0 -= w / 2;
-    }
+void PlotWidget::draw_box(Painter& painter) const {
+    painter.set_color(tick_color);
 
-    if (align & TextAlign::Bottom) {
-        y0 += h;
-    }
-    else if (align & TextAlign::Middle) {
-        y0 += h / 2;
-    }
-
-    fl_draw(text, x0, y0);
-#endif
+    painter.line(xmin_, ymin_, xmax_, ymin_);
+    painter.line(xmax_, ymin_, xmax_, ymax_);
+    painter.line(xmax_, ymax_, xmin_, ymax_);
+    painter.line(xmin_, ymax_, xmin_, ymin_);
 }
 
-void PlotWidget::draw_box() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(tick_color);
-
-    glBegin(GL_LINE_LOOP);
-    glVertex2f(xmin_, ymin_);
-    glVertex2f(xmax_, ymin_);
-    glVertex2f(xmax_, ymax_);
-    glVertex2f(xmin_, ymax_);
-    glEnd();
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(tick_color);
-
-    fl_loop(
-        get_x(xmin_), get_y(ymin_),
-        get_x(xmax_), get_y(ymin_),
-        get_x(xmax_), get_y(ymax_),
-        get_x(xmin_), get_y(ymax_));
-#endif
-}
+void PlotWidget::draw_ticks(Painter& painter, float px, float py) const {
+    painter.set_color(tick_color);
 
-void PlotWidget::draw_ticks() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(tick_color);
-    glBegin(GL_LINES);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(tick_color);
-#endif
+    for (int i = 0; i <= tick_count_; i++) {
+        float tick_scale = (i % 2) ? 0.5f : 1.0f;
 
-    if (ticks_x.size() > 0) {
-        for (int i = 0; i <= tick_count_; i++) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-            glVertex2f(ticks_x[i * 2].x, ticks_x[i * 2].y);
-            glVertex2f(ticks_x[i * 2 + 1].x, ticks_x[i * 2 + 1].y);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-            fl_line(get_x(ticks_x[i * 2].x), get_y(ticks_x[i * 2].y),
-                get_x(ticks_x[i * 2 + 1].x), get_y(ticks_x[i * 2 + 1].y));
-#endif
-        }
-    }
+        float x = xmin_ + i * (xmax_ - xmin_) / tick_count_;
+        painter.line(x, ymin_, x, ymin_ - tick_size_ * py * tick_scale);
 
-    if (ticks_x.size() > 0) {
-        for (int i = 0; i <= tick_count_; i++) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-            glVertex2f(ticks_y[i * 2].x, ticks_y[i * 2].y);
-            glVertex2f(ticks_y[i * 2 + 1].x, ticks_y[i * 2 + 1].y);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-            fl_line(get_x(ticks_y[i * 2].x), get_y(ticks_y[i * 2].y),
-                get_x(ticks_y[i * 2+1].x), get_y(ticks_y[i * 2+1].y));
-#endif
-        }
+        float y = ymin_ + i * (ymax_ - ymin_) / tick_count_;
+        painter.line(xmin_, y, xmin_ - tick_size_ * px * tick_scale, y);
     }
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glEnd();
-#endif
 }
 
-void PlotWidget::draw_axis() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(axis_color);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(axis_color);
-#endif
+void PlotWidget::draw_axis(Painter& painter) const {
+    painter.set_color(axis_color);
 
     // X axis
     if (betweenf(ymin_, xaxis_, ymax_)) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        glBegin(GL_LINES);
-        glVertex2f(xmin_, xaxis_);
-        glVertex2f(xmax_, xaxis_);
-        glEnd();
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_line(get_x(xmin_), get_y(xaxis_),
-            get_x(xmax_), get_y(xaxis_));
-#endif
+        painter.line(xmin_, xaxis_, xmax_, xaxis_);
     }
 
     // Y axis
     if (betweenf(ymin_, yaxis_, ymax_)) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        glBegin(GL_LINES);
-        glVertex2f(xmin_, yaxis_);
-        glVertex2f(xmax_, yaxis_);
-        glEnd();
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_line(get_x(xmin_), get_y(yaxis_),
-            get_x(xmax_), get_y(yaxis_));
-#endif
+        painter.line(xmin_, yaxis_, xmax_, yaxis_);
     }
 }
 
-void PlotWidget::draw_heatmap() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glBegin(GL_QUADS);
-#endif
-    if (points.size() > 0) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        for (int i = 0; i < point_count_; i++) {
-            double y = points[i * 2].y;
-            double t = 1. - (y - ymin_) / (ymax_ - ymin_);
-            size_t k = static_cast<size_t>((static_cast<double>(Palette.size() - 1) * t));
+void PlotWidget::draw_heatmap(Painter& painter) const {
+    if (points.empty()) {
+        return;
+    }
 
-            SET_FL_COLOR_TO_GL(Palette[k]);
+    // Bars take the color of their height, the heatmap wraps around the palette
+    auto level = [this](float y) {
+        float t = 1.f - (y - ymin_) / (ymax_ - ymin_);
+        size_t k = bar_plot_ ?
+            static_cast<size_t>(static_cast<float>(Palette.size() - 1) * t) :
+            static_cast<size_t>(static_cast<float>(Palette.size()) * t) % Palette.size();
+        return std::min(k, Palette.size() - 1);
+    };
 
-            glVertex2f(points[i * 2].x, bar_plot_ ? 0 : ymin_);
-            glVertex2f(points[i * 2 + 1].x, bar_plot_ ? 0 : ymin_);
-            glVertex2f(points[i * 2 + 1].x, bar_plot_ ? y : ymax_);
-            glVertex2f(points[i * 2].x, bar_plot_ ? y : ymax_);
-        }
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        if (bar_plot_) {
-            for (int i = 0; i < point_count_; i++) {
-                double y = points[i * 2].y;
-                double t = 1. - (y - ymin_) / (ymax_ - ymin_);
-                size_t k = static_cast<size_t>((static_cast<double>(Palette.size() - 1) * t));
-
-                fl_color(Palette[k]);
-
-                fl_polygon(
-                    get_x(points[i * 2].x), get_y(bar_plot_ ? 0 : ymin_),
-                    get_x(points[i * 2 + 1].x), get_y(bar_plot_ ? 0 : ymin_),
-                    get_x(points[i * 2 + 1].x), get_y(bar_plot_ ? y : ymax_),
-                    get_x(points[i * 2].x), get_y(bar_plot_ ? y : ymax_)
-                );
-            }
-        }
-        else {
-            size_t kPrev{ 0 };
-            int j{ 0 };
-
-            for (int i = 0; i <= point_count_; i++) {
-                double y = points[i * 2].y;
-                double t = 1. - (y - ymin_) / (ymax_ - ymin_);
-                size_t k = static_cast<size_t>((static_cast<double>(Palette.size()) * t)) % Palette.size();
-                if (i == 0) {
-                    kPrev = k;
-                    continue;
-                }
-
-                if (k != kPrev || (i == point_count_)) {
-                    // Level changed, draw new part of heatmap
-
-                    fl_color(Palette[kPrev]);
-                    fl_polygon(
-                        get_x(points[j * 2].x), get_y(ymin_),
-                        get_x(points[(i - 1) * 2 + 1].x), get_y(ymin_),
-                        get_x(points[(i - 1) * 2 + 1].x), get_y(ymax_),
-                        get_x(points[j * 2].x), get_y(ymax_)
-                    );
-
-                    // Mark start of the next heatmap part
-                    j = i;
-                }
-
-                kPrev = k;
-            }
+    if (bar_plot_) {
+        for (int i = 0; i < point_count_; i++) {
+            float y = points[i * 2].y;
+            painter.set_color(Palette[level(y)]);
+            painter.rectangle(points[i * 2].x, 0, points[i * 2 + 1].x, y);
         }
-#endif
+        return;
     }
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glEnd();
-#endif
-}
+    // Neighbour points of the same level are filled at once
+    int first = 0;
+    for (int i = 1; i <= point_count_; i++) {
+        size_t k = level(points[first * 2].y);
+        if (i < point_count_ && level(points[i * 2].y) == k) {
+            continue;
+        }
 
-void PlotWidget::draw_plot() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(plot_color);
-    glBegin(GL_LINES);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(plot_color);
-#endif
+        painter.set_color(Palette[k]);
+        painter.rectangle(points[first * 2].x, ymin_, points[(i - 1) * 2 + 1].x, ymax_);
+        first = i;
+    }
+}
 
-    if (points.size() > 0) {
-        for (int i = 0; i < point_count_; i++) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-            glVertex2f(points[i * 2].x, points[i * 2].y);
-            glVertex2f(points[i * 2 + 1].x, points[i * 2 + 1].y);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-            fl_line(get_x(points[i * 2].x), get_y(points[i * 2].y),
-                get_x(points[i * 2 + 1].x), get_y(points[i * 2 + 1].y));
-#endif
-        }
+void PlotWidget::draw_plot(Painter& painter) const {
+    if (points.empty()) {
+        return;
     }
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glEnd();
-#endif
+    painter.set_color(plot_color);
+    painter.lines(reinterpret_cast<const float*>(points.data()), point_count_ * 2);
 }
 
-void PlotWidget::draw_legend() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(text_color);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(text_color);
-#endif
+void PlotWidget::draw_legend(Painter& painter, float px, float py) const {
+    painter.set_color(text_color);
+    painter.set_text_size(PlotDefaults::TextSize);
 
-    print_text((xmax_ - xmin_) / 2.0, ymax_ + margin_ * pixel_y / 2.0,
-        TextAlign::Center | TextAlign::Middle, this->label());
+    painter.text((xmax_ - xmin_) / 2.0f, ymax_ + margin_ * py / 2.0f,
+        TextAlign::Center | TextAlign::Middle, "%s", this->label() ? this->label() : "");
 
-    print_text(-tick_size_ * pixel_x, 0.0,
+    painter.text(-tick_size_ * px, 0.0f,
         TextAlign::Left | TextAlign::Middle, "%.1f", 0.0);
 
-    print_text(xmin_ - tick_size_ * pixel_x, ymin_,
+    painter.text(xmin_ - tick_size_ * px, ymin_,
         TextAlign::Left | TextAlign::Middle, "%.1f", ymin_);
 
-    print_text(xmin_ - tick_size_ * pixel_x, ymax_,
+    painter.text(xmin_ - tick_size_ * px, ymax_,
         TextAlign::Left | TextAlign::Middle, "%.1f", ymax_);
 
-    print_text(xmin_, ymin_ - tick_size_ * pixel_y,
+    painter.text(xmin_, ymin_ - tick_size_ * py,
         TextAlign::Center | TextAlign::Bottom, "%.1f", xmin_);
-    print_text(xmax_, ymin_ - tick_size_ * pixel_y,
+    painter.text(xmax_, ymin_ - tick_size_ * py,
         TextAlign::Center | TextAlign::Bottom, "%.1f", xmax_);
 }
 
+void PlotWidget::paint(Painter& painter, float px, float py) const {
+    painter.set_line_width(1);
+
+    draw_heatmap(painter);
+
+    // Draw ticks and bounding box
+    draw_box(painter);
+    draw_ticks(painter, px, py);
+
+    draw_axis(painter);
+
+    draw_legend(painter, px, py);
+
+    draw_plot(painter);
+}
+
 void PlotWidget::draw() {
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
     if (!this->valid()) {
@@ -443,26 +241,22 @@ void PlotWidget::draw() {
 #endif
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
+    // Plot coordinates are set by the projection
+    ScreenPainter painter([](double x) { return x; }, [](double y) { return y; });
+
     glClear(GL_COLOR_BUFFER_BIT);
     glLoadIdentity();
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
+    ScreenPainter painter(PlotToPixelX(xmin_, pixel_x, margin_ + tick_size_),
+        PlotToPixelY(ymax_, pixel_y, margin_));
+
     fl_begin_offscreen(offscreen_);
 
     fl_color(fl_rgb_color(255));
     fl_rectf(0, 0, this->w(), this->h());
 #endif
 
-    draw_heatmap();
-
-    // Draw ticks and bounding box
-    draw_box();
-    draw_ticks();
-
-    draw_axis();
-
-    draw_legend();
-
-    draw_plot();
+    paint(painter, pixel_x, pixel_y);
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
     glFinish();
@@ -474,12 +268,16 @@ void PlotWidget::draw() {
 #endif
 }
 
-float PlotWidget::get_x(float x) const {
-    return (x - xmin_) / pixel_x + margin_ + tick_size_;
-}
+void PlotWidget::render(Canvas& canvas, int x, int y, int w, int h) const {
+    float px = (xmax_ - xmin_) / (w - margin_ * 2 - tick_size_);
+    float py = (ymax_ - ymin_) / (h - margin_ * 2 - tick_size_);
+
+    canvas.set_color({ 255, 255, 255, 255 });
+    canvas.fill_rectangle(x, y, x + w, y + h);
 
-float PlotWidget::get_y(float y) const {
-    return (ymax_ - y) / pixel_y + margin_;
+    CanvasPainter painter(canvas, PlotToPixelX(xmin_, px, margin_ + tick_size_ + x),
+        PlotToPixelY(ymax_, py, margin_ + y));
+    paint(painter, px, py);
 }
 
 void PlotWidget::plot(int count, const std::vector<float>& x, const std::vector<float>& y) {
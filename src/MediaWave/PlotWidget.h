@@ -6,6 +6,9 @@
 #define DRAW_METHOD DRAW_METHOD_FLTK
 #endif
 
+class Canvas;
+class Painter;
+
 namespace PlotDefaults {
     const float XMin = -1.0;
     const float XMax = 1.0;
@@ -18,20 +21,8 @@ namespace PlotDefaults {
     const int Margin = 25;
     const int TickSize = 10;
     const int TickCount = 20;
-}
-
-namespace TextAlign {
-    const uint8_t Unspecified = 0x00;
-
-    const uint8_t Top = 0x01;
-    const uint8_t Middle = 0x02;
-    const uint8_t Bottom = 0x04;
 
-    const uint8_t Left = 0x10;
-    const uint8_t Center = 0x20;
-    const uint8_t Right = 0x40;
-
-    const uint8_t Default = TextAlign::Right | TextAlign::Top;
+    const int TextSize = 14;
 }
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
@@ -57,20 +48,22 @@ public:
 
     void bar_plot(bool b) { bar_plot_ = b; }
 
+    // Rasterise the plot on the CPU into the rectangle of the canvas,
+    // the widget does not need to be shown
+    void render(Canvas& canvas, int x, int y, int w, int h) const;
+
 private:
     void pixel_scale();
 
-    void draw_box();
-    void draw_ticks();
-    void draw_axis();
-    void draw_heatmap();
-    void draw_plot();
-    void draw_legend();
-
-    float get_x(float x) const;
-    float get_y(float y) const;
+    // Plot shared by the screen and rendered images, pixel sizes are in plot units
+    void paint(Painter& painter, float px, float py) const;
 
-    void print_text(float, float, uint8_t, const char*, ...);
+    void draw_box(Painter& painter) const;
+    void draw_ticks(Painter& painter, float px, float py) const;
+    void draw_axis(Painter& painter) const;
+    void draw_heatmap(Painter& painter) const;
+    void draw_plot(Painter& painter) const;
+    void draw_legend(Painter& painter, float px, float py) const;
 
     void axis(float, float);
     void margin(int);
@@ -81,8 +74,6 @@ private:
     int tick_count_, tick_size_, margin_;
 
     float pixel_x, pixel_y;
-    std::vector<Point2D> ticks_x;
-    std::vector<Point2D> ticks_y;
 
     int point_count_;
     std::vector<Point2D> points;
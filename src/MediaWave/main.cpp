@@ -3,6 +3,8 @@
  */
 
 #include "pch.h"
+#include "Canvas.h"
+#include "Headless.h"
 #include "MediumModel.h"
 #include "PlotWidget.h"
 #include "MainWindow.h"
@@ -12,9 +14,37 @@
  * Main
  */
 int main (int argc, char *argv[]) {
-    Fl::scheme("gtk+");
-
     MediumModel model(DefL, DefN);
+
+    if (argc > 3 && strcmp(argv[1], "--render") == 0) {
+        constexpr int RenderWidth = 480;
+        constexpr int RenderHeight = 480;
+        int frames = atoi(argv[3]);
+        int width = (argc > 5) ? atoi(argv[4]) : RenderWidth;
+        int height = (argc > 5) ? atoi(argv[5]) : RenderHeight;
+
+        // Both plots of the main window one above the other, no display is opened
+        PlotWidget uw(0, 0, width, height / 2, "u(x)");
+        PlotWidget pw(0, height / 2, width, height - height / 2, "p(x)");
+        uw.view_range(0.0, model.L, -2.0, 2.0);
+        uw.ticks(PlotDefaults::TickCount, PlotDefaults::TickSize);
+        pw.view_range(0.0, model.L, -2.0, 2.0);
+        pw.ticks(PlotDefaults::TickCount, PlotDefaults::TickSize);
+
+        return RenderFrames(argv[2], width, height, [&](int frame, Canvas& canvas) {
+            if (frame >= frames) {
+                return false;
+            }
+            uw.plot(model.N, model.x, model.u1);
+            pw.plot(model.N, model.x, model.p1);
+            uw.render(canvas, 0, 0, width, height / 2);
+            pw.render(canvas, 0, height / 2, width, height - height / 2);
+            model.Step();
+            return true;
+        });
+    }
+
+    Fl::scheme("gtk+");
     // model.Reset();
 
 #if !defined(DRAW_OPENGL) && !defined(WIN32) && !defined(__APPLE__)
@@ -17,7 +17,17 @@
 #include <FL/Fl_Check_Button.H>
 #include <FL/Fl_Tree.H>
 
+#include <algorithm>
 #include <array>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
@@ -0,0 +1,413 @@
+#include "pch.h"
+#include "Canvas.h"
+#include "SearchStats.h"
+#include "MathUtils.h"
+#include "FuncUtils.h"
+#include "GraphUtils.h"
+#include "Objective.h"
+#include "EvaluationCache.h"
+#include "NelderMead.h"
+#include "Simplex.h"
+#include "SimplexHistory.h"
+#include "SearchEngine.h"
+#include "SimplexEngine.h"
+#include "GaussSEngine.h"
+#include "DescentEngine.h"
+#include "RelaxationEngine.h"
+#include "BfgsEngine.h"
+#include "LineSearch.h"
+#include "Lbfgs.h"
+#include "LbfgsEngine.h"
+#include "ScanEngine.h"
+#include "MultiStartEngine.h"
+#include "Benchmark.h"
+
+namespace BenchmarkParams {
+    // Start points on a square grid inside the domain
+    constexpr int StartGrid = 5;
+    constexpr double StartMargin = 1.0;
+
+    // Runs that take longer are stopped and count as failures
+    constexpr int MaxSteps = 10000;
+    constexpr int MaxEvaluations = 1000000;
+
+    // The scan of the whole grid takes about 4 million evaluations
+    const std::string ScanEngineName = "Scan";
+    constexpr int MaxScanEvaluations = 5000000;
+
+    // Found value is this close to the global minimum in a successful run
+    constexpr double SuccessTolerance = 1e-3;
+
+    // Functions of many parameters are minimized by the Nelder-Mead method
+    // from scaled copies of the classic start point (-1.2, 1, -1.2, 1, ...)
+    const std::vector<size_t> Dimensions = { 5, 10, 20, 50 };
+    const std::vector<double> StartScales = { 0.5, 1.0, 1.5, 2.0 };
+    constexpr double SimplexStep = 1.0;
+    constexpr double SimplexTolerance = 1e-8;
+
+    // L-BFGS method on the same functions, up to sizes Nelder-Mead cannot handle
+    const std::vector<size_t> LbfgsDimensions = { 5, 10, 20, 50, 1000 };
+    constexpr size_t LbfgsMemory = 7;
+    constexpr double GradientTolerance = 1e-6;
+
+    // Engines with line searches take a few evaluations per step, scanning
+    // the line took thousands. More than this many fail the benchmark
+    const std::vector<std::string> LineSearchEngines = { "Descent", "Coordinate", "BFGS", "L-BFGS" };
+    constexpr double MaxEvaluationsPerStep = 50.0;
+
+    // Global minima of the built-in objectives
+    const std::vector<std::tuple<std::string, double>> Minima = {
+        {"Himmelblau", 0.0},
+        {"Rosenbrock", 0.0},
+        {"Rastrigin", 0.0},
+        {"Beale", 0.0},
+        {"Booth", 0.0},
+        {"Curved valley", 0.0}
+    };
+}
+
+struct BenchmarkResult {
+    std::string objective;
+    std::string engine;
+    int runs{ 0 };
+    int successes{ 0 };
+    double evaluations{ 0.0 };
+    double hits{ 0.0 }; // Evaluations taken from the cache
+    double steps{ 0.0 };
+    double time{ 0.0 };
+    double medianError{ 0.0 };
+    double maxError{ 0.0 };
+
+    // Step times of all runs, only the engines time their steps
+    SearchStats stats;
+};
+
+BenchmarkResult RunEngine(SearchEngine& engine, double zmin, int maxEvaluations) {
+    using namespace BenchmarkParams;
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    BenchmarkResult result;
+    std::vector<double> errors;
+
+    for (int j = 0; j < StartGrid; j++) {
+        for (int i = 0; i < StartGrid; i++) {
+            double x = XMin + StartMargin + (XMax - XMin - 2.0 * StartMargin) * i / (StartGrid - 1);
+            double y = YMin + StartMargin + (YMax - YMin - 2.0 * StartMargin) * j / (StartGrid - 1);
+
+            // Every run starts without cached points
+            EvaluationCache& cache = EvaluationCache::shared();
+            cache.clear();
+            cache.reset_counters();
+
+            auto t0 = Clock::now();
+            engine.set_start_point(static_cast<float>(x), static_cast<float>(y));
+            int steps = 0;
+            while (!engine.search_over() && steps < MaxSteps && engine.count() < maxEvaluations) {
+                engine.search_step();
+                steps++;
+            }
+            auto t1 = Clock::now();
+
+            double error = engine.zmin() - zmin;
+            errors.push_back(error);
+
+            result.runs++;
+            if (engine.search_over() && error < SuccessTolerance) {
+                result.successes++;
+            }
+            result.evaluations += engine.count();
+            result.hits += static_cast<double>(cache.hits());
+            result.steps += steps;
+            result.time += Milliseconds(t1 - t0).count();
+            result.stats.merge(engine.stats());
+        }
+    }
+
+    result.evaluations /= result.runs;
+    result.hits /= result.runs;
+    result.steps /= result.runs;
+    result.time /= result.runs;
+
+    std::sort(errors.begin(), errors.end());
+    result.medianError = errors[errors.size() / 2];
+    result.maxError = errors.back();
+    return result;
+}
+
+// Test functions of n parameters, both have the minimum 0
+double Ellipsoid(const double* x, size_t n) {
+    double f = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        f += static_cast<double>(i + 1) * x[i] * x[i];
+    }
+    return f;
+}
+
+double ExtendedRosenbrock(const double* x, size_t n) {
+    double f = 0.0;
+    for (size_t i = 0; i + 1 < n; i++) {
+        double a = 1.0 - x[i];
+        double b = x[i + 1] - x[i] * x[i];
+        f += a * a + 100.0 * b * b;
+    }
+    return f;
+}
+
+// Values with gradients for the L-BFGS method
+double EllipsoidGradient(const double* x, double* g, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        g[i] = 2.0 * static_cast<double>(i + 1) * x[i];
+    }
+    return Ellipsoid(x, n);
+}
+
+double ExtendedRosenbrockGradient(const double* x, double* g, size_t n) {
+    std::fill_n(g, n, 0.0);
+    for (size_t i = 0; i + 1 < n; i++) {
+        double a = 1.0 - x[i];
+        double b = x[i + 1] - x[i] * x[i];
+        g[i] += -2.0 * a - 400.0 * x[i] * b;
+        g[i + 1] += 200.0 * b;
+    }
+    return ExtendedRosenbrock(x, n);
+}
+
+BenchmarkResult RunNelderMead(size_t dimension, double (*func)(const double*, size_t)) {
+    using namespace BenchmarkParams;
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    BenchmarkResult result;
+    std::vector<double> errors;
+
+    NelderMead method(dimension, [=](const double* x) { return func(x, dimension); });
+    std::vector<double> x0(dimension);
+
+    for (double scale : StartScales) {
+        for (size_t k = 0; k < dimension; k++) {
+            x0[k] = scale * ((k % 2 == 0) ? -1.2 : 1.0);
+        }
+
+        auto t0 = Clock::now();
+        method.start(x0.data(), SimplexStep);
+        int steps = 0;
+        bool over = false;
+        while (!over && steps < MaxSteps * static_cast<int>(dimension) &&
+                method.evaluations() < static_cast<size_t>(MaxEvaluations)) {
+            method.step();
+            steps++;
+            // The diameter takes n^2 operations, a step only n
+            if (steps % dimension == 0) {
+                over = method.diameter() <= SimplexTolerance;
+            }
+        }
+        auto t1 = Clock::now();
+
+        double error = method.value(method.best());
+        errors.push_back(error);
+
+        result.runs++;
+        if (over && error < SuccessTolerance) {
+            result.successes++;
+        }
+        result.evaluations += static_cast<double>(method.evaluations());
+        result.steps += steps;
+        result.time += Milliseconds(t1 - t0).count();
+    }
+
+    result.evaluations /= result.runs;
+    result.steps /= result.runs;
+    result.time /= result.runs;
+
+    std::sort(errors.begin(), errors.end());
+    result.medianError = errors[errors.size() / 2];
+    result.maxError = errors.back();
+    return result;
+}
+
+BenchmarkResult RunLbfgs(size_t dimension, double (*func)(const double*, double*, size_t)) {
+    using namespace BenchmarkParams;
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    BenchmarkResult result;
+    std::vector<double> errors;
+
+    Lbfgs method(dimension, LbfgsMemory,
+        [=](const double* x, double* g) { return func(x, g, dimension); });
+    std::vector<double> x0(dimension);
+
+    for (double scale : StartScales) {
+        for (size_t k = 0; k < dimension; k++) {
+            x0[k] = scale * ((k % 2 == 0) ? -1.2 : 1.0);
+        }
+
+        auto t0 = Clock::now();
+        method.start(x0.data());
+        int steps = 0;
+        bool over = false;
+        while (!over && steps < MaxSteps &&
+                method.evaluations() < static_cast<size_t>(MaxEvaluations)) {
+            over = method.gradient_norm() < GradientTolerance || !method.step();
+            steps++;
+        }
+        auto t1 = Clock::now();
+
+        double error = method.value();
+        errors.push_back(error);
+
+        result.runs++;
+        if (over && error < SuccessTolerance) {
+            result.successes++;
+        }
+        result.evaluations += static_cast<double>(method.evaluations());
+        result.steps += steps;
+        result.time += Milliseconds(t1 - t0).count();
+    }
+
+    result.evaluations /= result.runs;
+    result.steps /= result.runs;
+    result.time /= result.runs;
+
+    std::sort(errors.begin(), errors.end());
+    result.medianError = errors[errors.size() / 2];
+    result.maxError = errors.back();
+    return result;
+}
+
+int RunBenchmark(bool json, bool cached) {
+    std::vector<std::tuple<std::string, std::unique_ptr<SearchEngine>>> engines;
+    engines.push_back({"Nelder-Mead", std::make_unique<SimplexEngine>()});
+    engines.push_back({"Gauss-Seidel", std::make_unique<GaussSEngine>()});
+    engines.push_back({"Descent", std::make_unique<DescentEngine>()});
+    engines.push_back({"Coordinate", std::make_unique<RelaxationEngine>()});
+    engines.push_back({"BFGS", std::make_unique<BfgsEngine>()});
+    engines.push_back({"L-BFGS", std::make_unique<LbfgsEngine>()});
+    engines.push_back({BenchmarkParams::ScanEngineName, std::make_unique<ScanEngine>()});
+    engines.push_back({"Multi-start", std::make_unique<MultiStartEngine>()});
+
+    const Objective* current = &Objectives::Current();
+
+    // Percentiles of the step times in microseconds, none for untimed runs
+    auto step_time = [json](const BenchmarkResult& result, double q, const char* format) {
+        if (result.stats.steps() == 0) {
+            return std::string(json ? "null" : "-");
+        }
+        char s[32];
+        snprintf(s, sizeof(s), format, result.stats.percentile(q) * 1e6);
+        return std::string(s);
+    };
+
+    auto print_row = [&](const BenchmarkResult& result) {
+        printf("%-16s %-13s %5d %8.1f%% %12.1f %10.1f %9.1f %10.2f %9s %9s %12.3e %12.3e\n",
+            result.objective.c_str(), result.engine.c_str(), result.runs,
+            100.0 * result.successes / result.runs,
+            result.evaluations, result.hits, result.steps, result.time,
+            step_time(result, 0.5, "%.0f").c_str(), step_time(result, 0.99, "%.0f").c_str(),
+            result.medianError, result.maxError);
+    };
+
+    if (!json) {
+        printf("%-16s %-13s %5s %9s %12s %10s %9s %10s %9s %9s %12s %12s\n",
+            "Function", "Method", "Runs", "Success", "Evaluations", "Cached", "Steps", "Time,ms",
+            "P50,us", "P99,us", "Median err", "Max err");
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (const auto& minimum : BenchmarkParams::Minima) {
+        const Objective* objective = Objectives::Find(std::get<0>(minimum));
+        if (!objective) {
+            continue;
+        }
+        Objectives::SetCurrent(objective);
+        bool wasCached = objective->cached();
+        objective->set_cached(cached);
+
+        for (const auto& e : engines) {
+            int maxEvaluations = (std::get<0>(e) == BenchmarkParams::ScanEngineName) ?
+                BenchmarkParams::MaxScanEvaluations : BenchmarkParams::MaxEvaluations;
+            BenchmarkResult result = RunEngine(*std::get<1>(e), std::get<1>(minimum), maxEvaluations);
+            result.objective = objective->name();
+            result.engine = std::get<0>(e);
+            results.push_back(result);
+
+            if (!json) {
+                print_row(result);
+            }
+        }
+
+        objective->set_cached(wasCached);
+    }
+
+    Objectives::SetCurrent(current);
+
+    const std::vector<std::tuple<std::string, double (*)(const double*, size_t)>> functions = {
+        {"Ellipsoid", Ellipsoid},
+        {"Rosenbrock", ExtendedRosenbrock}
+    };
+    for (const auto& f : functions) {
+        for (size_t dimension : BenchmarkParams::Dimensions) {
+            BenchmarkResult result = RunNelderMead(dimension, std::get<1>(f));
+            result.objective = std::get<0>(f) + " " + std::to_string(dimension) + "D";
+            result.engine = "Nelder-Mead";
+            results.push_back(result);
+
+            if (!json) {
+                print_row(result);
+            }
+        }
+    }
+
+    const std::vector<std::tuple<std::string, double (*)(const double*, double*, size_t)>> gradients = {
+        {"Ellipsoid", EllipsoidGradient},
+        {"Rosenbrock", ExtendedRosenbrockGradient}
+    };
+    for (const auto& f : gradients) {
+        for (size_t dimension : BenchmarkParams::LbfgsDimensions) {
+            BenchmarkResult result = RunLbfgs(dimension, std::get<1>(f));
+            result.objective = std::get<0>(f) + " " + std::to_string(dimension) + "D";
+            result.engine = "L-BFGS";
+            results.push_back(result);
+
+            if (!json) {
+                print_row(result);
+            }
+        }
+    }
+
+    if (json) {
+        printf("[\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& r = results[i];
+            printf("  {\"objective\": \"%s\", \"engine\": \"%s\", \"runs\": %d, \"successes\": %d, "
+                "\"evaluations\": %.1f, \"cache_hits\": %.1f, \"steps\": %.1f, \"time_ms\": %.3f, "
+                "\"step_p50_us\": %s, \"step_p99_us\": %s, "
+                "\"median_error\": %.6e, \"max_error\": %.6e}%s\n",
+                r.objective.c_str(), r.engine.c_str(), r.runs, r.successes,
+                r.evaluations, r.hits, r.steps, r.time,
+                step_time(r, 0.5, "%.3f").c_str(), step_time(r, 0.99, "%.3f").c_str(),
+                r.medianError, r.maxError,
+                (i + 1 < results.size()) ? "," : "");
+        }
+        printf("]\n");
+    }
+
+    // Regression of the evaluation counts
+    int status = 0;
+    for (const auto& r : results) {
+        const auto& names = BenchmarkParams::LineSearchEngines;
+        if (std::find(names.begin(), names.end(), r.engine) == names.end()) {
+            continue;
+        }
+        double perStep = r.evaluations / std::max(r.steps, 1.0);
+        if (perStep > BenchmarkParams::MaxEvaluationsPerStep) {
+            fprintf(stderr, "%s on %s takes %.1f evaluations per step, more than %.1f\n",
+                r.engine.c_str(), r.objective.c_str(), perStep,
+                BenchmarkParams::MaxEvaluationsPerStep);
+            status = 1;
+        }
+    }
+
+    return status;
+}
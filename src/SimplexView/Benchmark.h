@@ -0,0 +1,8 @@
+#pragma once
+
+// Run every search engine to completion on the built-in objectives from a grid
+// of start points, with or without the evaluation cache. Prints evaluation
+// counts, times, percentiles of the step times, final errors and success rates
+// as a table or as JSON. Returns 1 if the engines with line searches take more
+// evaluations per step than expected
+int RunBenchmark(bool json, bool cached);
@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "SearchStats.h"
+#include "MathUtils.h"
+#include "Dual.h"
+#include "FuncUtils.h"
+#include "GraphUtils.h"
+#include "LineSearch.h"
+#include "SearchEngine.h"
+#include "BfgsEngine.h"
+
+BfgsEngine::BfgsEngine() {
+    set_start_point(XMin, YMin);
+}
+
+void BfgsEngine::draw(Painter& painter) const {
+    DrawStep(painter, xold_, yold_, x_, y_);
+}
+
+void BfgsEngine::start() {
+    x_ = xold_ = xmin_ = xstart_;
+    y_ = yold_ = ymin_ = ystart_;
+
+    Dual z = evaluate_gradient(x_, y_);
+    zmin_ = z.value;
+    gx_ = z.dx;
+    gy_ = z.dy;
+
+    hxx_ = 1.0;
+    hxy_ = 0.0;
+    hyy_ = 1.0;
+    scaled_ = false;
+
+    search_over_ = false;
+}
+
+void BfgsEngine::step() {
+    if (sqrt(gx_ * gx_ + gy_ * gy_) < Epsilon) {
+        xold_ = xmin_;
+        yold_ = ymin_;
+        search_over_ = true;
+        return;
+    }
+
+    // Directions stop at the sides of the domain the point lies on
+    auto clip = [this](double& dx, double& dy) {
+        if ((x_ <= XMin && dx < 0.0) || (x_ >= XMax && dx > 0.0)) {
+            dx = 0.0;
+        }
+        if ((y_ <= YMin && dy < 0.0) || (y_ >= YMax && dy > 0.0)) {
+            dy = 0.0;
+        }
+    };
+
+    // Quasi-Newton direction, the antigradient if it is not a descent direction
+    double dx = -(hxx_ * gx_ + hxy_ * gy_);
+    double dy = -(hxy_ * gx_ + hyy_ * gy_);
+    clip(dx, dy);
+    double slope = dx * gx_ + dy * gy_;
+    if (slope >= 0.0) {
+        hxx_ = hyy_ = 1.0;
+        hxy_ = 0.0;
+        scaled_ = false;
+        dx = -gx_;
+        dy = -gy_;
+        clip(dx, dy);
+        slope = dx * gx_ + dy * gy_;
+    }
+
+    // Value and gradient along the line are taken in one evaluation
+    double t1 = 0.0, gx1 = gx_, gy1 = gy_;
+    auto phi = [&](double t) {
+        Dual z = evaluate_gradient(x_ + t * dx, y_ + t * dy);
+        t1 = t;
+        gx1 = z.dx;
+        gy1 = z.dy;
+        return LineSearch::Point{ t, z.value, z.dx * dx + z.dy * dy };
+    };
+    LineSearch::Point p0{ 0.0, zmin_, slope };
+
+    // The quasi-Newton step has the unit length when the Hessian is right
+    LineSearch::Result line = LineSearch::Wolfe(phi, p0, 1.0, MaxStep(x_, y_, dx, dy));
+
+    if (line.point.t <= 0.0 || line.point.value >= zmin_) {
+        xold_ = xmin_;
+        yold_ = ymin_;
+        search_over_ = true;
+        return;
+    }
+
+    // The accepted step is not always the last one evaluated
+    if (line.point.t != t1) {
+        Dual z = evaluate_gradient(x_ + line.point.t * dx, y_ + line.point.t * dy);
+        gx1 = z.dx;
+        gy1 = z.dy;
+    }
+
+    double sx = line.point.t * dx, sy = line.point.t * dy;
+    double yx = gx1 - gx_, yy = gy1 - gy_;
+
+    xold_ = xmin_;
+    yold_ = ymin_;
+    x_ = xmin_ = x_ + sx;
+    y_ = ymin_ = y_ + sy;
+    zmin_ = line.point.value;
+    gx_ = gx1;
+    gy_ = gy1;
+
+    // Update of the inverse Hessian, skipped without positive curvature
+    double sy1 = sx * yx + sy * yy;
+    if (sy1 <= 0.0) {
+        return;
+    }
+    if (!scaled_) {
+        // Scale the first approximation to the curvature along the step
+        double scale = sy1 / (yx * yx + yy * yy);
+        hxx_ = hyy_ = scale;
+        hxy_ = 0.0;
+        scaled_ = true;
+    }
+
+    // H = (I - rho s y^T) H (I - rho y s^T) + rho s s^T
+    double rho = 1.0 / sy1;
+    double hyx = hxx_ * yx + hxy_ * yy;
+    double hyy = hxy_ * yx + hyy_ * yy;
+    double yhy = yx * hyx + yy * hyy;
+    double c = rho * (1.0 + rho * yhy);
+
+    hxx_ += c * sx * sx - rho * (hyx * sx + sx * hyx);
+    hxy_ += c * sx * sy - rho * (hyx * sy + sx * hyy);
+    hyy_ += c * sy * sy - rho * (hyy * sy + sy * hyy);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+ * Quasi-Newton method of Broyden, Fletcher, Goldfarb and Shanno. The inverse
+ * of the Hessian is approximated from the changes of the gradient, steps
+ * along the quasi-Newton direction satisfy the strong Wolfe conditions.
+ */
+class BfgsEngine: public SearchEngine {
+public:
+    BfgsEngine();
+
+    void draw(Painter& painter) const override;
+
+    std::unique_ptr<SearchEngine> clone() const override { return std::make_unique<BfgsEngine>(*this); }
+
+protected:
+    void start() override;
+    void step() override;
+
+private:
+    double x_{ 0.0 }, y_{ 0.0 };
+    double xold_{ 0.0 }, yold_{ 0.0 };
+
+    // Gradient in (x, y), known from the last line search
+    double gx_{ 0.0 }, gy_{ 0.0 };
+
+    // Inverse Hessian approximation, symmetric: hxx hxy / hxy hyy
+    double hxx_{ 1.0 }, hxy_{ 0.0 }, hyy_{ 1.0 };
+    bool scaled_{ false };
+};
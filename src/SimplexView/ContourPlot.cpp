@@ -1,543 +1,461 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
+#include "ThreadPool.h"
 #include "GraphUtils.h"
 #include "MathUtils.h"
+#include "Objective.h"
 #include "ContourPlot.h"
+#include "SurfaceTree.h"
 
-using CellType = uint8_t;
-using CellValues = std::array<float, 4>;
+namespace ContourParams {
+    // Grids and contour maps kept for reuse
+    constexpr size_t CacheSize = 4;
 
-namespace CellTypes {
-    constexpr CellType Nothing = 0x00;
+    // Smaller blocks of rows are not worth a thread
+    constexpr int MinRowsPerThread = 8;
 
-    constexpr CellType NorthWest = 0x01;
-    constexpr CellType NorthEast = 0x02;
-    constexpr CellType SouthEast = 0x04;
-    constexpr CellType SouthWest = 0x08;
-
-    constexpr CellType All = 0x0F;
+    // Ends of segments closer than this fraction of the domain are joined
+    constexpr float WeldTolerance = 1e-5f;
 }
 
-CellType GetCellType(CellValues vals) {
-    using namespace CellTypes;
+// Rectangle between the opposite corners c1 and c3
+void CreateFilledRect(std::vector<HMM_Vec2>& triangles,
+              HMM_Vec2 c1, HMM_Vec2 c3) {
+    HMM_Vec2 c2 = HMM_Vec2{ c3.X, c1.Y };
+    HMM_Vec2 c4 = HMM_Vec2{ c1.X, c3.Y };
+
+    triangles.push_back(c1);
+    triangles.push_back(c3);
+    triangles.push_back(c4);
 
-    CellType type = Nothing;
-    type |= (vals[0] > 0) ? NorthWest : 0;
-    type |= (vals[1] > 0) ? NorthEast : 0;
-    type |= (vals[2] > 0) ? SouthEast : 0;
-    type |= (vals[3] > 0) ? SouthWest : 0;
-    return type;
+    triangles.push_back(c1);
+    triangles.push_back(c2);
+    triangles.push_back(c3);
 }
 
-void CreateCorner(std::vector<HMM_Vec2>& lines, CellType type,
-                HMM_Vec2 c0, HMM_Vec2 s0, CellValues vals) {
-    using namespace CellTypes;
-
-    HMM_Vec2 p1, p2;
-
-    switch (type) {
-    case NorthWest:
-    case All ^ NorthWest:
-        p1 = {{ 0, fabs(vals[0] / (vals[0] - vals[3])) }};
-        p2 = {{ fabs(vals[0] / (vals[0] - vals[1])), 0 }};
-        break;
-    case NorthEast:
-    case All ^ NorthEast:
-        p1 = {{ fabs(vals[0] / (vals[0] - vals[1])), 0 }};
-        p2 = {{ 1, fabs(vals[1] / (vals[1] - vals[2])) }};
-        break;
-    case SouthEast:
-    case All ^ SouthEast:
-        p1 = {{ fabs(vals[3] / (vals[3] - vals[2])), 1 }};
-        p2 = {{ 1, fabs(vals[1] / (vals[1] - vals[2])) }};
-        break;
-    case SouthWest:
-    case All ^ SouthWest:
-        p1 = {{ 0, fabs(vals[0] / (vals[0] - vals[3])) }};
-        p2 = {{ fabs(vals[3] / (vals[3] - vals[2])), 1 }};
-        break;
-    }
+// ----------------------------------------------------------------------------
 
-    lines.push_back(c0 + s0 * p1);
-    lines.push_back(c0 + s0 * p2);
+void ContourLine::draw(Painter& painter) const {
+    for (const auto& p : polylines_) {
+        painter.polyline(&vertices_[p.first].X, p.count, p.closed);
+    }
 }
 
-void CreateHalf(std::vector<HMM_Vec2>& lines, CellType type,
-              HMM_Vec2 c0, HMM_Vec2 s0, CellValues vals) {
-    using namespace CellTypes;
-
-    HMM_Vec2 p1, p2;
-
-    switch (type) {
-    case NorthWest | NorthEast:
-    case All ^ (NorthWest | NorthEast):
-        p1 = {{ 0, fabs(vals[0] / (vals[0] - vals[3])) }};
-        p2 = {{ 1, fabs(vals[1] / (vals[1] - vals[2])) }};
-        break;
-    case NorthEast | SouthEast:
-    case All ^ (NorthEast | SouthEast):
-        p1 = {{ fabs(vals[0] / (vals[0] - vals[1])), 0 }};
-        p2 = {{ fabs(vals[3] / (vals[3] - vals[2])), 1 }};
-        break;
-    }
+void ContourLine::stitch(const std::vector<HMM_Vec2>& segments) {
+    vertices_.clear();
+    polylines_.clear();
 
-    lines.push_back(c0 + s0 * p1);
-    lines.push_back(c0 + s0 * p2);
-}
+    // Weld the ends through a hash of cells of the tolerance size, a match
+    // may lie in a neighbour cell of the hash
+    float tolerance = std::max(xmax_ - xmin_, ymax_ - ymin_) * ContourParams::WeldTolerance;
+    if (tolerance <= 0.0f) {
+        tolerance = ContourParams::WeldTolerance;
+    }
 
-void CreateAmbiguity(std::vector<HMM_Vec2>& lines, CellType flags,
-                   HMM_Vec2 c0, HMM_Vec2 s0, CellValues vals, bool u) {
-    using namespace CellTypes;
+    auto hashCell = [tolerance](float v) {
+        return static_cast<int64_t>(std::floor(v / tolerance));
+    };
+    auto hashKey = [](int64_t i, int64_t j) {
+        return (static_cast<uint64_t>(i) << 32) ^ static_cast<uint64_t>(j & 0xffffffff);
+    };
+
+    std::vector<HMM_Vec2> points;
+    std::vector<int> ends(segments.size());
+    std::vector<int> chain; // Next point in the same hash cell
+    std::unordered_map<uint64_t, int> hashCells;
+
+    for (size_t n = 0; n < segments.size(); n++) {
+        const HMM_Vec2& p = segments[n];
+        int64_t i = hashCell(p.X), j = hashCell(p.Y);
+
+        int found = -1;
+        for (int64_t di = -1; di <= 1 && found < 0; di++) {
+            for (int64_t dj = -1; dj <= 1 && found < 0; dj++) {
+                auto it = hashCells.find(hashKey(i + di, j + dj));
+                for (int k = (it != hashCells.end()) ? it->second : -1; k >= 0; k = chain[k]) {
+                    if (fabs(points[k].X - p.X) <= tolerance && fabs(points[k].Y - p.Y) <= tolerance) {
+                        found = k;
+                        break;
+                    }
+                }
+            }
+        }
 
-    HMM_Vec2 p1, p2, p3, p4;
+        if (found < 0) {
+            found = static_cast<int>(points.size());
+            points.push_back(p);
 
-    if ((flags ==(NorthWest | SouthEast) && u) ||
-            (flags ==(NorthEast | SouthWest) && !u)) {
-        p1 = {{ 0, fabs(vals[0] / (vals[0] - vals[3])) }};
-        p2 = {{ fabs(vals[3] / (vals[3] - vals[2])), 1 }};
+            auto it = hashCells.find(hashKey(i, j));
+            chain.push_back((it != hashCells.end()) ? it->second : -1);
+            hashCells[hashKey(i, j)] = found;
+        }
 
-        p3 = {{ fabs(vals[0] / (vals[0] - vals[1])), 0 }};
-        p4 = {{ 1, fabs(vals[1] / (vals[1] - vals[2])) }};
+        ends[n] = found;
     }
 
-    if ((flags ==(NorthWest | SouthEast) && !u) ||
-            (flags == (NorthEast | SouthWest) && u)) {
-        p1 = {{ 0, fabs(vals[0] / (vals[0] - vals[3])) }};
-        p2 = {{ fabs(vals[0] / (vals[0] - vals[1])), 0 }};
+    // Segments at every point
+    std::vector<int> offsets(points.size() + 1, 0);
+    for (size_t s = 0; s < ends.size(); s += 2) {
+        if (ends[s] != ends[s + 1]) {
+            offsets[ends[s] + 1]++;
+            offsets[ends[s + 1] + 1]++;
+        }
+    }
+    for (size_t k = 0; k < points.size(); k++) {
+        offsets[k + 1] += offsets[k];
+    }
 
-        p3 = {{ fabs(vals[3] / (vals[3] - vals[2])), 1 }};
-        p4 = {{ 1, fabs(vals[1] / (vals[1] - vals[2])) }};
+    std::vector<int> links(offsets.back());
+    std::vector<int> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t s = 0; s < ends.size(); s += 2) {
+        if (ends[s] != ends[s + 1]) {
+            links[filled[ends[s]]++] = static_cast<int>(s / 2);
+            links[filled[ends[s + 1]]++] = static_cast<int>(s / 2);
+        }
     }
 
-    lines.push_back(c0 + s0 * p1);
-    lines.push_back(c0 + s0 * p2);
-    lines.push_back(c0 + s0 * p3);
-    lines.push_back(c0 + s0 * p4);
-}
+    std::vector<bool> used(ends.size() / 2, false);
+
+    // Follow unused segments from the point, returns the points passed
+    auto walk = [&](int from, std::vector<int>& path) {
+        for (;;) {
+            int next = -1;
+            for (int l = offsets[from]; l < offsets[from + 1]; l++) {
+                int s = links[l];
+                if (!used[s]) {
+                    used[s] = true;
+                    next = (ends[s * 2] == from) ? ends[s * 2 + 1] : ends[s * 2];
+                    break;
+                }
+            }
+            if (next < 0) {
+                return;
+            }
+            path.push_back(next);
+            from = next;
+        }
+    };
 
-void CreateFullFilled(std::vector<HMM_Vec2>& triangles,
-              HMM_Vec2 c0, HMM_Vec2 s0) {
-    HMM_Vec2 c1 = c0 + s0 * HMM_Vec2{ 0, 0 };
-    HMM_Vec2 c2 = c0 + s0 * HMM_Vec2{ 1, 0 };
-    HMM_Vec2 c3 = c0 + s0 * HMM_Vec2{ 1, 1 };
-    HMM_Vec2 c4 = c0 + s0 * HMM_Vec2{ 0, 1 };
+    std::vector<int> forward, backward;
+    for (size_t s = 0; s < used.size(); s++) {
+        if (used[s] || ends[s * 2] == ends[s * 2 + 1]) {
+            continue;
+        }
+        used[s] = true;
 
-    triangles.push_back(c1);
-    triangles.push_back(c3);
-    triangles.push_back(c4);
+        int a = ends[s * 2], b = ends[s * 2 + 1];
 
-    triangles.push_back(c1);
-    triangles.push_back(c2);
-    triangles.push_back(c3);
-}
+        forward.assign({ a, b });
+        walk(b, forward);
 
-void CreateFilledCorner(std::vector<HMM_Vec2>& triangles, CellType type,
-                    HMM_Vec2 c0, HMM_Vec2 s0, CellValues vals) {
-    using namespace CellTypes;
-
-    HMM_Vec2 c1 = c0 + s0 * HMM_Vec2{ 0, 0 };
-    HMM_Vec2 c2 = c0 + s0 * HMM_Vec2{ 1, 0 };
-    HMM_Vec2 c3 = c0 + s0 * HMM_Vec2{ 1, 1 };
-    HMM_Vec2 c4 = c0 + s0 * HMM_Vec2{ 0, 1 };
-
-    HMM_Vec2 p1, p2;
-
-    switch (type) {
-    case NorthWest:
-    case All ^ NorthWest:
-        p1 = {{fabs(vals[0]/(vals[0]-vals[1])), 0}};
-        p2 = {{0, fabs(vals[0]/(vals[0]-vals[3]))}};
-        break;
-
-    case NorthEast:
-    case All ^ NorthEast:
-        p1 = {{1, fabs(vals[1]/(vals[1]-vals[2]))}};
-        p2 = {{fabs(vals[0]/(vals[0]-vals[1])), 0}};
-        break;
-
-    case SouthEast:
-    case All ^ SouthEast:
-        p1 = {{fabs(vals[3]/(vals[3]-vals[2])), 1}};
-        p2 = {{1, fabs(vals[1]/(vals[1]-vals[2]))}};
-        break;
-
-    case SouthWest:
-    case All ^ SouthWest:
-        p1 = {{0, fabs(vals[0]/(vals[0]-vals[3]))}};
-        p2 = {{fabs(vals[3]/(vals[3]-vals[2])), 1}};
-        break;
-    }
+        Polyline polyline;
+        polyline.first = vertices_.size();
+
+        if (forward.back() == a) {
+            forward.pop_back();
+            polyline.closed = true;
+        }
+        else {
+            // Open line, extend it back from the first point
+            backward.clear();
+            walk(a, backward);
+            for (auto it = backward.rbegin(); it != backward.rend(); ++it) {
+                vertices_.push_back(points[*it]);
+            }
+        }
 
-    HMM_Vec2 d1 = c0 + s0 * p1;
-    HMM_Vec2 d2 = c0 + s0 * p2;
-
-    switch (type) {
-    case NorthWest:
-        triangles.push_back(c1);
-        triangles.push_back(d1);
-        triangles.push_back(d2);
-        break;
-
-    case (All ^ NorthWest):
-        triangles.push_back(d1);
-        triangles.push_back(c2);
-        triangles.push_back(c3);
-
-        triangles.push_back(d1);
-        triangles.push_back(c3);
-        triangles.push_back(d2);
-
-        triangles.push_back(d2);
-        triangles.push_back(c3);
-        triangles.push_back(c4);
-        break;
-    
-    case NorthEast:
-        triangles.push_back(c2);
-        triangles.push_back(d1);
-        triangles.push_back(d2);
-        break;
-    
-    case (All ^ NorthEast):
-        triangles.push_back(c1);
-        triangles.push_back(d2);
-        triangles.push_back(c4);
-
-        triangles.push_back(c4);
-        triangles.push_back(d2);
-        triangles.push_back(d1);
-
-        triangles.push_back(c4);
-        triangles.push_back(d1);
-        triangles.push_back(c3);
-        break;
-
-    case SouthEast:
-        triangles.push_back(c3);
-        triangles.push_back(d1);
-        triangles.push_back(d2);
-        break;
-    
-    case (All ^ SouthEast):
-        triangles.push_back(c1);
-        triangles.push_back(c2);
-        triangles.push_back(d2);
-
-        triangles.push_back(c1);
-        triangles.push_back(d2);
-        triangles.push_back(d1);
-
-        triangles.push_back(c1);
-        triangles.push_back(d1);
-        triangles.push_back(c4);
-        break;
-    
-    case SouthWest:
-        triangles.push_back(c4);
-        triangles.push_back(d1);
-        triangles.push_back(d2);
-        break;
-    
-    case (All ^ SouthWest):
-        triangles.push_back(c1);
-        triangles.push_back(c2);
-        triangles.push_back(d1);
-
-        triangles.push_back(d1);
-        triangles.push_back(c2);
-        triangles.push_back(d2);
-
-        triangles.push_back(c2);
-        triangles.push_back(c3);
-        triangles.push_back(d2);
-        break;
-
-    default:
-        break;
+        for (int k : forward) {
+            vertices_.push_back(points[k]);
+        }
+
+        polyline.count = vertices_.size() - polyline.first;
+        polylines_.push_back(polyline);
     }
 }
 
-void CreateFilledHalf(std::vector<HMM_Vec2>& triangles, CellType type,
-                  HMM_Vec2 c0, HMM_Vec2 s0, CellValues vals) {
-    using namespace CellTypes;
-
-    HMM_Vec2 p1, p2, p3, p4;
-
-    switch (type) {
-    case (NorthWest | NorthEast):
-        p1 = {{0, 0}};
-        p2 = {{1, 0}};
-        p3 = {{1, fabs(vals[1]/(vals[1]-vals[2]))}};
-        p4 = {{0, fabs(vals[0]/(vals[0]-vals[3]))}};
-        break;
-
-    case (SouthEast | SouthWest):
-        p1 = {{0, fabs(vals[0]/(vals[0]-vals[3]))}};
-        p2 = {{1, fabs(vals[1]/(vals[1]-vals[2]))}};
-        p3 = {{1, 1}};
-        p4 = {{0, 1}};
-        break;
-
-    case (NorthEast | SouthEast):
-        p1 = {{fabs(vals[0]/(vals[0]-vals[1])), 0}};
-        p2 = {{1, 0}};
-        p3 = {{1, 1}};
-        p4 = {{fabs(vals[3]/(vals[3]-vals[2])), 1}};
-        break;
-
-    case (NorthWest | SouthWest):
-        p1 = {{0, 0}};
-        p2 = {{fabs(vals[0]/(vals[0]-vals[1])), 0}};
-        p3 = {{fabs(vals[3]/(vals[3]-vals[2])), 1}};
-        p4 = {{0, 1}};
-        break;
-    }
+// ----------------------------------------------------------------------------
 
-    HMM_Vec2 d1 = c0 + s0 * p1;
-    HMM_Vec2 d2 = c0 + s0 * p2;
-    HMM_Vec2 d3 = c0 + s0 * p3;
-    HMM_Vec2 d4 = c0 + s0 * p4;
+void ContourFill::draw(Painter& painter) const {
+    painter.triangles(reinterpret_cast<const float*>(triangles.data()), triangles.size());
+}
 
-    triangles.push_back(d1);
-    triangles.push_back(d3);
-    triangles.push_back(d4);
+// ----------------------------------------------------------------------------
 
-    triangles.push_back(d1);
-    triangles.push_back(d2);
-    triangles.push_back(d3);
-}
+using LevelVertices = std::vector<std::vector<HMM_Vec2>>;
+using RowBlockFunc = std::function<void(int block, int first, int last)>;
 
-void CreateFilledAmbiguity(std::vector<HMM_Vec2>& triangles, CellType type,
-                       HMM_Vec2 c0, HMM_Vec2 s0, CellValues vals, bool u) {
-    using namespace CellTypes;
+int RowBlockCount(int rows) {
+    int threads = static_cast<int>(ThreadPool::shared().threads());
+    return std::max(std::min(rows / ContourParams::MinRowsPerThread, threads), 1);
+}
 
-    HMM_Vec2 c1 = c0 + s0 * HMM_Vec2{ 0, 0 };
-    HMM_Vec2 c2 = c0 + s0 * HMM_Vec2{ 1, 0 };
-    HMM_Vec2 c3 = c0 + s0 * HMM_Vec2{ 1, 1 };
-    HMM_Vec2 c4 = c0 + s0 * HMM_Vec2{ 0, 1 };
+// Split rows into contiguous blocks and process them on the shared pool
+void ForEachRowBlock(int rows, int blocks, const RowBlockFunc& func) {
+    auto blockFunc = [&](int b) {
+        func(b, rows * b / blocks, rows * (b + 1) / blocks);
+    };
 
-    HMM_Vec2 p1 = c0 + s0 * HMM_Vec2{ fabs(vals[0] / (vals[0] - vals[1])), 0 };
-    HMM_Vec2 p2 = c0 + s0 * HMM_Vec2{ 1, fabs(vals[1] / (vals[1] - vals[2])) };
-    HMM_Vec2 p3 = c0 + s0 * HMM_Vec2{ fabs(vals[3] / (vals[3] - vals[2])), 1 };
-    HMM_Vec2 p4 = c0 + s0 * HMM_Vec2{ 0, fabs(vals[0] / (vals[0] - vals[3])) };
+    TaskGroup tasks;
+    for (int b = 1; b < blocks; b++) {
+        tasks.submit([&blockFunc, b]() { blockFunc(b); });
+    }
 
-    if (u) {
-        triangles.push_back(p1);
-        triangles.push_back(p2);
-        triangles.push_back(p3);
+    // First block is processed by the calling thread
+    blockFunc(0);
+    tasks.wait();
+}
 
-        triangles.push_back(p1);
-        triangles.push_back(p3);
-        triangles.push_back(p4);
+template<typename T>
+void CacheInsert(std::deque<std::shared_ptr<const T>>& cache, std::shared_ptr<const T> item) {
+    cache.push_front(std::move(item));
+    if (cache.size() > ContourParams::CacheSize) {
+        cache.pop_back();
     }
+}
 
-    if (type == (NorthWest | SouthEast)) {
-        triangles.push_back(c1);
-        triangles.push_back(p1);
-        triangles.push_back(p4);
+// Concatenate vertices of one level from all blocks of rows
+void JoinBlocks(std::vector<HMM_Vec2>& vertices,
+        std::vector<LevelVertices>& blocks, size_t level) {
+    if (blocks.size() == 1) {
+        vertices.swap(blocks[0][level]);
+        return;
+    }
 
-        triangles.push_back(c3);
-        triangles.push_back(p3);
-        triangles.push_back(p2);
+    size_t count = 0;
+    for (const auto& b : blocks) {
+        count += b[level].size();
     }
-    else if (type == (All ^ (NorthWest | SouthEast))) {
-        triangles.push_back(c4);
-        triangles.push_back(p4);
-        triangles.push_back(p3);
-
-        triangles.push_back(c2);
-        triangles.push_back(p2);
-        triangles.push_back(p1);
+
+    vertices.clear();
+    vertices.reserve(count);
+    for (const auto& b : blocks) {
+        vertices.insert(vertices.end(), b[level].begin(), b[level].end());
     }
 }
 
-// ----------------------------------------------------------------------------
+std::shared_ptr<const SurfaceGrid> SurfaceGrid::sample(
+        const Objective& objective, int cols, int rows,
+        float xmin, float ymin, float xmax, float ymax) {
+    static std::mutex cacheMutex;
+    static std::deque<std::shared_ptr<const SurfaceGrid>> cache;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = std::find_if(cache.begin(), cache.end(),
+            [&](const std::shared_ptr<const SurfaceGrid>& g) {
+                return g->objectiveId == objective.id() && g->cols == cols && g->rows == rows &&
+                    g->xmin == xmin && g->ymin == ymin &&
+                    g->xmax == xmax && g->ymax == ymax;
+            });
+        if (it != cache.end()) {
+            return *it;
+        }
+    }
+
+    auto grid = std::make_shared<SurfaceGrid>();
+    grid->objective = &objective;
+    grid->objectiveId = objective.id();
+    grid->cols = cols; grid->rows = rows;
+    grid->xmin = xmin; grid->ymin = ymin;
+    grid->xmax = xmax; grid->ymax = ymax;
+    grid->points.resize(static_cast<size_t>(cols) * rows);
+
+    // Nodes lie on the domain edges, the same as the contour cells
+    float dx = (xmax - xmin) / static_cast<float>(cols - 1);
+    float dy = (ymax - ymin) / static_cast<float>(rows - 1);
+
+    int blocks = RowBlockCount(rows);
+    std::vector<float> zmin(blocks, std::numeric_limits<float>::max());
+    std::vector<float> zmax(blocks, std::numeric_limits<float>::lowest());
+
+    ForEachRowBlock(rows, blocks, [&](int b, int first, int last) {
+        std::vector<double> xs(cols), ys(cols), zs(cols);
+        for (int i = 0; i < cols; i++) {
+            xs[i] = xmin + static_cast<float>(i) * dx;
+        }
 
-bool ContourLine::init(
-        const std::vector<float>& points, int cols, int rows,
-        float xmin, float ymin, float xmax, float ymax,
-        float threshold) {
-    using namespace CellTypes;
-
-    xmin_ = xmin; ymin_ = ymin;
-    xmax_ = xmax; ymax_ = ymax;
-    threshold_ = threshold;
-
-    HMM_Vec2 s0 = (HMM_Vec2{ xmax_, ymax_ } - HMM_Vec2{ xmin_, ymin_ }) /
-        HMM_Vec2{ static_cast<float>(cols - 1), static_cast<float>(rows - 1) };
-
-    CellValues vals;
-    float v{ 0.0f };
-
-    lines.clear();
-
-    for (int j=0; j<rows-1; j++) {
-        for (int i=0; i<cols-1; i++) {
-            HMM_Vec2 c0 = HMM_Vec2{ xmin_, ymin_ } + HMM_Vec2{ static_cast<float>(i), static_cast<float>(j) } *s0;
-
-            vals[0] = points[(j  ) * rows + (i  )] - threshold_;
-            vals[1] = points[(j  ) * rows + (i+1)] - threshold_;
-            vals[2] = points[(j+1) * rows + (i+1)] - threshold_;
-            vals[3] = points[(j+1) * rows + (i  )] - threshold_;
-
-            CellType type = GetCellType(vals);
-            switch (type) {
-            case NorthWest:
-            case (All ^ NorthWest):
-            case NorthEast:
-            case (All ^ NorthEast):
-            case SouthEast:
-            case (All ^ SouthEast):
-            case SouthWest:
-            case (All ^ SouthWest):
-                // One corner
-                CreateCorner(lines, type, c0, s0, vals);
-                break;
-
-            case (NorthWest | NorthEast):
-            case (NorthEast | SouthEast):
-            case (SouthEast | SouthWest):
-            case (SouthWest | NorthWest):
-                // Half
-                CreateHalf(lines, type, c0, s0, vals);
-                break;
-
-            case NorthWest | SouthEast:
-            case All ^ (NorthWest | SouthEast):
-                // Ambiguity
-                v = (vals[0] + vals[1] + vals[2] + vals[3]) / 4.f;
-                CreateAmbiguity(lines, type, c0, s0, vals, v > 0.0f);
-                break;
-
-            case Nothing:
-            case All:
-                // No lines
-                break;
-
-            default:
-                break;
+        for (int j = first; j < last; j++) {
+            std::fill(ys.begin(), ys.end(), ymin + static_cast<float>(j) * dy);
+            objective.evaluate(xs.data(), ys.data(), zs.data(), cols);
+
+            for (int i = 0; i < cols; i++) {
+                float z = static_cast<float>(zs[i]);
+                grid->points[j * cols + i] = z;
+                zmin[b] = std::min(zmin[b], z);
+                zmax[b] = std::max(zmax[b], z);
             }
         }
-    }
+    });
+
+    grid->zmin = *std::min_element(zmin.begin(), zmin.end());
+    grid->zmax = *std::max_element(zmax.begin(), zmax.end());
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    CacheInsert<SurfaceGrid>(cache, grid);
+    return grid;
+}
 
-    return true;
+// ----------------------------------------------------------------------------
+
+// Point where the level crosses the edge from a to b
+HMM_Vec2 EdgePoint(HMM_Vec3 a, HMM_Vec3 b, float level) {
+    float t = (level - a.Z) / (b.Z - a.Z);
+    return HMM_Vec2{ a.X + t * (b.X - a.X), a.Y + t * (b.Y - a.Y) };
 }
 
-void ContourLine::render(CoordinateFunc xFunc, CoordinateFunc yFunc) const {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glEnableClientState(GL_VERTEX_ARRAY);
-
-    glVertexPointer(2, GL_FLOAT, 0, lines.data());
-    glDrawArrays(GL_LINES, 0, lines.size());
-
-    glDisableClientState(GL_VERTEX_ARRAY);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_line_style(FL_SOLID, 1);
-    for (size_t i = 0; i < lines.size(); i += 2) {
-        const auto& p1 = lines[i];
-        const auto& p2 = lines[i + 1];
-        fl_line(
-            xFunc(p1.X), yFunc(p1.Y),
-            xFunc(p2.X), yFunc(p2.Y)
-        );
+// Marching triangles: the triangle has vertices on both sides of the level
+void CreateTriangleContour(std::vector<HMM_Vec2>& lines, std::vector<HMM_Vec2>& triangles,
+                           const HMM_Vec3* p, float level) {
+    int above = (p[0].Z > level) + (p[1].Z > level) + (p[2].Z > level);
+
+    // Vertex a is the one alone on its side of the level
+    int r = 0;
+    while ((p[r].Z > level) != (above == 1)) {
+        r++;
+    }
+
+    HMM_Vec3 a = p[r], b = p[(r + 1) % 3], c = p[(r + 2) % 3];
+    HMM_Vec2 ab = EdgePoint(a, b, level);
+    HMM_Vec2 ac = EdgePoint(a, c, level);
+
+    lines.push_back(ab);
+    lines.push_back(ac);
+
+    if (above == 1) {
+        triangles.push_back(a.XY);
+        triangles.push_back(ab);
+        triangles.push_back(ac);
+    }
+    else {
+        triangles.push_back(ab);
+        triangles.push_back(b.XY);
+        triangles.push_back(c.XY);
+
+        triangles.push_back(ab);
+        triangles.push_back(c.XY);
+        triangles.push_back(ac);
     }
-#endif
 }
 
-// ----------------------------------------------------------------------------
+std::shared_ptr<const ContourMap> ContourMap::build(
+        const std::shared_ptr<const SurfaceTree>& tree,
+        const std::vector<float>& levels) {
+    static std::mutex cacheMutex;
+    static std::deque<std::shared_ptr<const ContourMap>> cache;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = std::find_if(cache.begin(), cache.end(),
+            [&](const std::shared_ptr<const ContourMap>& m) {
+                return m->tree_ == tree && m->levels_ == levels;
+            });
+        if (it != cache.end()) {
+            return *it;
+        }
+    }
+
+    auto map = std::make_shared<ContourMap>();
+    map->tree_ = tree;
+    map->levels_ = levels;
+
+    const auto& mesh = tree->triangles();
+    const auto& cells = tree->cells();
+    const int cols = tree->grid()->cols - 1, rows = tree->grid()->rows - 1;
+    const size_t levelCount = levels.size();
+
+    int blocks = RowBlockCount(rows);
+    std::vector<LevelVertices> blockLines(blocks, LevelVertices(levelCount));
+    std::vector<LevelVertices> blockFills(blocks, LevelVertices(levelCount));
+
+    ForEachRowBlock(rows, blocks, [&](int b, int first, int last) {
+        auto& lines = blockLines[b];
+        auto& fills = blockFills[b];
+
+        // Start of the run of fully filled grid cells for every level
+        std::vector<int> runs(levelCount);
+
+        auto fillRun = [&](size_t k, int j, int i) {
+            CreateFilledRect(fills[k], tree->grid_node(runs[k], j), tree->grid_node(i, j + 1));
+            runs[k] = -1;
+        };
+
+        for (int j = first; j < last; j++) {
+            std::fill(runs.begin(), runs.end(), -1);
+
+            for (int i = 0; i < cols; i++) {
+                const auto& cell = cells[j * cols + i];
+
+                // Levels under the lowest value of the cell cover all of it,
+                // only the highest of them is visible
+                size_t covered = std::lower_bound(levels.begin(), levels.end(), cell.zmin) - levels.begin();
+                size_t top = covered - 1;
+
+                for (size_t k = 0; k < levelCount; k++) {
+                    if (runs[k] >= 0 && k != top) {
+                        fillRun(k, j, i);
+                    }
+                }
+                if (covered > 0 && runs[top] < 0) {
+                    runs[top] = i;
+                }
+
+                for (size_t t = cell.first; t < cell.first + cell.count; t++) {
+                    const HMM_Vec3* p = &mesh[t * 3];
+
+                    float zlo = std::min({ p[0].Z, p[1].Z, p[2].Z });
+                    float zhi = std::max({ p[0].Z, p[1].Z, p[2].Z });
+
+                    size_t under = std::lower_bound(levels.begin(), levels.end(), zlo) - levels.begin();
+                    size_t crossed = std::lower_bound(levels.begin(), levels.end(), zhi) - levels.begin();
+
+                    if (under > covered) {
+                        fills[under - 1].push_back(p[0].XY);
+                        fills[under - 1].push_back(p[1].XY);
+                        fills[under - 1].push_back(p[2].XY);
+                    }
+
+                    for (size_t k = under; k < crossed; k++) {
+                        CreateTriangleContour(lines[k], fills[k], p, levels[k]);
+                    }
+                }
+            }
 
-bool ContourFill::init(
-        const std::vector<float>& points, int cols, int rows,
-        float xmin, float ymin, float xmax, float ymax,
-        float threshold) {
-    using namespace CellTypes;
-
-    xmin_ = xmin; ymin_ = ymin;
-    xmax_ = xmax; ymax_ = ymax;
-    threshold_ = threshold;
-
-    HMM_Vec2 s0 = (HMM_Vec2{ xmax_, ymax_ } - HMM_Vec2{ xmin_, ymin_ }) /
-        HMM_Vec2{ static_cast<float>(cols - 1), static_cast<float>(rows - 1) };
-
-    CellValues vals;
-    float v{ 0.0f };
-
-    triangles.clear();
-
-    for (int j=0; j<rows-1; j++) {
-        for (int i=0; i<cols-1; i++) {
-            HMM_Vec2 c0 = HMM_Vec2{ xmin_, ymin_ } + HMM_Vec2{ static_cast<float>(i), static_cast<float>(j) } *s0;
-
-            vals[0] = points[(j  ) * rows + (i  )] - threshold_;
-            vals[1] = points[(j  ) * rows + (i+1)] - threshold_;
-            vals[2] = points[(j+1) * rows + (i+1)] - threshold_;
-            vals[3] = points[(j+1) * rows + (i  )] - threshold_;
-
-            CellType type = GetCellType(vals);
-            switch (type) {
-            case NorthWest:
-            case (All ^ NorthWest):
-            case NorthEast:
-            case (All ^ NorthEast):
-            case SouthEast:
-            case (All ^ SouthEast):
-            case SouthWest:
-            case (All ^ SouthWest):
-                // One corner
-                CreateFilledCorner(triangles, type, c0, s0, vals);
-                break;
-
-            case (NorthWest | NorthEast):
-            case (NorthEast | SouthEast):
-            case (SouthEast | SouthWest):
-            case (SouthWest | NorthWest):
-                // Half
-                CreateFilledHalf(triangles, type, c0, s0, vals);
-                break;
-
-            case (NorthWest | SouthEast):
-            case (All ^ (NorthWest | SouthEast)):
-                // Ambiguity
-                v = (vals[0] + vals[1] + vals[2] + vals[3]) / 4.f;
-                CreateFilledAmbiguity(triangles, type, c0, s0, vals, v > 0.0f);
-                break;
-
-            case All:
-                // Full filled
-                CreateFullFilled(triangles, c0, s0);
-                break;
-
-            case Nothing:
-                // Don't fill
-                break;
-
-            default:
-                break;
+            for (size_t k = 0; k < levelCount; k++) {
+                if (runs[k] >= 0) {
+                    fillRun(k, j, cols);
+                }
             }
         }
-    }
+    });
+
+    map->join(blockLines, blockFills);
 
-    return true;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    CacheInsert<ContourMap>(cache, map);
+    return map;
 }
 
-void ContourFill::render(CoordinateFunc xFunc, CoordinateFunc yFunc) const {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glEnableClientState(GL_VERTEX_ARRAY);
-
-    glVertexPointer(2, GL_FLOAT, 0, triangles.data());
-    glDrawArrays(GL_TRIANGLES, 0, triangles.size());
-
-    glDisableClientState(GL_VERTEX_ARRAY);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_line_style(FL_SOLID, 1);
-    for (size_t i = 0; i < triangles.size(); i += 3) {
-        const auto& p1 = triangles[i];
-        const auto& p2 = triangles[i + 1];
-        const auto& p3 = triangles[i + 2];
-        fl_polygon(
-            xFunc(p1.X), yFunc(p1.Y),
-            xFunc(p2.X), yFunc(p2.Y),
-            xFunc(p3.X), yFunc(p3.Y)
-        );
+void ContourMap::join(std::vector<LevelVertices>& blockLines, std::vector<LevelVertices>& blockFills) {
+    const SurfaceGrid& grid = *tree_->grid();
+
+    auto setLevel = [&grid](ContourPlot& p, float threshold) {
+        p.xmin_ = grid.xmin; p.ymin_ = grid.ymin;
+        p.xmax_ = grid.xmax; p.ymax_ = grid.ymax;
+        p.threshold_ = threshold;
+    };
+
+    lines_.resize(levels_.size());
+    fills_.resize(levels_.size());
+
+    for (size_t k = 0; k < levels_.size(); k++) {
+        setLevel(lines_[k], levels_[k]);
+        setLevel(fills_[k], levels_[k]);
+
+        std::vector<HMM_Vec2> segments;
+        JoinBlocks(segments, blockLines, k);
+        lines_[k].stitch(segments);
+
+        JoinBlocks(fills_[k].triangles, blockFills, k);
     }
-#endif
 }
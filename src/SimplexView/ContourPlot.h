@@ -1,5 +1,7 @@
 #pragma once
 
+class Painter;
+
 // ----------------------------------------------------------------------------
 
 class ContourPlot {
@@ -7,16 +9,13 @@ public:
     ContourPlot() = default;
     virtual ~ContourPlot() { }
 
-    virtual bool init(
-        const std::vector<float>& /*points*/, int /*cols*/, int /*rows*/,
-        float /*xmin*/, float /*ymin*/, float /*xmax*/, float /*ymax*/,
-        float /*threshold*/
-    ) { return true; }
-    virtual void render(CoordinateFunc /*xFunc*/, CoordinateFunc /*yFunc*/) const { }
+    virtual void draw(Painter& /*painter*/) const { }
 
     void resize(int w, int h) { w_ = w; h_ = h; }
 
 protected:
+    friend class ContourMap;
+
     int w_{ 0 }, h_{ 0 };
     float xmin_{ 0.0f }, ymin_{ 0.0f };
     float xmax_{ 0.0f }, ymax_{ 0.0f };
@@ -27,17 +26,30 @@ protected:
 
 class ContourLine: public ContourPlot {
 public:
+    // Vertices of a polyline, the last one connects to the first if closed
+    struct Polyline {
+        size_t first{ 0 };
+        size_t count{ 0 };
+        bool closed{ false };
+    };
+
     ContourLine() = default;
 
-    bool init(
-        const std::vector<float>& points, int cols, int rows,
-        float xmin, float ymin, float xmax, float ymax,
-        float threshold) override;
+    void draw(Painter& painter) const override;
 
-    void render(CoordinateFunc xFunc, CoordinateFunc yFunc) const override;
+    const std::vector<HMM_Vec2>& vertices() const { return vertices_; }
+    const std::vector<Polyline>& polylines() const { return polylines_; }
 
 private:
-    std::vector<HMM_Vec2> lines;
+    friend class ContourMap;
+
+    // Join pairs of segment ends into polylines, ends of neighbour cells
+    // closer than the weld tolerance become one vertex
+    void stitch(const std::vector<HMM_Vec2>& segments);
+
+private:
+    std::vector<HMM_Vec2> vertices_;
+    std::vector<Polyline> polylines_;
 };
 
 // ----------------------------------------------------------------------------
@@ -46,13 +58,65 @@ class ContourFill: public ContourPlot {
 public:
     ContourFill() = default;
 
-    bool init(
-        const std::vector<float>& points, int cols, int rows,
-        float xmin, float ymin, float xmax, float ymax,
-        float threshold) override;
-
-    void render(CoordinateFunc xFunc, CoordinateFunc yFunc) const override;
+    void draw(Painter& painter) const override;
 
 private:
+    friend class ContourMap;
+
     std::vector<HMM_Vec2> triangles;
 };
+
+// ----------------------------------------------------------------------------
+
+class Objective;
+
+// Function sampled on the nodes of a regular grid, row by row
+struct SurfaceGrid {
+    // Rows are sampled in parallel, each row in one batch. Grids are cached,
+    // so sampling the same objective over the same domain again returns the
+    // previous grid
+    static std::shared_ptr<const SurfaceGrid> sample(
+        const Objective& objective, int cols, int rows,
+        float xmin, float ymin, float xmax, float ymax);
+
+    const Objective* objective{ nullptr };
+    unsigned objectiveId{ 0 };
+    int cols{ 0 }, rows{ 0 };
+    float xmin{ 0.0f }, ymin{ 0.0f };
+    float xmax{ 0.0f }, ymax{ 0.0f };
+    float zmin{ 0.0f }, zmax{ 0.0f };
+    std::vector<float> points;
+};
+
+class SurfaceTree;
+
+// Contour lines and fills of every level, built in one pass over the
+// triangles of an adaptive tree. Fills are drawn in the order of levels,
+// a fill leaves out the cells covered by the fills of higher levels
+class ContourMap {
+public:
+    // Levels go in ascending order. Each cell is classified against all of
+    // them at once and rows are processed in parallel. Maps are cached by
+    // the tree and the levels
+    static std::shared_ptr<const ContourMap> build(
+        const std::shared_ptr<const SurfaceTree>& tree,
+        const std::vector<float>& levels);
+
+    size_t size() const { return levels_.size(); }
+
+    const ContourLine& line(size_t level) const { return lines_[level]; }
+    const ContourFill& fill(size_t level) const { return fills_[level]; }
+
+private:
+    // Vertices of every level built by one thread
+    using LevelVertices = std::vector<std::vector<HMM_Vec2>>;
+
+    void join(std::vector<LevelVertices>& blockLines, std::vector<LevelVertices>& blockFills);
+
+private:
+    std::shared_ptr<const SurfaceTree> tree_;
+    std::vector<float> levels_;
+
+    std::vector<ContourLine> lines_;
+    std::vector<ContourFill> fills_;
+};
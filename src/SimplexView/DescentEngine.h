@@ -4,13 +4,18 @@ class DescentEngine: public SearchEngine {
 public:
     DescentEngine();
 
-    void draw(CoordinateFunc xFunc, CoordinateFunc yFunc) override;
+    void draw(Painter& painter) const override;
 
-    void search_start() override;
-    void search_step() override;
+    std::unique_ptr<SearchEngine> clone() const override { return std::make_unique<DescentEngine>(*this); }
+
+protected:
+    void start() override;
+    void step() override;
 
 private:
     double x_{ 0.0 }, y_{ 0.0 };
-    double ddx_{ 0.0 }, ddy_{ 0.0 };
     double xold_{ 0.0 }, yold_{ 0.0 };
+
+    // Length of the last step along the antigradient
+    double step_{ 0.0 };
 };
@@ -0,0 +1,86 @@
+#pragma once
+
+/*
+ * Dual number for forward-mode automatic differentiation of F(x, y).
+ * Holds a value and its partial derivatives by x and y, so one pass over
+ * the function gives both the value and the gradient.
+ */
+struct Dual {
+    double value{ 0.0 };
+    double dx{ 0.0 }, dy{ 0.0 };
+
+    Dual() = default;
+    Dual(double v) : value(v) { }
+    Dual(double v, double x, double y) : value(v), dx(x), dy(y) { }
+
+    // Independent variables
+    static Dual X(double x) { return Dual(x, 1.0, 0.0); }
+    static Dual Y(double y) { return Dual(y, 0.0, 1.0); }
+
+    Dual& operator+=(const Dual& b) { return *this = Dual(value + b.value, dx + b.dx, dy + b.dy); }
+    Dual& operator-=(const Dual& b) { return *this = Dual(value - b.value, dx - b.dx, dy - b.dy); }
+    Dual& operator*=(const Dual& b) {
+        return *this = Dual(value * b.value, dx * b.value + value * b.dx, dy * b.value + value * b.dy);
+    }
+    Dual& operator/=(const Dual& b) {
+        double q = value / b.value;
+        return *this = Dual(q, (dx - q * b.dx) / b.value, (dy - q * b.dy) / b.value);
+    }
+};
+
+inline Dual operator-(const Dual& a) { return Dual(-a.value, -a.dx, -a.dy); }
+inline Dual operator+(Dual a, const Dual& b) { return a += b; }
+inline Dual operator-(Dual a, const Dual& b) { return a -= b; }
+inline Dual operator*(Dual a, const Dual& b) { return a *= b; }
+inline Dual operator/(Dual a, const Dual& b) { return a /= b; }
+
+inline bool operator<(const Dual& a, const Dual& b) { return a.value < b.value; }
+
+// Function of a dual number by its value f and derivative df
+inline Dual Chain(const Dual& a, double f, double df) {
+    return Dual(f, df * a.dx, df * a.dy);
+}
+
+inline Dual sin(const Dual& a) { return Chain(a, sin(a.value), cos(a.value)); }
+inline Dual cos(const Dual& a) { return Chain(a, cos(a.value), -sin(a.value)); }
+inline Dual tan(const Dual& a) { double t = tan(a.value); return Chain(a, t, 1.0 + t * t); }
+inline Dual asin(const Dual& a) { return Chain(a, asin(a.value), 1.0 / sqrt(1.0 - a.value * a.value)); }
+inline Dual acos(const Dual& a) { return Chain(a, acos(a.value), -1.0 / sqrt(1.0 - a.value * a.value)); }
+inline Dual atan(const Dual& a) { return Chain(a, atan(a.value), 1.0 / (1.0 + a.value * a.value)); }
+inline Dual sinh(const Dual& a) { return Chain(a, sinh(a.value), cosh(a.value)); }
+inline Dual cosh(const Dual& a) { return Chain(a, cosh(a.value), sinh(a.value)); }
+inline Dual tanh(const Dual& a) { double t = tanh(a.value); return Chain(a, t, 1.0 - t * t); }
+inline Dual exp(const Dual& a) { double e = exp(a.value); return Chain(a, e, e); }
+inline Dual log(const Dual& a) { return Chain(a, log(a.value), 1.0 / a.value); }
+inline Dual log10(const Dual& a) { return Chain(a, log10(a.value), 1.0 / (a.value * M_LN10)); }
+inline Dual sqrt(const Dual& a) { double s = sqrt(a.value); return Chain(a, s, 0.5 / s); }
+inline Dual fabs(const Dual& a) { return a.value < 0.0 ? -a : a; }
+inline Dual floor(const Dual& a) { return Dual(floor(a.value)); }
+inline Dual ceil(const Dual& a) { return Dual(ceil(a.value)); }
+
+inline Dual fmin(const Dual& a, const Dual& b) { return b.value < a.value ? b : a; }
+inline Dual fmax(const Dual& a, const Dual& b) { return a.value < b.value ? b : a; }
+
+inline Dual atan2(const Dual& a, const Dual& b) {
+    double r = a.value * a.value + b.value * b.value;
+    return Dual(atan2(a.value, b.value),
+        (b.value * a.dx - a.value * b.dx) / r,
+        (b.value * a.dy - a.value * b.dy) / r);
+}
+
+// Integer powers keep the derivative finite at zero
+inline Dual pow(const Dual& a, double p) {
+    return Chain(a, pow(a.value, p), p == 0.0 ? 0.0 : p * pow(a.value, p - 1.0));
+}
+
+inline Dual pow(const Dual& a, const Dual& b) {
+    if (b.dx == 0.0 && b.dy == 0.0) {
+        return pow(a, b.value);
+    }
+    // a^b = exp(b log a), defined for positive bases only
+    double f = pow(a.value, b.value);
+    double la = log(a.value);
+    return Dual(f,
+        f * (b.dx * la + b.value * a.dx / a.value),
+        f * (b.dy * la + b.value * a.dy / a.value));
+}
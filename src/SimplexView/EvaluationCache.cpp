@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "Dual.h"
+#include "Objective.h"
+#include "EvaluationCache.h"
+
+namespace EvaluationCacheParams {
+    // Points closer than this share a cache entry
+    constexpr double Quantum = 1e-12;
+
+    // Points farther than this from the origin are not cached
+    constexpr double MaxCoordinate = 1e6;
+
+    constexpr size_t SharedCapacity = 1 << 16;
+}
+
+EvaluationCache::EvaluationCache(size_t capacity)
+    : capacity_(capacity) {
+    index_.reserve(capacity_);
+}
+
+size_t EvaluationCache::KeyHash::operator()(const Key& k) const {
+    uint64_t h = k.objective;
+    h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(k.x);
+    h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(k.y);
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+bool EvaluationCache::make_key(const Objective& objective, double x, double y, Key& key) {
+    using namespace EvaluationCacheParams;
+    if (!(fabs(x) < MaxCoordinate && fabs(y) < MaxCoordinate)) {
+        return false;
+    }
+    key = Key{ objective.id(), llround(x / Quantum), llround(y / Quantum) };
+    return true;
+}
+
+EvaluationCache::Entry* EvaluationCache::find(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &entries_.front();
+}
+
+void EvaluationCache::insert(const Entry& entry) {
+    // Another thread may have evaluated the same point meanwhile
+    if (Entry* e = find(entry.key)) {
+        if (entry.gradient) {
+            *e = entry;
+        }
+        return;
+    }
+
+    if (entries_.size() >= capacity_) {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+    entries_.push_front(entry);
+    index_[entry.key] = entries_.begin();
+}
+
+double EvaluationCache::value(const Objective& objective, double x, double y, bool& hit) {
+    hit = false;
+    Key key;
+    if (capacity_ == 0 || !make_key(objective, x, y, key)) {
+        return objective(x, y);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (Entry* e = find(key)) {
+            hits_++;
+            hit = true;
+            return e->value;
+        }
+    }
+
+    misses_++;
+    double z = objective(x, y);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert(Entry{ key, z, 0.0, 0.0, false });
+    return z;
+}
+
+Dual EvaluationCache::gradient(const Objective& objective, double x, double y, bool& hit) {
+    hit = false;
+    Key key;
+    if (capacity_ == 0 || !make_key(objective, x, y, key)) {
+        return objective.gradient(x, y);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry* e = find(key);
+        if (e && e->gradient) {
+            hits_++;
+            hit = true;
+            return Dual(e->value, e->dx, e->dy);
+        }
+    }
+
+    misses_++;
+    Dual z = objective.gradient(x, y);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert(Entry{ key, z.value, z.dx, z.dy, true });
+    return z;
+}
+
+void EvaluationCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+}
+
+void EvaluationCache::reset_counters() {
+    hits_ = 0;
+    misses_ = 0;
+}
+
+size_t EvaluationCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+EvaluationCache& EvaluationCache::shared() {
+    static EvaluationCache cache(EvaluationCacheParams::SharedCapacity);
+    return cache;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+class Objective;
+struct Dual;
+
+/*
+ * Values and gradients of recently evaluated points of objectives. Points
+ * are hashed by the objective and the coordinates rounded to a fine grid,
+ * the least recently used ones are dropped when the cache is full. Safe to
+ * use from several threads, the objective is evaluated outside the lock.
+ */
+class EvaluationCache {
+public:
+    explicit EvaluationCache(size_t capacity);
+
+    EvaluationCache(const EvaluationCache&) = delete;
+    EvaluationCache& operator=(const EvaluationCache&) = delete;
+
+    // Hit is set if the objective was not evaluated
+    double value(const Objective& objective, double x, double y, bool& hit);
+
+    // Value and gradient, a cached value without the gradient is a miss
+    Dual gradient(const Objective& objective, double x, double y, bool& hit);
+
+    void clear();
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    void reset_counters();
+
+    size_t size() const;
+    size_t capacity() const { return capacity_; }
+
+    // Cache of func() and grad()
+    static EvaluationCache& shared();
+
+private:
+    struct Key {
+        unsigned objective;
+        int64_t x, y;
+
+        bool operator==(const Key& k) const {
+            return objective == k.objective && x == k.x && y == k.y;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const;
+    };
+
+    struct Entry {
+        Key key;
+        double value;
+        double dx, dy;
+        bool gradient;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    // False for points too far away to round to the grid
+    static bool make_key(const Objective& objective, double x, double y, Key& key);
+
+    // Entry moved to the front of the list, null if the key is missing
+    Entry* find(const Key& key);
+    void insert(const Entry& entry);
+
+private:
+    size_t capacity_{ 0 };
+
+    // Most recently used entries first
+    EntryList entries_;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index_;
+    mutable std::mutex mutex_;
+
+    std::atomic<size_t> hits_{ 0 }, misses_{ 0 };
+};
@@ -1,26 +1,60 @@
 #include "pch.h"
 #include "MathUtils.h"
+#include "Dual.h"
+#include "Objective.h"
+#include "EvaluationCache.h"
 #include "FuncUtils.h"
 
+// Evaluations counted below the cache
+thread_local size_t ThreadEvaluations = 0;
+
 double func(double x, double y) {
-    constexpr double a0 = -11.0;
-    constexpr double b0 = -7.0;
-    
-    double a = x * x + y + a0;
-    double b = x + y * y + b0;
+    const Objective& objective = Objectives::Current();
+    if (!objective.cached()) {
+        ThreadEvaluations++;
+        return objective(x, y);
+    }
 
-    return a * a + b * b;
+    bool hit = false;
+    double z = EvaluationCache::shared().value(objective, x, y, hit);
+    if (!hit) {
+        ThreadEvaluations++;
+    }
+    return z;
 }
 
-/* double func(double x, double y) {
-    y -= 2.0;
-    return (y-x*x)*(y-x*x)/750+(1-x)*(1-x)/50*(y-1)*(y-1)/30;
-} */
+Dual grad(double x, double y) {
+    const Objective& objective = Objectives::Current();
+    if (!objective.cached()) {
+        ThreadEvaluations++;
+        return objective.gradient(x, y);
+    }
+
+    bool hit = false;
+    Dual z = EvaluationCache::shared().gradient(objective, x, y, hit);
+    if (!hit) {
+        ThreadEvaluations++;
+    }
+    return z;
+}
 
-double dfdx(double x, double y) {
-    return (func(x + Epsilon, y) - func(x, y)) / Epsilon;
+size_t FuncEvaluations() {
+    return ThreadEvaluations;
 }
 
-double dfdy(double x, double y) {
-    return (func(x, y + Epsilon) - func(x, y)) / Epsilon;
+double MaxStep(double x, double y, double dx, double dy) {
+    double tmax = std::numeric_limits<double>::infinity();
+    if (dx > 0.0) {
+        tmax = std::min(tmax, (XMax - x) / dx);
+    }
+    else if (dx < 0.0) {
+        tmax = std::min(tmax, (XMin - x) / dx);
+    }
+    if (dy > 0.0) {
+        tmax = std::min(tmax, (YMax - y) / dy);
+    }
+    else if (dy < 0.0) {
+        tmax = std::min(tmax, (YMin - y) / dy);
+    }
+    return std::max(tmax, 0.0);
 }
@@ -1,11 +1,22 @@
 #pragma once
 
+struct Dual;
+
 const double XMin = -5.0;
 const double XMax = 5.0;
 const double YMin = -5.0;
 const double YMax = 5.0;
 
+// Largest step from (x, y) along (dx, dy) inside the domain
+double MaxStep(double x, double y, double dx, double dy);
+
+// Value of the current objective, see Objectives::Current. If the objective
+// is cached, points evaluated recently come from EvaluationCache::shared()
 double func(double x, double y);
 
-double dfdx(double x, double y);
-double dfdy(double x, double y);
+// Value and exact gradient of the current objective, one evaluation
+Dual grad(double x, double y);
+
+// Evaluations of the objective by func() and grad() on the calling thread,
+// points that come from the cache are not counted
+size_t FuncEvaluations();
@@ -1,64 +1,26 @@
 #include "pch.h"
+#include "SearchStats.h"
 #include "MathUtils.h"
 #include "FuncUtils.h"
 #include "GraphUtils.h"
 #include "SearchEngine.h"
 #include "GaussSEngine.h"
 
-const Fl_Color LineColor = fl_rgb_color(0);
-const Fl_Color PreviousMarkerColor = fl_rgb_color(128, 64, 0);
-const Fl_Color CurrentMarkerColor = fl_rgb_color(0, 64, 128);
-
 GaussSEngine::GaussSEngine() {
     set_start_point(XMin, YMin);
 }
 
-void GaussSEngine::draw(CoordinateFunc xFunc, CoordinateFunc yFunc) {
-    constexpr double PointSize = 0.1;
-    constexpr int LineWidth = 3;
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    float oldW{ 0.0f };
-    glGetFloatv(GL_LINE_WIDTH, &oldW);
-    glLineWidth(LineWidth);
-    SET_FL_COLOR_TO_GL(LineColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_line_style(FL_SOLID, LineWidth);
-    fl_color(LineColor);
-#endif
-
-    DrawLine(
-        xFunc(xold_), yFunc(yold_),
-        xFunc(x_), yFunc(y_));
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glLineWidth(oldW);
-    SET_FL_COLOR_TO_GL(PreviousMarkerColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(PreviousMarkerColor);
-#endif
-    DrawRectangle(
-        xFunc(xold_ - PointSize), yFunc(yold_ - PointSize),
-        xFunc(xold_ + PointSize), yFunc(yold_ + PointSize));
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(CurrentMarkerColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(CurrentMarkerColor);
-#endif
-    DrawRectangle(
-        xFunc(x_ - PointSize), yFunc(y_ - PointSize),
-        xFunc(x_ + PointSize), yFunc(y_ + PointSize));
+void GaussSEngine::draw(Painter& painter) const {
+    DrawStep(painter, xold_, yold_, x_, y_);
 }
 
-void GaussSEngine::search_start() {
+void GaussSEngine::start() {
     ddx_ = 10.0 * Epsilon;
     ddy_ = 10.0 * Epsilon;
 
     x_ = xold_ = xmin_ = xstart_;
     y_ = yold_ = ymin_ = ystart_;
-    zmin_ = func(xmin_, ymin_);
-    count_ = 1;
+    zmin_ = evaluate(xmin_, ymin_);
 
     // Сначала поиск ведется по x
     currentVar_ = 1;
@@ -66,11 +28,7 @@ void GaussSEngine::search_start() {
     search_over_ = false;
 }
 
-void GaussSEngine::search_step() {
-    if (search_over_) {
-        return;
-    }
-
+void GaussSEngine::step() {
     double dx{ 0.0 }, dy{ 0.0 };
     double x1{ 0.0 }, y1{ 0.0 }, z1{ 0.0 };
     double x2{ 0.0 }, y2{ 0.0 }, z2{ 0.0 };
@@ -89,13 +47,11 @@ void GaussSEngine::search_step() {
     // Начало работы метода тяжелого шарика
     x1 = x_;
     y1 = y_;
-    z1 = func(x1, y1);
+    z1 = evaluate(x1, y1);
 
     x2 = x1 + dx;
     y2 = y1 + dy;
-    z2 = func(x2, y2);
-
-    count_ += 2;
+    z2 = evaluate(x2, y2);
 
     while (z1 > z2) {
         if (currentVar_==1) {
@@ -113,8 +69,7 @@ void GaussSEngine::search_step() {
         if (px>XMax || py>YMax) {
             x1 = XMax;
             y1 = YMax;
-            z1 = func(x1, y1);
-            count_++;
+            z1 = evaluate(x1, y1);
             search_over_ = true;
 
             xold_ = xmin_;
@@ -127,8 +82,7 @@ void GaussSEngine::search_step() {
         z1 = z2;
         x2 = px;
         y2 = py;
-        z2 = func(x2, y2);
-        count_++;
+        z2 = evaluate(x2, y2);
     }
 
     search_over_ = almost_equal(z1, zmin_);
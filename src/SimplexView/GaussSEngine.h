@@ -4,10 +4,13 @@ class GaussSEngine: public SearchEngine {
 public:
     GaussSEngine();
 
-    void draw(CoordinateFunc xFunc, CoordinateFunc yFunc) override;
+    void draw(Painter& painter) const override;
 
-    void search_start() override;
-    void search_step() override;
+    std::unique_ptr<SearchEngine> clone() const override { return std::make_unique<GaussSEngine>(*this); }
+
+protected:
+    void start() override;
+    void step() override;
 
 private:
     double x_{ 0.0 }, y_{ 0.0 };
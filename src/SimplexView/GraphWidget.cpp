@@ -1,18 +1,26 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
+#include "SearchStats.h"
 #include "MathUtils.h"
 #include "FuncUtils.h"
+#include "Objective.h"
 #include "GraphUtils.h"
 #include "SearchEngine.h"
 #include "ContourPlot.h"
+#include "SurfaceTree.h"
 #include "GraphWidget.h"
 
 namespace PlotParams {
-    constexpr int XDivCount = 100;
-    constexpr int YDivCount = 100;
+    // Cells of the base grid, refined by the adaptive tree
+    constexpr int XDivCount = 12;
+    constexpr int YDivCount = 12;
 
     constexpr int TickCount = 20;
     constexpr int TickSize = 10;
     constexpr int Margin = 20;
+
+    constexpr int TextSize = 12;
 }
 
 // Palette: Blue, Green, Yellow
@@ -53,34 +61,6 @@ GraphWidget::GraphWidget(int X, int Y, int W, int H, SearchEngine* e, const char
     : Fl_Widget(X, Y, W, H, l)
 #endif
     , engine_(e) {
-    using namespace PlotParams;
-
-    boundingBox_ = {
-        HMM_Vec2{static_cast<float>(XMin), static_cast<float>(YMin)},
-        HMM_Vec2{static_cast<float>(XMax), static_cast<float>(YMin)},
-        HMM_Vec2{static_cast<float>(XMax), static_cast<float>(YMax)},
-        HMM_Vec2{static_cast<float>(XMin), static_cast<float>(YMax)}
-    };
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    xFunc_ = [=](double x) -> double {
-        return x;
-    };
-    yFunc_ = [=](double y) -> double {
-        return y;
-    };
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    xFunc_ = [=](double x) -> double {
-        return (x - XMin) / this->pixelX_ + Margin + TickSize;
-    };
-    yFunc_ = [=](double y) -> double {
-        return (YMax - y) / this->pixelY_ + Margin;
-    };
-#endif
-
-    contourLines_.resize(Palette.size());
-    contourFills_.resize(Palette.size());
-
     create_surface();
 
     update_size();
@@ -105,10 +85,10 @@ void GraphWidget::resize(int x, int y, int w, int h) {
 }
 
 void GraphWidget::draw() {
+    using namespace PlotParams;
+
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
     if (!this->valid()) {
-        using namespace PlotParams;
-
         update_size();
 
         glViewport(0, 0, this->w(), this->h());
@@ -132,20 +112,30 @@ void GraphWidget::draw() {
 #endif
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
+    // Plot coordinates are set by the projection
+    ScreenPainter painter([](double x) { return x; }, [](double y) { return y; });
+
     glClear(GL_COLOR_BUFFER_BIT);
     glLoadIdentity();
 
-    draw_contour_plot();
-    draw_contour_lines();
+    paint_contours(painter);
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
+    ScreenPainter painter(PlotToPixelX(XMin, pixelX_, Margin + TickSize),
+        PlotToPixelY(YMax, pixelY_, Margin));
+
+    if (!initOffscreen_) {
+        offscreen_ = fl_create_offscreen(this->w(), this->h());
+        contourOfs_ = fl_create_offscreen(this->w(), this->h());
+        initOffscreen_ = true;
+    }
+
     if (contourOfsNeedsRedraw_) {
         fl_begin_offscreen(contourOfs_);
 
         fl_color(fl_rgb_color(255));
         fl_rectf(0, 0, this->w(), this->h());
 
-        draw_contour_plot();
-        draw_contour_lines();
+        paint_contours(painter);
 
         fl_end_offscreen();
 
@@ -157,13 +147,7 @@ void GraphWidget::draw() {
     fl_copy_offscreen(0, 0, w(), h(), contourOfs_, 0, 0);
 #endif
 
-    draw_engine_status();
-
-    draw_box();
-
-    draw_ticks();
-
-    draw_legend();
+    paint_overlay(painter, pixelX_, pixelY_);
 
 #if DRAW_METHOD==DRAW_METHOD_FLTK
     fl_end_offscreen();
@@ -173,116 +157,73 @@ void GraphWidget::draw() {
 #endif
 }
 
-void GraphWidget::draw_contour_plot() {
-    for (size_t i = 0; i < Palette.size(); i++) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        SET_FL_COLOR_TO_GL(Palette[i]);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_color(Palette[i]);
-#endif
-        contourFills_[i].render(xFunc_, yFunc_);
-    }
-}
+void GraphWidget::render(Canvas& canvas) const {
+    using namespace PlotParams;
 
-void GraphWidget::draw_contour_lines() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(ColorLevelLines);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(ColorLevelLines);
-#endif
-    for (const auto& p : contourLines_) {
-        p.render(xFunc_, yFunc_);
-    }
-}
+    double px = (XMax - XMin) / (canvas.width() - Margin * 2 - TickSize);
+    double py = (YMax - YMin) / (canvas.height() - Margin * 2 - TickSize);
 
-void GraphWidget::draw_engine_status() {
-    if (engine_) {
-        engine_->draw(xFunc_, yFunc_);
-    }
-}
+    canvas.clear({ 255, 255, 255, 255 });
 
-void GraphWidget::draw_box() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(ColorTicks);
-    glEnableClientState(GL_VERTEX_ARRAY);
+    CanvasPainter painter(canvas, PlotToPixelX(XMin, px, Margin + TickSize),
+        PlotToPixelY(YMax, py, Margin));
+    paint_contours(painter);
+    paint_overlay(painter, px, py);
+}
 
-    glVertexPointer(2, GL_FLOAT, 0, boundingBox_.data());
-    glDrawArrays(GL_LINE_LOOP, 0, 4);
+void GraphWidget::paint_contours(Painter& painter) const {
+    painter.set_line_width(1);
 
-    glDisableClientState(GL_VERTEX_ARRAY);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(ColorTicks);
-    fl_line_style(FL_SOLID, 1);
+    for (size_t i = 0; i < contours_->size(); i++) {
+        painter.set_color(Palette[i]);
+        contours_->fill(i).draw(painter);
+    }
 
-    fl_begin_loop();
-    for (const auto& p : boundingBox_) {
-        fl_vertex(xFunc_(p.X), yFunc_(p.Y));
+    painter.set_color(ColorLevelLines);
+    for (size_t i = 0; i < contours_->size(); i++) {
+        contours_->line(i).draw(painter);
     }
-    fl_end_loop();
-#endif
 }
 
-void GraphWidget::draw_ticks() {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
+void GraphWidget::paint_overlay(Painter& painter, double pixelX, double pixelY) const {
     using namespace PlotParams;
 
-    SET_FL_COLOR_TO_GL(ColorTicks);
-    glEnableClientState(GL_VERTEX_ARRAY);
-
-    if (ticksX_.size() > 0) {
-        glVertexPointer(2, GL_FLOAT, 0, ticksX_.data());
-        glDrawArrays(GL_LINES, 0, (TickCount + 1) * 2);
+    if (engine_) {
+        engine_->draw(painter);
     }
 
-    if (ticksY_.size() > 0) {
-        glVertexPointer(2, GL_FLOAT, 0, ticksY_.data());
-        glDrawArrays(GL_LINES, 0, (TickCount + 1) * 2);
-    }
+    // Box and ticks
+    painter.set_color(ColorTicks);
+    painter.set_line_width(1);
 
-    glDisableClientState(GL_VERTEX_ARRAY);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(ColorTicks);
-    fl_line_style(FL_SOLID, 1);
-
-    for (size_t i = 0; i < ticksX_.size(); i += 2) {
-        const auto& p1 = ticksX_[i];
-        const auto& p2 = ticksX_[i + 1];
-        fl_line(xFunc_(p1.X), yFunc_(p1.Y),
-            xFunc_(p2.X), yFunc_(p2.Y));
-    }
+    painter.line(XMin, YMin, XMax, YMin);
+    painter.line(XMax, YMin, XMax, YMax);
+    painter.line(XMax, YMax, XMin, YMax);
+    painter.line(XMin, YMax, XMin, YMin);
 
-    for (size_t i = 0; i < ticksY_.size(); i += 2) {
-        const auto& p1 = ticksY_[i];
-        const auto& p2 = ticksY_[i + 1];
-        fl_line(xFunc_(p1.X), yFunc_(p1.Y),
-            xFunc_(p2.X), yFunc_(p2.Y));
-    }
-#endif
-}
+    for (int i = 0; i <= TickCount; i++) {
+        double tickScale = (i % 2) ? 0.5 : 1.0;
 
-void GraphWidget::draw_legend() {
-    using namespace PlotParams;
+        double x = XMin + i * (XMax - XMin) / TickCount;
+        painter.line(x, YMin, x, YMin - TickSize * pixelY * tickScale);
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    void* font = GLUT_BITMAP_HELVETICA_12;
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    auto font = reinterpret_cast<void*>(12);
-#endif
+        double y = YMin + i * (YMax - YMin) / TickCount;
+        painter.line(XMin, y, XMin - TickSize * pixelX * tickScale, y);
+    }
 
-    PrintText(font,
-        xFunc_(XMin), yFunc_(YMin - pixelY_ * (Margin / 2 + TickSize)),
+    // Legend
+    painter.set_text_size(TextSize);
+
+    painter.text(XMin, YMin - pixelY * (Margin / 2 + TickSize),
         0, "%.1f", XMin);
 
-    PrintText(font,
-        xFunc_(XMax), yFunc_(YMin - pixelY_ * (Margin / 2 + TickSize)),
+    painter.text(XMax, YMin - pixelY * (Margin / 2 + TickSize),
         0, "%.1f", XMax);
 
-    PrintText(font,
-        xFunc_(XMin - pixelX_ * (Margin / 2 + TickSize)), yFunc_(YMax - pixelY_ * (Margin / 2)),
+    painter.text(XMin - pixelX * (Margin / 2 + TickSize), YMax - pixelY * (Margin / 2),
         0, "%.1f", YMax);
 
-    PrintText(font,
-        xFunc_(XMin - pixelX_ * (Margin / 2 + TickSize)), yFunc_(YMin + pixelY_ * (Margin / 2)),
+    painter.text(XMin - pixelX * (Margin / 2 + TickSize), YMin + pixelY * (Margin / 2),
         0, "%.1f", YMin);
 }
 
@@ -293,37 +234,14 @@ void GraphWidget::update_size() {
     pixelX_ = (XMax - XMin) / (this->w() - Margin * 2 - TickSize);
     pixelY_ = (YMax - YMin) / (this->h() - Margin * 2 - TickSize);
 
-    /* Y Ticks */
-    ticksY_.resize((TickCount + 1) * 2);
-    float dTickY = (YMax - YMin) / static_cast<float>(TickCount);
-    for (size_t i = 0; i <= TickCount; i++) {
-        float y = YMin + static_cast<float>(i) * dTickY;
-        float tickScale = (i % 2) ? 0.5f : 1.0f;
-        ticksY_[i * 2] = HMM_Vec2{ static_cast<float>(XMin), y };
-        ticksY_[i * 2 + 1] = HMM_Vec2{ static_cast<float>(XMin - TickSize * pixelX_ * tickScale), y };
-    }
-
-    /* X Ticks */
-    ticksX_.resize((TickCount + 1) * 2);
-    float dTickX = (XMax - XMin) / static_cast<float>(TickCount);
-    for (size_t i = 0; i <= TickCount; i++) {
-        float x = XMin + static_cast<float>(i) * dTickX;
-        float tickScale = (i % 2) ? 0.5f : 1.0f;
-        ticksX_[i * 2] = HMM_Vec2{ static_cast<float>(x), static_cast<float>(YMin) };
-        ticksX_[i * 2 + 1] = HMM_Vec2{ static_cast<float>(x), static_cast<float>(YMin - TickSize * pixelY_ * tickScale) };
-    }
-
 #if DRAW_METHOD==DRAW_METHOD_FLTK
+    // Contours and the frame are drawn again into buffers of the new size
     if (initOffscreen_) {
         fl_delete_offscreen(offscreen_);
         fl_delete_offscreen(contourOfs_);
+        initOffscreen_ = false;
     }
 
-    offscreen_ = fl_create_offscreen(this->w(), this->h());
-    contourOfs_ = fl_create_offscreen(this->w(), this->h());
-
-    initOffscreen_ = true;
-
     contourOfsNeedsRedraw_ = true;
 #endif
 }
@@ -343,11 +261,9 @@ int GraphWidget::handle(int e) {
             if (x>=0 && x<=(this->w() - Margin * 2 - TickSize) &&
                 y>=0 && y<=(this->h() - Margin * 2 - TickSize)) {
 
-                float sx = XMin + static_cast<float>(x) * pixelX_;
-                float sy = YMax - static_cast<float>(y) * pixelY_;
-                if (engine_) {
-                    engine_->set_start_point(sx, sy);
-                }
+                xstart_ = XMin + static_cast<float>(x) * pixelX_;
+                ystart_ = YMax - static_cast<float>(y) * pixelY_;
+                this->do_callback();
                 this->redraw();
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
                 this->invalidate();
@@ -367,30 +283,31 @@ int GraphWidget::handle(int e) {
 void GraphWidget::create_surface() {
     using namespace PlotParams;
 
-    int rows = YDivCount + 1, cols = XDivCount + 1;
-    float zmin = 0.0f, zmax = 0.0f;
-    float dx = (XMax - XMin) / static_cast<float>(cols);
-    float dy = (YMax - YMin) / static_cast<float>(rows);
-    std::vector<float> points(rows * cols);
-
-    for (int j=0; j<rows; j++) {
-        float y = YMin + static_cast<float>(j) * dy;
-        for (int i=0; i<cols; i++) {
-            float x = XMin + static_cast<float>(i) * dx;
-            float z = func(x, y);
-            points[j * cols + i] = z;
-            if (zmin>z) zmin = z;
-            if (zmax<z) zmax = z;
-        }
+    auto grid = SurfaceGrid::sample(Objectives::Current(), XDivCount + 1, YDivCount + 1,
+        XMin, YMin, XMax, YMax);
+
+    // The base grid misses the minima, levels start from zero to cover them.
+    // Objectives with negative values start a level below the sampled minimum
+    float zmin = std::min(grid->zmin, 0.0f);
+    if (zmin < 0.0f) {
+        zmin -= (grid->zmax - zmin) / static_cast<float>(Palette.size() * Palette.size());
     }
+    float dz = sqrt(grid->zmax - zmin) / static_cast<float>(Palette.size());
 
-    float dz = (sqrt(zmax) - sqrt(zmin)) / static_cast<float>(Palette.size());
+    std::vector<float> levels(Palette.size());
+    for (size_t i=0; i < levels.size(); i++) {
+        float z = static_cast<float>(i) * dz;
+        levels[i] = zmin + z*z;
+    }
 
-    for (size_t i=0; i < Palette.size(); i++) {
-        float z = sqrt(zmin) + static_cast<float>(i) * dz;
-        contourLines_[i].init(points, cols, rows,
-            XMin, YMin, XMax, YMax, z*z);
-        contourFills_[i].init(points, cols, rows,
-            XMin, YMin, XMax, YMax, z*z);
+    auto tree = SurfaceTree::sample(grid, levels);
+    auto contours = ContourMap::build(tree, levels);
+    if (contours == contours_) {
+        return;
     }
+    contours_ = contours;
+
+#if DRAW_METHOD==DRAW_METHOD_FLTK
+    contourOfsNeedsRedraw_ = true;
+#endif
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+class Canvas;
+class Painter;
+
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
 class GraphWidget : public Fl_Gl_Window {
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
@@ -9,38 +12,39 @@ public:
     GraphWidget(int X, int Y, int W, int H, SearchEngine* e, const char* l = nullptr);
     ~GraphWidget();
 
+    // Contours are rebuilt only when the function or the domain change
     void create_surface();
 
     void engine(SearchEngine *e) { engine_ = e; }
 
+    // Point clicked last, the widget callback sets it as the start point
+    float xstart() const { return xstart_; }
+    float ystart() const { return ystart_; }
+
     int handle(int e) FL_OVERRIDE;
     void resize(int x, int y, int w, int h) FL_OVERRIDE;
 
     void draw() FL_OVERRIDE;
 
+    // Rasterise the plot on the CPU, the widget does not need to be shown
+    void render(Canvas& canvas) const;
+
 private:
-    void draw_contour_plot();
-    void draw_contour_lines();
-    void draw_engine_status();
-    void draw_box();
-    void draw_ticks();
-    void draw_legend();
+    // Contours are cached apart from the rest by the FLTK drawing
+    void paint_contours(Painter& painter) const;
+
+    // Engine state, box, ticks and legend. Pixel sizes are in plot units
+    void paint_overlay(Painter& painter, double pixelX, double pixelY) const;
 
     void update_size();
 
 private:
     float pixelX_{ 0.0f }, pixelY_{ 0.0f };
 
-    std::vector<ContourLine> contourLines_;
-    std::vector<ContourFill> contourFills_;
-
-    std::vector<HMM_Vec2> boundingBox_;
-    std::vector<HMM_Vec2> ticksX_;
-    std::vector<HMM_Vec2> ticksY_;
+    std::shared_ptr<const ContourMap> contours_;
 
     SearchEngine* engine_{ nullptr };
-
-    CoordinateFunc xFunc_, yFunc_;
+    float xstart_{ 0.0f }, ystart_{ 0.0f };
 
 #if DRAW_METHOD==DRAW_METHOD_FLTK
     bool initOffscreen_{ false };
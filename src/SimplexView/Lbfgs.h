@@ -0,0 +1,223 @@
+#pragma once
+
+#include "LineSearch.h"
+
+/*
+ * Limited-memory BFGS method for a function of n parameters with a gradient.
+ * The last m steps and changes of the gradient are kept in a ring buffer
+ * allocated once, and the two-loop recursion turns them into a direction in
+ * O(mn) operations, so the method works for thousands of parameters.
+ * The function is any callable double(const double* x, double* g) that
+ * returns the value and writes the gradient to g. Steps satisfy the strong
+ * Wolfe conditions, optional bounds keep them inside a box.
+ */
+template <typename Function>
+class Lbfgs {
+public:
+    Lbfgs(size_t dimension, size_t memory, Function func)
+            : n_(dimension), m_(memory), func_(std::move(func)) {
+        x_.resize(n_);
+        g_.resize(n_);
+        d_.resize(n_);
+        trial_.resize(n_);
+        trialGradient_.resize(n_);
+        s_.resize(m_ * n_);
+        y_.resize(m_ * n_);
+        rho_.resize(m_);
+        alpha_.resize(m_);
+    }
+
+    // Box of the parameters, no bounds by default
+    void set_bounds(const double* lower, const double* upper) {
+        lower_.assign(lower, lower + n_);
+        upper_.assign(upper, upper + n_);
+    }
+
+    void start(const double* x0) {
+        std::copy_n(x0, n_, x_.begin());
+        evaluations_ = 0;
+        value_ = evaluate(x_.data(), g_.data());
+        count_ = 0;
+        head_ = 0;
+    }
+
+    // One iteration, false if the function does not decrease any more
+    bool step() {
+        direction();
+        clip();
+        double slope = dot(g_.data(), d_.data());
+        if (slope >= 0.0) {
+            // Curvature pairs give no descent, start over along the antigradient
+            count_ = 0;
+            for (size_t k = 0; k < n_; k++) {
+                d_[k] = -g_[k];
+            }
+            clip();
+            slope = dot(g_.data(), d_.data());
+            if (slope >= 0.0) {
+                return false;
+            }
+        }
+
+        // Without history the first step moves by the unit length
+        double step = (count_ > 0) ? 1.0 : 1.0 / sqrt(dot(d_.data(), d_.data()));
+
+        double last = -1.0;
+        auto phi = [this, &last](double t) {
+            move(t);
+            last = t;
+            double value = evaluate(trial_.data(), trialGradient_.data());
+            return LineSearch::Point{ t, value, dot(trialGradient_.data(), d_.data()) };
+        };
+        LineSearch::Result line = LineSearch::Wolfe(
+            phi, LineSearch::Point{ 0.0, value_, slope }, step, max_step());
+
+        if (line.point.t <= 0.0 || line.point.value >= value_) {
+            return false;
+        }
+        if (line.point.t != last) {
+            // The accepted step is not the last one evaluated
+            move(line.point.t);
+            evaluate(trial_.data(), trialGradient_.data());
+        }
+
+        // Newest pair replaces the oldest one, pairs without positive
+        // curvature would spoil the Hessian
+        double sy = 0.0;
+        for (size_t k = 0; k < n_; k++) {
+            sy += (trial_[k] - x_[k]) * (trialGradient_[k] - g_[k]);
+        }
+        if (sy > 0.0) {
+            double* s = &s_[head_ * n_];
+            double* y = &y_[head_ * n_];
+            for (size_t k = 0; k < n_; k++) {
+                s[k] = trial_[k] - x_[k];
+                y[k] = trialGradient_[k] - g_[k];
+            }
+            rho_[head_] = 1.0 / sy;
+            head_ = (head_ + 1) % m_;
+            count_ = std::min(count_ + 1, m_);
+        }
+
+        x_.swap(trial_);
+        g_.swap(trialGradient_);
+        value_ = line.point.value;
+        return true;
+    }
+
+    size_t dimension() const { return n_; }
+    const double* x() const { return x_.data(); }
+    double value() const { return value_; }
+    const double* gradient() const { return g_.data(); }
+    double gradient_norm() const { return sqrt(dot(g_.data(), g_.data())); }
+
+    size_t evaluations() const { return evaluations_; }
+
+    // Pairs of steps and gradient changes kept, m at most
+    size_t history() const { return count_; }
+
+private:
+    double evaluate(const double* x, double* g) {
+        evaluations_++;
+        return func_(x, g);
+    }
+
+    double dot(const double* a, const double* b) const {
+        double s = 0.0;
+        for (size_t k = 0; k < n_; k++) {
+            s += a[k] * b[k];
+        }
+        return s;
+    }
+
+    // d = -H g by the two-loop recursion, newest pairs first
+    void direction() {
+        for (size_t k = 0; k < n_; k++) {
+            d_[k] = -g_[k];
+        }
+        for (size_t j = 0; j < count_; j++) {
+            size_t i = (head_ + m_ - 1 - j) % m_;
+            const double* s = &s_[i * n_];
+            const double* y = &y_[i * n_];
+            alpha_[i] = rho_[i] * dot(s, d_.data());
+            for (size_t k = 0; k < n_; k++) {
+                d_[k] -= alpha_[i] * y[k];
+            }
+        }
+        if (count_ > 0) {
+            // Initial Hessian scaled to the curvature of the newest step
+            size_t i = (head_ + m_ - 1) % m_;
+            const double* y = &y_[i * n_];
+            double gamma = 1.0 / (rho_[i] * dot(y, y));
+            for (size_t k = 0; k < n_; k++) {
+                d_[k] *= gamma;
+            }
+        }
+        for (size_t j = count_; j > 0; j--) {
+            size_t i = (head_ + m_ - j) % m_;
+            const double* s = &s_[i * n_];
+            const double* y = &y_[i * n_];
+            double beta = rho_[i] * dot(y, d_.data());
+            for (size_t k = 0; k < n_; k++) {
+                d_[k] += (alpha_[i] - beta) * s[k];
+            }
+        }
+    }
+
+    // Directions stop at the sides of the box the point lies on
+    void clip() {
+        if (lower_.empty()) {
+            return;
+        }
+        for (size_t k = 0; k < n_; k++) {
+            if ((x_[k] <= lower_[k] && d_[k] < 0.0) || (x_[k] >= upper_[k] && d_[k] > 0.0)) {
+                d_[k] = 0.0;
+            }
+        }
+    }
+
+    double max_step() const {
+        double tmax = std::numeric_limits<double>::infinity();
+        if (lower_.empty()) {
+            return tmax;
+        }
+        for (size_t k = 0; k < n_; k++) {
+            if (d_[k] > 0.0) {
+                tmax = std::min(tmax, (upper_[k] - x_[k]) / d_[k]);
+            }
+            else if (d_[k] < 0.0) {
+                tmax = std::min(tmax, (lower_[k] - x_[k]) / d_[k]);
+            }
+        }
+        return std::max(tmax, 0.0);
+    }
+
+    void move(double t) {
+        for (size_t k = 0; k < n_; k++) {
+            trial_[k] = x_[k] + t * d_[k];
+        }
+        // Rounding may step over the side the largest step ends on
+        if (!lower_.empty()) {
+            for (size_t k = 0; k < n_; k++) {
+                trial_[k] = std::min(std::max(trial_[k], lower_[k]), upper_[k]);
+            }
+        }
+    }
+
+private:
+    size_t n_{ 0 }, m_{ 0 };
+    Function func_;
+
+    std::vector<double> x_, g_, d_;
+    double value_{ 0.0 };
+    std::vector<double> trial_, trialGradient_;
+
+    std::vector<double> lower_, upper_;
+
+    // Ring buffer of m pairs, head_ is the slot of the next pair
+    std::vector<double> s_, y_;
+    std::vector<double> rho_, alpha_;
+    size_t head_{ 0 }, count_{ 0 };
+
+    size_t evaluations_{ 0 };
+};
@@ -0,0 +1,58 @@
+#include "pch.h"
+#include "SearchStats.h"
+#include "MathUtils.h"
+#include "Dual.h"
+#include "FuncUtils.h"
+#include "GraphUtils.h"
+#include "LineSearch.h"
+#include "Lbfgs.h"
+#include "SearchEngine.h"
+#include "LbfgsEngine.h"
+
+namespace LbfgsParams {
+    // Pairs of steps and gradient changes kept by the method
+    constexpr size_t Memory = 5;
+}
+
+LbfgsEngine::LbfgsEngine()
+        : method_(2, LbfgsParams::Memory, [](const double* x, double* g) {
+            Dual z = grad(x[0], x[1]);
+            g[0] = z.dx;
+            g[1] = z.dy;
+            return z.value;
+        }) {
+    const double lower[] = { XMin, YMin };
+    const double upper[] = { XMax, YMax };
+    method_.set_bounds(lower, upper);
+
+    set_start_point(XMin, YMin);
+}
+
+void LbfgsEngine::draw(Painter& painter) const {
+    DrawStep(painter, xold_, yold_, xmin_, ymin_);
+}
+
+void LbfgsEngine::start() {
+    const double x0[] = { xstart_, ystart_ };
+    method_.start(x0);
+
+    xold_ = xmin_ = xstart_;
+    yold_ = ymin_ = ystart_;
+    zmin_ = method_.value();
+
+    search_over_ = false;
+}
+
+void LbfgsEngine::step() {
+    bool moved = method_.gradient_norm() >= Epsilon && method_.step();
+
+    xold_ = xmin_;
+    yold_ = ymin_;
+    if (!moved) {
+        search_over_ = true;
+        return;
+    }
+    xmin_ = method_.x()[0];
+    ymin_ = method_.x()[1];
+    zmin_ = method_.value();
+}
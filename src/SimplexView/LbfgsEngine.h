@@ -0,0 +1,23 @@
+#pragma once
+
+using LbfgsFunction = std::function<double(const double* x, double* g)>;
+
+/*
+ * Limited-memory BFGS method on the objective of two parameters, see Lbfgs.
+ */
+class LbfgsEngine: public SearchEngine {
+public:
+    LbfgsEngine();
+
+    void draw(Painter& painter) const override;
+
+    std::unique_ptr<SearchEngine> clone() const override { return std::make_unique<LbfgsEngine>(*this); }
+
+protected:
+    void start() override;
+    void step() override;
+
+private:
+    Lbfgs<LbfgsFunction> method_;
+    double xold_{ 0.0 }, yold_{ 0.0 };
+};
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "LineSearch.h"
+
+LineSearch::Result Brent(const LineSearch::Function& phi, double lo, const LineSearch::Point& b, double hi, double tolerance) {
+    using namespace LineSearchParams;
+
+    LineSearch::Result result;
+    double x = b.t, w = b.t, v = b.t;
+    double fx = b.value, fw = b.value, fv = b.value;
+    double d = 0.0, e = 0.0;
+
+    for (int i = 0; i < MaxIterations; i++) {
+        double xm = 0.5 * (lo + hi);
+        double tol1 = RelativeTolerance * fabs(x) + tolerance;
+        double tol2 = 2.0 * tol1;
+        if (fabs(x - xm) <= tol2 - 0.5 * (hi - lo)) {
+            break;
+        }
+
+        // Parabola through x, w and v when it is trusted, golden section otherwise
+        bool golden = true;
+        if (fabs(e) > tol1) {
+            double r = (x - w) * (fx - fv);
+            double q = (x - v) * (fx - fw);
+            double p = (x - v) * q - (x - w) * r;
+            q = 2.0 * (q - r);
+            if (q > 0.0) {
+                p = -p;
+            }
+            q = fabs(q);
+            double etemp = e;
+            e = d;
+            if (fabs(p) < fabs(0.5 * q * etemp) && p > q * (lo - x) && p < q * (hi - x)) {
+                d = p / q;
+                double u = x + d;
+                if (u - lo < tol2 || hi - u < tol2) {
+                    d = copysign(tol1, xm - x);
+                }
+                golden = false;
+            }
+        }
+        if (golden) {
+            e = (x >= xm) ? lo - x : hi - x;
+            d = GoldenSection * e;
+        }
+
+        double u = (fabs(d) >= tol1) ? x + d : x + copysign(tol1, d);
+        double fu = phi(u);
+        result.evaluations++;
+
+        if (fu <= fx) {
+            if (u >= x) {
+                lo = x;
+            }
+            else {
+                hi = x;
+            }
+            v = w; fv = fw;
+            w = x; fw = fx;
+            x = u; fx = fu;
+        }
+        else {
+            if (u < x) {
+                lo = u;
+            }
+            else {
+                hi = u;
+            }
+            if (fu <= fw || w == x) {
+                v = w; fv = fw;
+                w = u; fw = fu;
+            }
+            else if (fu <= fv || v == x || v == w) {
+                v = u; fv = fu;
+            }
+        }
+    }
+
+    result.point.t = x;
+    result.point.value = fx;
+    return result;
+}
+
+LineSearch::Result LineSearch::Minimize(const Function& phi, double f0, double step, double tmax, double tolerance) {
+    using namespace LineSearchParams;
+
+    Result result;
+    result.point.value = f0;
+    if (tmax <= 0.0) {
+        return result;
+    }
+
+    auto evaluate = [&](double t) {
+        result.evaluations++;
+        return Point{ t, phi(t), 0.0 };
+    };
+
+    // Bracket a < b < c with phi(b) below phi(a) and phi(c)
+    Point a = result.point;
+    Point b = evaluate(std::min(step, tmax));
+    Point c;
+    if (b.value >= a.value) {
+        c = b;
+        do {
+            if (c.t <= tolerance) {
+                return result;
+            }
+            b = evaluate(Shrinking * c.t);
+            if (b.value >= a.value) {
+                c = b;
+            }
+        } while (b.value >= a.value);
+    }
+    else {
+        for (;;) {
+            if (b.t >= tmax) {
+                // Minimum on the boundary of the domain
+                result.point = b;
+                return result;
+            }
+            c = evaluate(std::min(b.t + Expansion * (b.t - a.t), tmax));
+            if (c.value >= b.value) {
+                break;
+            }
+            a = b;
+            b = c;
+        }
+    }
+
+    int evaluations = result.evaluations;
+    result = Brent(phi, a.t, b, c.t, tolerance);
+    result.evaluations += evaluations;
+    return result;
+}
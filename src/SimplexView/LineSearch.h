@@ -0,0 +1,150 @@
+#pragma once
+
+/*
+ * Line searches on the function phi(t) = F(x + t d) of the step length t
+ * along a direction d. The exact search brackets the minimum and refines it
+ * with Brent's method, the Wolfe search stops at the first step with enough
+ * decrease and a flat enough slope, which quasi-Newton methods need.
+ * Steps are limited to [0, tmax], so searches stay inside the domain. The
+ * Wolfe search is inline and depends on nothing but the standard library,
+ * so header-only methods such as Lbfgs use it as it is.
+ */
+namespace LineSearchParams {
+    // Growth of the step while the minimum is not bracketed
+    constexpr double Expansion = 1.618034;
+
+    // Shrinking of the step while phi does not decrease
+    constexpr double Shrinking = 0.381966;
+
+    // Golden section of Brent's method
+    constexpr double GoldenSection = 0.381966;
+
+    // Tolerance of Brent's method relative to the step
+    constexpr double RelativeTolerance = 1e-8;
+
+    // Sufficient decrease and curvature constants of the Wolfe conditions
+    constexpr double Decrease = 1e-4;
+    constexpr double Curvature = 0.9;
+
+    // Interpolated steps keep this share of the bracket from its ends
+    constexpr double Safeguard = 0.1;
+
+    constexpr int MaxIterations = 100;
+}
+
+namespace LineSearch {
+    struct Point {
+        double t{ 0.0 };
+        double value{ 0.0 };
+        double slope{ 0.0 }; // Derivative of phi by t, used by the Wolfe search
+    };
+
+    struct Result {
+        Point point;
+        int evaluations{ 0 };
+    };
+
+    using Function = std::function<double(double t)>;
+    using SlopeFunction = std::function<Point(double t)>;
+
+    // Local minimum of phi starting with the step and refined until the
+    // bracket is shorter than the tolerance, t = 0 if phi does not decrease
+    Result Minimize(const Function& phi, double f0, double step, double tmax, double tolerance);
+
+    // Minimum of the cubic through two points with slopes, bisection if the
+    // minimum does not exist or lies too close to the ends
+    inline double Interpolate(const Point& lo, const Point& hi) {
+        using namespace LineSearchParams;
+
+        double d1 = lo.slope + hi.slope - 3.0 * (lo.value - hi.value) / (lo.t - hi.t);
+        double s = d1 * d1 - lo.slope * hi.slope;
+        double mid = 0.5 * (lo.t + hi.t);
+        if (s < 0.0) {
+            return mid;
+        }
+
+        double d2 = copysign(sqrt(s), hi.t - lo.t);
+        double t = hi.t - (hi.t - lo.t) * (hi.slope + d2 - d1) / (hi.slope - lo.slope + 2.0 * d2);
+
+        double a = std::min(lo.t, hi.t), b = std::max(lo.t, hi.t);
+        double margin = Safeguard * (b - a);
+        if (!std::isfinite(t) || t < a + margin || t > b - margin) {
+            return mid;
+        }
+        return t;
+    }
+
+    // Step with the strong Wolfe conditions for p0 = phi(0) with the
+    // negative slope, t = 0 if no step decreases phi enough
+    inline Result Wolfe(const SlopeFunction& phi, const Point& p0, double step, double tmax) {
+        using namespace LineSearchParams;
+
+        Result result;
+        result.point = p0;
+        if (tmax <= 0.0 || p0.slope >= 0.0) {
+            return result;
+        }
+
+        auto evaluate = [&](double t) {
+            result.evaluations++;
+            return phi(t);
+        };
+        auto decreased = [&](const Point& p) {
+            return p.value <= p0.value + Decrease * p.t * p0.slope;
+        };
+        auto flat = [&](const Point& p) {
+            return fabs(p.slope) <= -Curvature * p0.slope;
+        };
+
+        // Steps of phi(lo) < phi(hi) around a step with the Wolfe conditions
+        auto zoom = [&](Point lo, Point hi) {
+            for (int i = 0; i < MaxIterations && lo.t != hi.t; i++) {
+                Point p = evaluate(Interpolate(lo, hi));
+                if (!decreased(p) || p.value >= lo.value) {
+                    hi = p;
+                }
+                else {
+                    if (flat(p)) {
+                        return p;
+                    }
+                    if (p.slope * (hi.t - lo.t) >= 0.0) {
+                        hi = lo;
+                    }
+                    lo = p;
+                }
+                if (fabs(hi.t - lo.t) <= RelativeTolerance * fabs(lo.t)) {
+                    break;
+                }
+            }
+            return lo;
+        };
+
+        Point prev = p0;
+        double t = std::min(step, tmax);
+        for (int i = 0; i < MaxIterations; i++) {
+            Point p = evaluate(t);
+            if (!decreased(p) || (i > 0 && p.value >= prev.value)) {
+                result.point = zoom(prev, p);
+                return result;
+            }
+            if (flat(p)) {
+                result.point = p;
+                return result;
+            }
+            if (p.slope >= 0.0) {
+                result.point = zoom(p, prev);
+                return result;
+            }
+            if (t >= tmax) {
+                // Still decreasing on the boundary of the domain
+                result.point = p;
+                return result;
+            }
+            prev = p;
+            t = std::min(Expansion * t, tmax);
+        }
+
+        result.point = prev;
+        return result;
+    }
+}
@@ -1,20 +1,39 @@
 #include "pch.h"
+#include "SnapshotSlot.h"
+#include "BackgroundSolver.h"
+#include "SearchStats.h"
 #include "MathUtils.h"
 #include "FuncUtils.h"
+#include "Objective.h"
+#include "EvaluationCache.h"
 #include "GraphUtils.h"
+#include "NelderMead.h"
 #include "Simplex.h"
+#include "SimplexHistory.h"
 #include "SearchEngine.h"
 #include "SimplexEngine.h"
 #include "GaussSEngine.h"
 #include "DescentEngine.h"
 #include "RelaxationEngine.h"
+#include "BfgsEngine.h"
+#include "LineSearch.h"
+#include "Lbfgs.h"
+#include "LbfgsEngine.h"
 #include "ScanEngine.h"
+#include "MultiStartEngine.h"
 #include "ContourPlot.h"
 #include "GraphWidget.h"
 #include "MainWindow.h"
 
+// Pause between the steps unless the search runs at full speed
 constexpr double TimerInterval = 1.0;
 
+// The window shows the latest state of the search at the display rate
+constexpr double DisplayInterval = 1.0 / 60.0;
+
+// Himmelblau's function, the default objective, as an example of expressions
+const char* DefaultExpression = "(x^2 + y - 11)^2 + (x + y^2 - 7)^2";
+
 MainWindow::MainWindow(int w, int h, const char* title)
         : Fl_Window(w, h, title) {
     begin();
@@ -23,10 +42,14 @@ MainWindow::MainWindow(int w, int h, const char* title)
     engines_.push_back({"Gauss-Seidel method", std::make_unique<GaussSEngine>()});
     engines_.push_back({"Gradient descent", std::make_unique<DescentEngine>()});
     engines_.push_back({"Coordinate descent", std::make_unique<RelaxationEngine>()});
+    engines_.push_back({"BFGS method", std::make_unique<BfgsEngine>()});
+    engines_.push_back({"L-BFGS method", std::make_unique<LbfgsEngine>()});
     engines_.push_back({"Scaning", std::make_unique<ScanEngine>()});
+    engines_.push_back({"Multi-start", std::make_unique<MultiStartEngine>()});
     current_engine_ = 0;
 
     graph_ = new GraphWidget(5, 5, 490, 490, std::get<1>(engines_.at(current_engine_)).get(), "Plot of F(x,y)");
+    graph_->callback(set_start_cb, static_cast<void*>(this));
 
     buffer_ = new Fl_Text_Buffer(1024);
 
@@ -36,17 +59,19 @@ MainWindow::MainWindow(int w, int h, const char* title)
     auto search_stop_btn = new Fl_Button(580, 5, 75, 23, "Stop");
     search_stop_btn->callback(MainWindow::search_stop_cb, static_cast<void*>(this));
 
-    auto output = new Fl_Text_Display(500, 35, 195, 200);
+    auto output = new Fl_Text_Display(500, 35, 195, 145);
     output->buffer(buffer_);
 
-    auto search_engines = new Fl_Group(500, 250, 195, 200, "Search Engines");
+    full_speed_btn_ = new Fl_Check_Button(500, 182, 195, 20, "Full speed");
+
+    auto search_engines = new Fl_Group(500, 220, 195, 185, "Search Engines");
     search_engines->box(FL_SHADOW_BOX);
     search_engines->begin();
 
     for (size_t i = 0; i < engines_.size(); i++) {
         auto engine_btn = new Fl_Round_Button(
-            510, 260 + 30 * i,
-            175, 23,
+            510, 227 + 22 * i,
+            175, 22,
             std::get<0>(engines_.at(i)).c_str());
         engine_btn->type(FL_RADIO_BUTTON);
         engine_btn->callback(set_engine_cb, reinterpret_cast<void*>(i));
@@ -58,6 +83,33 @@ MainWindow::MainWindow(int w, int h, const char* title)
 
     search_engines->end();
 
+    objective_choice_ = new Fl_Choice(500, 430, 195, 23, "Function");
+    objective_choice_->align(FL_ALIGN_TOP | FL_ALIGN_LEFT);
+    objective_choice_->callback(set_objective_cb, static_cast<void*>(this));
+
+    expression_input_ = new Fl_Input(500, 472, 195, 23, "F(x,y) =");
+    expression_input_->align(FL_ALIGN_TOP | FL_ALIGN_LEFT);
+    expression_input_->when(FL_WHEN_ENTER_KEY);
+    expression_input_->callback(set_expression_cb, static_cast<void*>(this));
+    expression_input_->value(DefaultExpression);
+
+    // Expressions may have symbols that are special for menus, so all of
+    // them share one item
+    const Objective& current = Objectives::Current();
+    for (const auto& o : Objectives::All()) {
+        if (!dynamic_cast<const Expression*>(o.get())) {
+            objectives_.push_back(o.get());
+            objective_choice_->add(o->name().c_str());
+        }
+    }
+    objective_choice_->add("Expression");
+
+    auto it = std::find(objectives_.begin(), objectives_.end(), &current);
+    objective_choice_->value(static_cast<int>(it - objectives_.begin()));
+    if (it == objectives_.end()) {
+        expression_input_->value(current.name().c_str());
+    }
+
     resizable(graph_);
 
     end();
@@ -67,7 +119,8 @@ void MainWindow::refresh() {
     constexpr size_t BufferLength = 256;
     char string[BufferLength] = { 0 };
 
-    const auto& engine = std::get<1>(engines_.at(current_engine_));
+    auto engine = shown_engine();
+    graph_->engine(engine);
 
     buffer_->select(0, buffer_->length());
     buffer_->remove_selection();
@@ -77,12 +130,19 @@ void MainWindow::refresh() {
         "YMIN: %f\n"
         "ZMIN: %f\n"
         "COUNT: %d\n"
+        "CACHE HITS: %zu\n"
+        "CACHE MISSES: %zu\n"
+        "STEP P50/P99: %.0f/%.0f us\n"
         "STATUS: %s\n",
         Epsilon,
         engine->xmin(),
         engine->ymin(),
         engine->zmin(),
         engine->count(),
+        EvaluationCache::shared().hits(),
+        EvaluationCache::shared().misses(),
+        engine->stats().percentile(0.5) * 1e6,
+        engine->stats().percentile(0.99) * 1e6,
         (engine->search_over()) ? "Complete" : "Searching"
     );
     buffer_->append(string);
@@ -91,16 +151,36 @@ void MainWindow::refresh() {
 }
 
 void MainWindow::search_start() {
+    EvaluationCache::shared().reset_counters();
     std::get<1>(engines_.at(current_engine_))->search_start();
 }
 
-void MainWindow::search_step() {
-    std::get<1>(engines_.at(current_engine_))->search_step();
+void MainWindow::search_run() {
+    search_stop();
+
+    double interval = full_speed_btn_->value() ? 0.0 : TimerInterval;
+    solver_.start(*std::get<1>(engines_.at(current_engine_)),
+        [](SearchEngine& e) {
+            e.search_step();
+            return !e.search_over();
+        },
+        interval, DisplayInterval);
+
+    // The engine belongs to the worker now, the graph shows its first copy
+    solver_.update();
     refresh();
+
+    Fl::add_timeout(DisplayInterval, MainWindow::timer_cb, static_cast<void*>(this));
 }
 
-bool MainWindow::search_over() {
-    return std::get<1>(engines_.at(current_engine_))->search_over();
+void MainWindow::search_stop() {
+    Fl::remove_timeout(timer_cb);
+    solver_.stop();
+}
+
+SearchEngine* MainWindow::shown_engine() {
+    auto snapshot = solver_.running() ? solver_.snapshot() : nullptr;
+    return snapshot ? snapshot : std::get<1>(engines_.at(current_engine_)).get();
 }
 
 void MainWindow::engine(size_t idx) {
@@ -108,40 +188,92 @@ void MainWindow::engine(size_t idx) {
         std::cerr << "Error: Incorrect engine ID " << idx << std::endl;
         return;
     }
+    search_stop();
+
     current_engine_ = idx;
-    auto& e = std::get<1>(engines_.at(current_engine_));
-    e->search_start();
-    graph_->engine(e.get());
+    EvaluationCache::shared().reset_counters();
+    std::get<1>(engines_.at(current_engine_))->search_start();
     refresh();
 }
 
-void MainWindow::search_step_cb(Fl_Widget*, void* p) {
-    Fl::remove_timeout(MainWindow::timer_cb);
+void MainWindow::objective(const Objective* objective) {
+    search_stop();
 
-    auto window = static_cast<MainWindow*>(p);
-    window->search_step();
+    Objectives::SetCurrent(objective);
+    graph_->create_surface();
 
-    Fl::add_timeout(TimerInterval, MainWindow::timer_cb, p);
+    search_start();
+    refresh();
 }
 
-void MainWindow::search_stop_cb(Fl_Widget*, void*) {
-    Fl::remove_timeout(timer_cb);
+void MainWindow::search_step_cb(Fl_Widget*, void* p) {
+    auto window = static_cast<MainWindow*>(p);
+    window->search_run();
+}
+
+void MainWindow::search_stop_cb(Fl_Widget*, void* p) {
+    auto window = static_cast<MainWindow*>(p);
+    window->search_stop();
+    window->refresh();
 }
 
 void MainWindow::timer_cb(void* p) {
     auto window = static_cast<MainWindow*>(p);
-    window->search_step();
 
-    if (!window->search_over()) {
-        Fl::repeat_timeout(TimerInterval, timer_cb, p);
+    if (window->solver_.running()) {
+        Fl::repeat_timeout(DisplayInterval, timer_cb, p);
+        if (window->solver_.update()) {
+            window->refresh();
+        }
+        return;
     }
+
+    // The search is over, the worker is joined and the engine is shown
+    window->solver_.stop();
+    window->refresh();
 }
 
-void MainWindow::set_engine_cb(Fl_Widget* w, void* p) {
-    Fl::remove_timeout(timer_cb);
+void MainWindow::set_start_cb(Fl_Widget*, void* p) {
+    auto window = static_cast<MainWindow*>(p);
+    window->search_stop();
+
+    auto& engine = std::get<1>(window->engines_.at(window->current_engine_));
+    engine->set_start_point(window->graph_->xstart(), window->graph_->ystart());
+    window->refresh();
+}
 
+void MainWindow::set_engine_cb(Fl_Widget* w, void* p) {
     auto window = static_cast<MainWindow*>(w->parent()->parent());
     auto engine = static_cast<int>(reinterpret_cast<uintptr_t>(p));
 
     window->engine(engine);
 }
+
+void MainWindow::set_objective_cb(Fl_Widget*, void* p) {
+    auto window = static_cast<MainWindow*>(p);
+    auto idx = static_cast<size_t>(window->objective_choice_->value());
+
+    if (idx < window->objectives_.size()) {
+        window->objective(window->objectives_[idx]);
+    }
+    else {
+        set_expression_cb(window->expression_input_, p);
+    }
+}
+
+void MainWindow::set_expression_cb(Fl_Widget*, void* p) {
+    auto window = static_cast<MainWindow*>(p);
+
+    std::string error;
+    auto objective = Objectives::FindOrCompile(window->expression_input_->value(), error);
+    if (!objective) {
+        fl_alert("Error: %s", error.c_str());
+        return;
+    }
+
+    // Names of built-in objectives select them as well
+    auto& objectives = window->objectives_;
+    auto it = std::find(objectives.begin(), objectives.end(), objective);
+    window->objective_choice_->value(static_cast<int>(it - objectives.begin()));
+    window->objective(objective);
+}
@@ -8,18 +8,38 @@ public:
 
     void engine(size_t idx);
     void search_start();
-    void search_step();
-    bool search_over();
+
+    // Run the search on the worker thread, the window shows its progress
+    void search_run();
+    void search_stop();
+
+    // Plot the objective and restart the search on it
+    void objective(const Objective* objective);
 
     static void search_step_cb(Fl_Widget*, void*);
     static void search_stop_cb(Fl_Widget*, void*);
     static void timer_cb(void*);
+    static void set_start_cb(Fl_Widget*, void*);
     static void set_engine_cb(Fl_Widget*, void*);
+    static void set_objective_cb(Fl_Widget*, void*);
+    static void set_expression_cb(Fl_Widget*, void*);
+
+private:
+    // Latest copy of the engine while the solver runs, the engine otherwise
+    SearchEngine* shown_engine();
 
 private:
     std::vector<std::tuple<std::string, std::unique_ptr<SearchEngine>>> engines_;
     size_t current_engine_{ 0 };
 
+    BackgroundSolver<SearchEngine> solver_;
+    Fl_Check_Button* full_speed_btn_{ nullptr };
+
     GraphWidget* graph_{ nullptr };
     Fl_Text_Buffer* buffer_{ nullptr };
+
+    // Built-in objectives and the last item for the expression
+    std::vector<const Objective*> objectives_;
+    Fl_Choice* objective_choice_{ nullptr };
+    Fl_Input* expression_input_{ nullptr };
 };
@@ -0,0 +1,172 @@
+#include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
+#include "SearchStats.h"
+#include "ThreadPool.h"
+#include "MathUtils.h"
+#include "FuncUtils.h"
+#include "GraphUtils.h"
+#include "NelderMead.h"
+#include "Simplex.h"
+#include "SimplexHistory.h"
+#include "SearchEngine.h"
+#include "SimplexEngine.h"
+#include "MultiStartEngine.h"
+
+namespace MultiStartParams {
+    constexpr size_t StartCount = 256;
+
+    // Runs that do not converge in this many steps are dropped
+    constexpr int MaxSteps = 1000;
+
+    // Runs ending closer than this reach the same minimum
+    constexpr double MergeDistance = 10.0 * Epsilon;
+
+    constexpr double StartSize = 0.04;
+    constexpr double MinimumSize = 0.12;
+}
+
+const Fl_Color UnconvergedColor = fl_rgb_color(128);
+const Fl_Color MinimumColor = fl_rgb_color(0);
+
+// Colours of the basins, repeated if there are more minima
+const std::vector<Fl_Color> BasinColors = {
+    fl_rgb_color(0xd6, 0x27, 0x28),
+    fl_rgb_color(0x1f, 0x77, 0xb4),
+    fl_rgb_color(0x2c, 0xa0, 0x2c),
+    fl_rgb_color(0x94, 0x67, 0xbd),
+    fl_rgb_color(0xff, 0x7f, 0x0e),
+    fl_rgb_color(0x17, 0xbe, 0xcf),
+    fl_rgb_color(0x8c, 0x56, 0x4b),
+    fl_rgb_color(0xe3, 0x77, 0xc2),
+};
+
+// Points of the two-dimensional Sobol sequence in the unit square. The first
+// coordinate is the van der Corput sequence, the second one has direction
+// numbers of the polynomial x + 1. The corner point (0, 0) is skipped
+std::vector<HMM_Vec2> SobolPoints(size_t count) {
+    constexpr int Bits = 32;
+    std::array<uint32_t, Bits> v1, v2;
+    for (int k = 0; k < Bits; k++) {
+        v1[k] = 1u << (Bits - 1 - k);
+        v2[k] = (k == 0) ? v1[0] : (v2[k - 1] ^ (v2[k - 1] >> 1));
+    }
+
+    std::vector<HMM_Vec2> points;
+    uint32_t x = 0, y = 0;
+    for (size_t i = 0; i < count; i++) {
+        // Gray code order, flip the direction of the lowest zero bit of i
+        int c = 0;
+        while (i & (static_cast<size_t>(1) << c)) {
+            c++;
+        }
+        x ^= v1[c];
+        y ^= v2[c];
+
+        constexpr double Scale = 1.0 / 4294967296.0;
+        points.push_back(HMM_Vec2{
+            static_cast<float>(x * Scale), static_cast<float>(y * Scale) });
+    }
+    return points;
+}
+
+MultiStartEngine::MultiStartEngine() {
+    search_start();
+}
+
+void MultiStartEngine::draw(Painter& painter) const {
+    using namespace MultiStartParams;
+
+    for (const auto& s : starts_) {
+        const auto color = (s.minimum < 0) ?
+            UnconvergedColor : BasinColors[s.minimum % BasinColors.size()];
+        painter.set_color(color);
+        painter.rectangle(
+            s.x - StartSize, s.y - StartSize,
+            s.x + StartSize, s.y + StartSize);
+    }
+
+    painter.set_color(MinimumColor);
+    for (const auto& m : minima_) {
+        painter.rectangle(
+            m.x - MinimumSize, m.y - MinimumSize,
+            m.x + MinimumSize, m.y + MinimumSize);
+    }
+}
+
+void MultiStartEngine::start() {
+    starts_.clear();
+    for (const auto& p : SobolPoints(MultiStartParams::StartCount)) {
+        starts_.push_back({ XMin + p.X * (XMax - XMin), YMin + p.Y * (YMax - YMin), -1 });
+    }
+    minima_.clear();
+
+    xmin_ = xstart_;
+    ymin_ = ystart_;
+    zmin_ = evaluate(xmin_, ymin_);
+    search_over_ = false;
+}
+
+void MultiStartEngine::step() {
+    using namespace MultiStartParams;
+
+    struct Result {
+        bool converged;
+        double x, y, z;
+        size_t evaluations;
+    };
+    std::vector<Result> results(starts_.size());
+
+    // Every run writes only its own result. Runs step the method itself, an
+    // engine would keep the history and step times nobody draws
+    TaskGroup tasks;
+    for (size_t i = 0; i < starts_.size(); i++) {
+        tasks.submit([this, &results, i]() {
+            // Evaluations on the worker are not seen by search_step()
+            size_t evaluations = FuncEvaluations();
+            NelderMead method(2, [](const double* x) { return func(x[0], x[1]); });
+            method.start(StartTriangle(static_cast<float>(starts_[i].x), static_cast<float>(starts_[i].y)));
+            bool converged = false;
+            for (int step = 0; step < MaxSteps && !converged; step++) {
+                method.step();
+                converged = method.diameter() <= Epsilon;
+            }
+
+            size_t best = method.best();
+            results[i] = { converged, method.vertex(best)[0], method.vertex(best)[1], method.value(best), FuncEvaluations() - evaluations };
+        });
+    }
+    tasks.wait();
+
+    // Merge in the order of the start points, so minima do not depend on timing
+    for (size_t i = 0; i < starts_.size(); i++) {
+        const Result& r = results[i];
+        stats_.add_evaluations(r.evaluations);
+        if (!r.converged) {
+            continue;
+        }
+
+        auto it = std::find_if(minima_.begin(), minima_.end(), [&r](const Minimum& m) {
+            return hypot(m.x - r.x, m.y - r.y) < MergeDistance;
+        });
+        if (it == minima_.end()) {
+            minima_.push_back({ r.x, r.y, r.z, 0 });
+            it = minima_.end() - 1;
+        }
+        else if (r.z < it->z) {
+            it->x = r.x;
+            it->y = r.y;
+            it->z = r.z;
+        }
+        it->runs++;
+        starts_[i].minimum = static_cast<int>(it - minima_.begin());
+
+        if (r.z < zmin_) {
+            xmin_ = r.x;
+            ymin_ = r.y;
+            zmin_ = r.z;
+        }
+    }
+
+    search_over_ = true;
+}
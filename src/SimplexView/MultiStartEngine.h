@@ -0,0 +1,34 @@
+#pragma once
+
+// Nelder-Mead method started from many points of a Sobol sequence at once,
+// the runs share a thread pool. Runs that end at the same point give one
+// minimum, start points are drawn in the colour of the minimum they reach,
+// which shows the basins of the minima
+class MultiStartEngine: public SearchEngine {
+public:
+    MultiStartEngine();
+
+    void draw(Painter& painter) const override;
+
+    std::unique_ptr<SearchEngine> clone() const override { return std::make_unique<MultiStartEngine>(*this); }
+
+    struct Minimum {
+        double x, y, z;
+        size_t runs;
+    };
+
+    const std::vector<Minimum>& minima() const { return minima_; }
+
+protected:
+    void start() override;
+    void step() override;
+
+private:
+    struct Start {
+        double x, y;
+        int minimum; // Index of the minimum, -1 if the run did not converge
+    };
+
+    std::vector<Start> starts_;
+    std::vector<Minimum> minima_;
+};
@@ -0,0 +1,175 @@
+#include "pch.h"
+#include "NelderMead.h"
+
+namespace NelderMeadParams {
+    // Coefficients of reflection, expansion, contraction and shrinking
+    constexpr double Reflection = 1.0;
+    constexpr double Expansion = 2.0;
+    constexpr double Contraction = 0.5;
+    constexpr double Shrinking = 0.5;
+}
+
+NelderMead::NelderMead(size_t dimension, Function func)
+    : n_(dimension), func_(std::move(func)) {
+    vertices_.resize((n_ + 1) * n_);
+    values_.resize(n_ + 1);
+    sum_.resize(n_);
+    centroid_.resize(n_);
+    reflected_.resize(n_);
+    trial_.resize(n_);
+}
+
+void NelderMead::start(const double* x0, double step) {
+    std::vector<double> vertices((n_ + 1) * n_);
+    for (size_t i = 0; i <= n_; i++) {
+        std::copy_n(x0, n_, &vertices[i * n_]);
+        if (i > 0) {
+            vertices[i * n_ + i - 1] += step;
+        }
+    }
+    start(vertices);
+}
+
+void NelderMead::start(const std::vector<double>& vertices) {
+    std::copy_n(vertices.begin(), vertices_.size(), vertices_.begin());
+
+    evaluations_ = 0;
+    for (size_t i = 0; i <= n_; i++) {
+        values_[i] = evaluate(vertex(i));
+    }
+    update_sum();
+}
+
+size_t NelderMead::best() const {
+    return std::min_element(values_.begin(), values_.end()) - values_.begin();
+}
+
+size_t NelderMead::worst() const {
+    return std::max_element(values_.begin(), values_.end()) - values_.begin();
+}
+
+double NelderMead::diameter() const {
+    const double* b = vertex(best());
+
+    double d = 0.0;
+    for (size_t i = 0; i <= n_; i++) {
+        const double* v = vertex(i);
+        double s = 0.0;
+        for (size_t k = 0; k < n_; k++) {
+            s += (v[k] - b[k]) * (v[k] - b[k]);
+        }
+        d = std::max(d, s);
+    }
+    return sqrt(d);
+}
+
+double NelderMead::evaluate(const double* x) {
+    evaluations_++;
+    return func_(x);
+}
+
+void NelderMead::update_sum() {
+    std::fill(sum_.begin(), sum_.end(), 0.0);
+    for (size_t i = 0; i <= n_; i++) {
+        const double* v = vertex(i);
+        for (size_t k = 0; k < n_; k++) {
+            sum_[k] += v[k];
+        }
+    }
+    replaced_ = 0;
+}
+
+void NelderMead::replace(size_t i, const std::vector<double>& x, double value) {
+    double* v = &vertices_[i * n_];
+    for (size_t k = 0; k < n_; k++) {
+        sum_[k] += x[k] - v[k];
+        v[k] = x[k];
+    }
+    values_[i] = value;
+
+    // Sum the vertices anew once in a while, so rounding errors do not pile up
+    if (++replaced_ > n_) {
+        update_sum();
+    }
+}
+
+void NelderMead::along(const double* x, double t, std::vector<double>& result) const {
+    for (size_t k = 0; k < n_; k++) {
+        result[k] = centroid_[k] + t * (x[k] - centroid_[k]);
+    }
+}
+
+NelderMead::Move NelderMead::step() {
+    using namespace NelderMeadParams;
+
+    // Best, worst and second worst vertices in one pass
+    size_t l = 0, h = 0, s = 0;
+    for (size_t i = 1; i <= n_; i++) {
+        if (values_[i] < values_[l]) {
+            l = i;
+        }
+        if (values_[i] > values_[h]) {
+            s = h;
+            h = i;
+        }
+        else if (values_[i] > values_[s] || s == h) {
+            s = i;
+        }
+    }
+
+    const double* xh = vertex(h);
+    for (size_t k = 0; k < n_; k++) {
+        centroid_[k] = (sum_[k] - xh[k]) / static_cast<double>(n_);
+    }
+
+    along(xh, -Reflection, reflected_);
+    double fr = evaluate(reflected_.data());
+
+    if (fr < values_[l]) {
+        along(reflected_.data(), Expansion, trial_);
+        double fe = evaluate(trial_.data());
+        if (fe < fr) {
+            replace(h, trial_, fe);
+            return Move::Expand;
+        }
+        replace(h, reflected_, fr);
+        return Move::Reflect;
+    }
+
+    if (fr < values_[s]) {
+        replace(h, reflected_, fr);
+        return Move::Reflect;
+    }
+
+    // Contract outside towards the reflected point or inside towards the worst one
+    if (fr < values_[h]) {
+        along(reflected_.data(), Contraction, trial_);
+        double fc = evaluate(trial_.data());
+        if (fc <= fr) {
+            replace(h, trial_, fc);
+            return Move::Contract;
+        }
+    }
+    else {
+        along(xh, Contraction, trial_);
+        double fc = evaluate(trial_.data());
+        if (fc < values_[h]) {
+            replace(h, trial_, fc);
+            return Move::Contract;
+        }
+    }
+
+    const double* xl = vertex(l);
+    for (size_t i = 0; i <= n_; i++) {
+        if (i == l) {
+            continue;
+        }
+        double* v = &vertices_[i * n_];
+        for (size_t k = 0; k < n_; k++) {
+            v[k] = xl[k] + Shrinking * (v[k] - xl[k]);
+        }
+        values_[i] = evaluate(v);
+    }
+    update_sum();
+    return Move::Shrink;
+}
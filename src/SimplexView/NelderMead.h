@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+ * Nelder-Mead method for a function of any number of parameters.
+ * Vertices of the simplex are stored in one contiguous array, n parameters
+ * per vertex, together with their function values, so an iteration costs
+ * one or two evaluations unless the simplex shrinks.
+ */
+class NelderMead {
+public:
+    using Function = std::function<double(const double* x)>;
+
+    enum class Move {
+        Reflect,
+        Expand,
+        Contract,
+        Shrink
+    };
+
+    NelderMead(size_t dimension, Function func);
+
+    // Simplex of x0 and the points shifted from it by step along every axis
+    void start(const double* x0, double step);
+
+    // Simplex of n+1 vertices given one after another
+    void start(const std::vector<double>& vertices);
+
+    // Replace the worst vertex or shrink the simplex to the best one
+    Move step();
+
+    size_t dimension() const { return n_; }
+    size_t vertex_count() const { return n_ + 1; }
+
+    const double* vertex(size_t i) const { return &vertices_[i * n_]; }
+    double value(size_t i) const { return values_[i]; }
+
+    size_t best() const;
+    size_t worst() const;
+
+    // Largest distance of a vertex from the best one
+    double diameter() const;
+
+    size_t evaluations() const { return evaluations_; }
+
+private:
+    double evaluate(const double* x);
+    void replace(size_t i, const std::vector<double>& x, double value);
+    void update_sum();
+
+    // Point c + t * (x - c) for the centroid c
+    void along(const double* x, double t, std::vector<double>& result) const;
+
+private:
+    size_t n_{ 0 };
+    Function func_;
+
+    std::vector<double> vertices_;
+    std::vector<double> values_;
+
+    // Sum of the vertices, updated with each replaced vertex
+    std::vector<double> sum_;
+    size_t replaced_{ 0 };
+
+    std::vector<double> centroid_;
+    std::vector<double> reflected_, trial_;
+
+    size_t evaluations_{ 0 };
+};
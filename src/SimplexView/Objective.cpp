@@ -0,0 +1,652 @@
+#include "pch.h"
+#include "Dual.h"
+#include "Objective.h"
+
+namespace ExpressionParams {
+    // Points of a batch processed by every instruction in turn
+    constexpr size_t BatchSize = 256;
+
+    // Depth of the evaluation stack, enough for any sane expression
+    constexpr size_t MaxStack = 32;
+
+    // Integer powers up to this one are computed by multiplication
+    constexpr double MaxIntPower = 16.0;
+}
+
+Objective::Objective(const std::string& name)
+    : name_(name) {
+    static std::atomic<unsigned> lastId{ 0 };
+    id_ = ++lastId;
+}
+
+void Objective::evaluate(const double* x, const double* y, double* z, size_t n) const {
+    for (size_t k = 0; k < n; k++) {
+        z[k] = (*this)(x[k], y[k]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+double IntPower(double a, unsigned power) {
+    double result = 1.0;
+    for (; power; power >>= 1) {
+        if (power & 1) {
+            result *= a;
+        }
+        a *= a;
+    }
+    return result;
+}
+
+// Value and derivative of an integer power
+Dual IntPower(const Dual& a, unsigned power) {
+    return Chain(a, IntPower(a.value, power), power * IntPower(a.value, power - 1));
+}
+
+struct ExpressionFunction1 {
+    const char* name;
+    double (*func)(double);
+    Dual (*dual)(const Dual&);
+};
+
+struct ExpressionFunction2 {
+    const char* name;
+    double (*func)(double, double);
+    Dual (*dual)(const Dual&, const Dual&);
+};
+
+// The same function of a number and of a dual number
+#define EXPRESSION_FUNCTION1(name, f) \
+    { name, [](double a) { return f(a); }, [](const Dual& a) { return f(a); } }
+
+const ExpressionFunction1 Functions1[] = {
+    EXPRESSION_FUNCTION1("sin",   sin),
+    EXPRESSION_FUNCTION1("cos",   cos),
+    EXPRESSION_FUNCTION1("tan",   tan),
+    EXPRESSION_FUNCTION1("asin",  asin),
+    EXPRESSION_FUNCTION1("acos",  acos),
+    EXPRESSION_FUNCTION1("atan",  atan),
+    EXPRESSION_FUNCTION1("sinh",  sinh),
+    EXPRESSION_FUNCTION1("cosh",  cosh),
+    EXPRESSION_FUNCTION1("tanh",  tanh),
+    EXPRESSION_FUNCTION1("exp",   exp),
+    EXPRESSION_FUNCTION1("log",   log),
+    EXPRESSION_FUNCTION1("log10", log10),
+    EXPRESSION_FUNCTION1("sqrt",  sqrt),
+    EXPRESSION_FUNCTION1("abs",   fabs),
+    EXPRESSION_FUNCTION1("floor", floor),
+    EXPRESSION_FUNCTION1("ceil",  ceil),
+};
+
+#undef EXPRESSION_FUNCTION1
+
+const ExpressionFunction2 Functions2[] = {
+    { "min",
+        [](double a, double b) { return std::min(a, b); },
+        [](const Dual& a, const Dual& b) { return fmin(a, b); } },
+    { "max",
+        [](double a, double b) { return std::max(a, b); },
+        [](const Dual& a, const Dual& b) { return fmax(a, b); } },
+    { "atan2",
+        [](double a, double b) { return atan2(a, b); },
+        [](const Dual& a, const Dual& b) { return atan2(a, b); } },
+    { "pow",
+        [](double a, double b) { return pow(a, b); },
+        [](const Dual& a, const Dual& b) { return pow(a, b); } },
+};
+
+const std::pair<const char*, double> Constants[] = {
+    { "pi", M_PI },
+    { "e",  M_E },
+};
+
+/*
+ * Recursive descent parser that emits the postfix code of an expression:
+ *   sum     = product { ("+" | "-") product }
+ *   product = unary { ("*" | "/") unary }
+ *   unary   = ("-" | "+") unary | power
+ *   power   = primary [ "^" unary ]
+ *   primary = number | "x" | "y" | constant | "(" sum ")"
+ *           | function "(" sum [ "," sum ] ")"
+ */
+class Expression::Parser {
+public:
+    Parser(const std::string& text, Expression& expr)
+        : text_(text), expr_(expr) { }
+
+    bool parse(std::string& error) {
+        bool ok = sum();
+        skip_spaces();
+        if (ok && pos_ < text_.size()) {
+            ok = fail("Unexpected symbol");
+        }
+        if (ok && maxDepth_ > ExpressionParams::MaxStack) {
+            ok = fail("Expression is too complex");
+        }
+        if (!ok) {
+            error = error_;
+        }
+        return ok;
+    }
+
+    // Stack slots needed to run the code
+    size_t max_depth() const { return maxDepth_; }
+
+private:
+    bool sum() {
+        if (!product()) {
+            return false;
+        }
+        while (char c = peek("+-")) {
+            pos_++;
+            if (!product()) {
+                return false;
+            }
+            emit(c == '+' ? OpCode::Add : OpCode::Sub);
+        }
+        return true;
+    }
+
+    bool product() {
+        if (!unary()) {
+            return false;
+        }
+        while (char c = peek("*/")) {
+            pos_++;
+            if (!unary()) {
+                return false;
+            }
+            emit(c == '*' ? OpCode::Mul : OpCode::Div);
+        }
+        return true;
+    }
+
+    bool unary() {
+        if (char c = peek("+-")) {
+            pos_++;
+            if (!unary()) {
+                return false;
+            }
+            if (c == '-') {
+                emit(OpCode::Neg);
+            }
+            return true;
+        }
+        return power();
+    }
+
+    bool power() {
+        if (!primary()) {
+            return false;
+        }
+        if (peek("^")) {
+            pos_++;
+            // Right associative and binds tighter than the unary minus on
+            // the left: -x^2 is -(x^2), 2^-x is 2^(-x)
+            if (!unary()) {
+                return false;
+            }
+            emit(OpCode::Pow);
+        }
+        return true;
+    }
+
+    bool primary() {
+        skip_spaces();
+        if (pos_ >= text_.size()) {
+            return fail("Unexpected end of expression");
+        }
+
+        char c = text_[pos_];
+        if (c == '(') {
+            pos_++;
+            return sum() && expect(')');
+        }
+
+        if (isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char* begin = text_.c_str() + pos_;
+            char* end = nullptr;
+            double value = strtod(begin, &end);
+            if (end == begin) {
+                return fail("Incorrect number");
+            }
+            pos_ += end - begin;
+            emit_const(value);
+            return true;
+        }
+
+        if (!isalpha(static_cast<unsigned char>(c))) {
+            return fail("Unexpected symbol");
+        }
+
+        size_t start = pos_;
+        while (pos_ < text_.size() && (isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) {
+            pos_++;
+        }
+        std::string name = text_.substr(start, pos_ - start);
+
+        if (name == "x") {
+            emit(OpCode::X);
+            return true;
+        }
+        if (name == "y") {
+            emit(OpCode::Y);
+            return true;
+        }
+        for (const auto& constant : Constants) {
+            if (name == constant.first) {
+                emit_const(constant.second);
+                return true;
+            }
+        }
+
+        for (size_t f = 0; f < std::size(Functions1); f++) {
+            if (name == Functions1[f].name) {
+                if (!expect('(') || !sum() || !expect(')')) {
+                    return false;
+                }
+                emit(OpCode::Call1, static_cast<uint16_t>(f));
+                return true;
+            }
+        }
+        for (size_t f = 0; f < std::size(Functions2); f++) {
+            if (name == Functions2[f].name) {
+                if (!expect('(') || !sum() || !expect(',') || !sum() || !expect(')')) {
+                    return false;
+                }
+                emit(OpCode::Call2, static_cast<uint16_t>(f));
+                return true;
+            }
+        }
+
+        pos_ = start;
+        return fail("Unknown name '" + name + "'");
+    }
+
+    void skip_spaces() {
+        while (pos_ < text_.size() && isspace(static_cast<unsigned char>(text_[pos_]))) {
+            pos_++;
+        }
+    }
+
+    // Next symbol if it is one of the given ones
+    char peek(const char* symbols) {
+        skip_spaces();
+        if (pos_ < text_.size() && strchr(symbols, text_[pos_])) {
+            return text_[pos_];
+        }
+        return 0;
+    }
+
+    bool expect(char c) {
+        if (!peek(std::string(1, c).c_str())) {
+            return fail(std::string("Expected '") + c + "'");
+        }
+        pos_++;
+        return true;
+    }
+
+    bool fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message + " at position " + std::to_string(pos_ + 1);
+        }
+        return false;
+    }
+
+    void emit_const(double value) {
+        expr_.constants_.push_back(value);
+        emit(OpCode::Const, static_cast<uint16_t>(expr_.constants_.size() - 1));
+    }
+
+    // Append an instruction, operations on constants are computed right away
+    void emit(OpCode op, uint16_t arg = 0) {
+        auto& code = expr_.code_;
+        auto& constants = expr_.constants_;
+        size_t n = code.size();
+
+        bool lastConst = n >= 1 && code[n - 1].op == OpCode::Const;
+        bool lastTwoConst = lastConst && n >= 2 && code[n - 2].op == OpCode::Const;
+
+        switch (op) {
+        case OpCode::Const:
+        case OpCode::X:
+        case OpCode::Y:
+            code.push_back({ op, arg });
+            depth_++;
+            maxDepth_ = std::max(maxDepth_, depth_);
+            break;
+
+        case OpCode::Neg:
+        case OpCode::Call1:
+            if (lastConst) {
+                double& a = constants[code[n - 1].arg];
+                a = (op == OpCode::Neg) ? -a : Functions1[arg].func(a);
+            }
+            else {
+                code.push_back({ op, arg });
+            }
+            break;
+
+        default:
+            if (lastTwoConst) {
+                double a = constants[code[n - 2].arg];
+                double b = constants[code[n - 1].arg];
+                constants[code[n - 2].arg] = Apply(op, arg, a, b);
+                code.pop_back();
+                constants.pop_back();
+            }
+            else if (op == OpCode::Pow && lastConst && IsIntPower(constants[code[n - 1].arg])) {
+                // Squares and cubes are frequent in test functions
+                auto power = static_cast<uint16_t>(constants[code[n - 1].arg]);
+                code.pop_back();
+                constants.pop_back();
+                code.push_back({ power == 2 ? OpCode::Square : OpCode::PowInt, power });
+            }
+            else {
+                code.push_back({ op, arg });
+            }
+            depth_--;
+            break;
+        }
+    }
+
+    static bool IsIntPower(double power) {
+        return power >= 2.0 && power <= ExpressionParams::MaxIntPower && power == floor(power);
+    }
+
+    static double Apply(OpCode op, uint16_t arg, double a, double b) {
+        switch (op) {
+        case OpCode::Add: return a + b;
+        case OpCode::Sub: return a - b;
+        case OpCode::Mul: return a * b;
+        case OpCode::Div: return a / b;
+        case OpCode::Pow: return pow(a, b);
+        default:          return Functions2[arg].func(a, b);
+        }
+    }
+
+private:
+    const std::string& text_;
+    Expression& expr_;
+    size_t pos_{ 0 };
+    size_t depth_{ 0 };
+    size_t maxDepth_{ 0 };
+    std::string error_;
+};
+
+Expression::Expression(const std::string& text)
+    : Objective(text) {
+}
+
+std::unique_ptr<Expression> Expression::compile(const std::string& text, std::string& error) {
+    std::unique_ptr<Expression> expr(new Expression(text));
+
+    Parser parser(text, *expr);
+    if (!parser.parse(error)) {
+        return nullptr;
+    }
+
+    expr->stackSize_ = parser.max_depth();
+    expr->code_.shrink_to_fit();
+    expr->constants_.shrink_to_fit();
+    return expr;
+}
+
+double Expression::operator()(double x, double y) const {
+    double stack[ExpressionParams::MaxStack];
+    size_t top = 0;
+
+    for (const auto& ins : code_) {
+        switch (ins.op) {
+        case OpCode::Const:  stack[top++] = constants_[ins.arg]; break;
+        case OpCode::X:      stack[top++] = x; break;
+        case OpCode::Y:      stack[top++] = y; break;
+        case OpCode::Neg:    stack[top - 1] = -stack[top - 1]; break;
+        case OpCode::Square: stack[top - 1] *= stack[top - 1]; break;
+        case OpCode::PowInt: stack[top - 1] = IntPower(stack[top - 1], ins.arg); break;
+        case OpCode::Call1:  stack[top - 1] = Functions1[ins.arg].func(stack[top - 1]); break;
+        case OpCode::Add:    top--; stack[top - 1] += stack[top]; break;
+        case OpCode::Sub:    top--; stack[top - 1] -= stack[top]; break;
+        case OpCode::Mul:    top--; stack[top - 1] *= stack[top]; break;
+        case OpCode::Div:    top--; stack[top - 1] /= stack[top]; break;
+        case OpCode::Pow:    top--; stack[top - 1] = pow(stack[top - 1], stack[top]); break;
+        case OpCode::Call2:  top--; stack[top - 1] = Functions2[ins.arg].func(stack[top - 1], stack[top]); break;
+        }
+    }
+
+    return stack[0];
+}
+
+Dual Expression::gradient(double x, double y) const {
+    Dual stack[ExpressionParams::MaxStack];
+    size_t top = 0;
+
+    for (const auto& ins : code_) {
+        switch (ins.op) {
+        case OpCode::Const:  stack[top++] = Dual(constants_[ins.arg]); break;
+        case OpCode::X:      stack[top++] = Dual::X(x); break;
+        case OpCode::Y:      stack[top++] = Dual::Y(y); break;
+        case OpCode::Neg:    stack[top - 1] = -stack[top - 1]; break;
+        case OpCode::Square: stack[top - 1] *= stack[top - 1]; break;
+        case OpCode::PowInt: stack[top - 1] = IntPower(stack[top - 1], ins.arg); break;
+        case OpCode::Call1:  stack[top - 1] = Functions1[ins.arg].dual(stack[top - 1]); break;
+        case OpCode::Add:    top--; stack[top - 1] += stack[top]; break;
+        case OpCode::Sub:    top--; stack[top - 1] -= stack[top]; break;
+        case OpCode::Mul:    top--; stack[top - 1] *= stack[top]; break;
+        case OpCode::Div:    top--; stack[top - 1] /= stack[top]; break;
+        case OpCode::Pow:    top--; stack[top - 1] = pow(stack[top - 1], stack[top]); break;
+        case OpCode::Call2:  top--; stack[top - 1] = Functions2[ins.arg].dual(stack[top - 1], stack[top]); break;
+        }
+    }
+
+    return stack[0];
+}
+
+void Expression::evaluate(const double* x, const double* y, double* z, size_t n) const {
+    using ExpressionParams::BatchSize;
+
+    // Every slot of the stack holds a whole batch, so each instruction is
+    // a plain loop over the points
+    std::vector<double> stack(stackSize_ * BatchSize);
+
+    for (size_t first = 0; first < n; first += BatchSize) {
+        const size_t m = std::min(BatchSize, n - first);
+        const double* bx = x + first;
+        const double* by = y + first;
+        size_t top = 0;
+
+        auto slot = [&](size_t k) { return stack.data() + k * BatchSize; };
+
+        for (const auto& ins : code_) {
+            switch (ins.op) {
+            case OpCode::Const:
+                std::fill_n(slot(top++), m, constants_[ins.arg]);
+                break;
+            case OpCode::X:
+                std::copy_n(bx, m, slot(top++));
+                break;
+            case OpCode::Y:
+                std::copy_n(by, m, slot(top++));
+                break;
+
+            case OpCode::Neg: {
+                double* a = slot(top - 1);
+                for (size_t k = 0; k < m; k++) a[k] = -a[k];
+                break;
+            }
+            case OpCode::Square: {
+                double* a = slot(top - 1);
+                for (size_t k = 0; k < m; k++) a[k] *= a[k];
+                break;
+            }
+            case OpCode::PowInt: {
+                double* a = slot(top - 1);
+                for (size_t k = 0; k < m; k++) a[k] = IntPower(a[k], ins.arg);
+                break;
+            }
+            case OpCode::Call1: {
+                double* a = slot(top - 1);
+                auto func = Functions1[ins.arg].func;
+                for (size_t k = 0; k < m; k++) a[k] = func(a[k]);
+                break;
+            }
+
+            default: {
+                top--;
+                double* a = slot(top - 1);
+                const double* b = slot(top);
+                switch (ins.op) {
+                case OpCode::Add:
+                    for (size_t k = 0; k < m; k++) a[k] += b[k];
+                    break;
+                case OpCode::Sub:
+                    for (size_t k = 0; k < m; k++) a[k] -= b[k];
+                    break;
+                case OpCode::Mul:
+                    for (size_t k = 0; k < m; k++) a[k] *= b[k];
+                    break;
+                case OpCode::Div:
+                    for (size_t k = 0; k < m; k++) a[k] /= b[k];
+                    break;
+                case OpCode::Pow:
+                    for (size_t k = 0; k < m; k++) a[k] = pow(a[k], b[k]);
+                    break;
+                default: {
+                    auto func = Functions2[ins.arg].func;
+                    for (size_t k = 0; k < m; k++) a[k] = func(a[k], b[k]);
+                    break;
+                }
+                }
+                break;
+            }
+            }
+        }
+
+        std::copy_n(slot(0), m, z + first);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+// Objective compiled into the program, batches call the function inline.
+// The function is generic, so it is differentiated by calling it on dual numbers
+template<typename F>
+class NativeObjective : public Objective {
+public:
+    NativeObjective(const std::string& name, F func)
+        : Objective(name), func_(func) { }
+
+    double operator()(double x, double y) const override {
+        return func_(x, y);
+    }
+
+    Dual gradient(double x, double y) const override {
+        return func_(Dual::X(x), Dual::Y(y));
+    }
+
+    void evaluate(const double* x, const double* y, double* z, size_t n) const override {
+        for (size_t k = 0; k < n; k++) {
+            z[k] = func_(x[k], y[k]);
+        }
+    }
+
+private:
+    F func_;
+};
+
+template<typename F>
+std::unique_ptr<Objective> MakeNativeObjective(const std::string& name, F func) {
+    return std::make_unique<NativeObjective<F>>(name, func);
+}
+
+std::vector<std::unique_ptr<Objective>> CreateBuiltinObjectives() {
+    std::vector<std::unique_ptr<Objective>> objectives;
+
+    objectives.push_back(MakeNativeObjective("Himmelblau", [](auto x, auto y) {
+        constexpr double a0 = -11.0;
+        constexpr double b0 = -7.0;
+
+        auto a = x * x + y + a0;
+        auto b = x + y * y + b0;
+
+        return a * a + b * b;
+    }));
+
+    objectives.push_back(MakeNativeObjective("Rosenbrock", [](auto x, auto y) {
+        auto a = 1.0 - x;
+        auto b = y - x * x;
+        return a * a + 100.0 * b * b;
+    }));
+
+    objectives.push_back(MakeNativeObjective("Rastrigin", [](auto x, auto y) {
+        constexpr double A = 10.0;
+        return 2.0 * A + x * x - A * cos(2.0 * M_PI * x) + y * y - A * cos(2.0 * M_PI * y);
+    }));
+
+    objectives.push_back(MakeNativeObjective("Beale", [](auto x, auto y) {
+        auto a = 1.5 - x + x * y;
+        auto b = 2.25 - x + x * y * y;
+        auto c = 2.625 - x + x * y * y * y;
+        return a * a + b * b + c * c;
+    }));
+
+    objectives.push_back(MakeNativeObjective("Booth", [](auto x, auto y) {
+        auto a = x + 2.0 * y - 7.0;
+        auto b = 2.0 * x + y - 5.0;
+        return a * a + b * b;
+    }));
+
+    objectives.push_back(MakeNativeObjective("Curved valley", [](auto x, auto y) {
+        y -= 2.0;
+        return (y-x*x)*(y-x*x)/750+(1-x)*(1-x)/50*(y-1)*(y-1)/30;
+    }));
+
+    return objectives;
+}
+
+std::vector<std::unique_ptr<Objective>>& ObjectiveList() {
+    static std::vector<std::unique_ptr<Objective>> objectives = CreateBuiltinObjectives();
+    return objectives;
+}
+
+const Objective*& CurrentObjective() {
+    static const Objective* current = ObjectiveList().front().get();
+    return current;
+}
+
+const std::vector<std::unique_ptr<Objective>>& Objectives::All() {
+    return ObjectiveList();
+}
+
+const Objective* Objectives::Find(const std::string& name) {
+    for (const auto& objective : ObjectiveList()) {
+        if (objective->name() == name) {
+            return objective.get();
+        }
+    }
+    return nullptr;
+}
+
+const Objective* Objectives::FindOrCompile(const std::string& text, std::string& error) {
+    if (auto objective = Find(text)) {
+        return objective;
+    }
+
+    auto expr = Expression::compile(text, error);
+    if (!expr) {
+        return nullptr;
+    }
+
+    ObjectiveList().push_back(std::move(expr));
+    return ObjectiveList().back().get();
+}
+
+const Objective& Objectives::Current() {
+    return *CurrentObjective();
+}
+
+void Objectives::SetCurrent(const Objective* objective) {
+    if (objective) {
+        CurrentObjective() = objective;
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+struct Dual;
+
+/*
+ * Objective function F(x, y) of the search engines and the contour plot.
+ * Objectives are evaluated either at one point or in batches over arrays
+ * of points, which saves a virtual call and the interpreter dispatch on
+ * every point. Gradients are exact, computed with dual numbers.
+ */
+class Objective {
+public:
+    explicit Objective(const std::string& name);
+    virtual ~Objective() = default;
+
+    Objective(const Objective&) = delete;
+    Objective& operator=(const Objective&) = delete;
+
+    const std::string& name() const { return name_; }
+
+    // Unique for every objective, used as a key of sampled surfaces
+    unsigned id() const { return id_; }
+
+    // Expensive objectives opt in to EvaluationCache::shared(), cheap ones
+    // are evaluated directly by func() and grad(). Caching does not change
+    // the function, so it can be switched on a const objective
+    bool cached() const { return cached_; }
+    void set_cached(bool cached) const { cached_ = cached; }
+
+    virtual double operator()(double x, double y) const = 0;
+
+    // Value and gradient in one pass
+    virtual Dual gradient(double x, double y) const = 0;
+
+    // Values in n points, x, y and z are arrays of n elements
+    virtual void evaluate(const double* x, const double* y, double* z, size_t n) const;
+
+private:
+    std::string name_;
+    unsigned id_{ 0 };
+    mutable std::atomic<bool> cached_{ false };
+};
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Objective given by a text expression of x and y, e.g. "(x^2 + y - 11)^2".
+ * The text is parsed once into a compact postfix bytecode with constants
+ * folded, which a stack machine runs. Batches run every instruction over
+ * a block of points at once.
+ */
+class Expression : public Objective {
+public:
+    // Null if the text has errors, the message goes to error
+    static std::unique_ptr<Expression> compile(const std::string& text, std::string& error);
+
+    double operator()(double x, double y) const override;
+    Dual gradient(double x, double y) const override;
+    void evaluate(const double* x, const double* y, double* z, size_t n) const override;
+
+    const std::string& text() const { return name(); }
+
+private:
+    enum class OpCode : uint8_t {
+        Const, X, Y,
+        Neg, Add, Sub, Mul, Div, Pow, Square, PowInt,
+        Call1, Call2
+    };
+
+    struct Instruction {
+        OpCode op;
+        uint16_t arg; // Index of the constant or the function, or the exponent
+    };
+
+    class Parser;
+
+    explicit Expression(const std::string& text);
+
+private:
+    std::vector<Instruction> code_;
+    std::vector<double> constants_;
+    size_t stackSize_{ 0 };
+};
+
+// ----------------------------------------------------------------------------
+
+namespace Objectives {
+    // Built-in objectives and expressions added by the user, objectives stay
+    // alive until the program exits
+    const std::vector<std::unique_ptr<Objective>>& All();
+
+    // Built-in objective or one added earlier with the same name
+    const Objective* Find(const std::string& name);
+
+    // Built-in objective by name or a new expression, null on errors
+    const Objective* FindOrCompile(const std::string& text, std::string& error);
+
+    // Objective of func(), Himmelblau's function by default
+    const Objective& Current();
+    void SetCurrent(const Objective* objective);
+}
@@ -1,82 +1,46 @@
 #include "pch.h"
+#include "SearchStats.h"
 #include "MathUtils.h"
+#include "Dual.h"
 #include "FuncUtils.h"
 #include "GraphUtils.h"
+#include "LineSearch.h"
 #include "SearchEngine.h"
 #include "RelaxationEngine.h"
 
-const Fl_Color LineColor = fl_rgb_color(0);
-const Fl_Color PreviousMarkerColor = fl_rgb_color(128, 64, 0);
-const Fl_Color CurrentMarkerColor = fl_rgb_color(0, 64, 128);
+namespace RelaxationParams {
+    // Step of the first line search, later ones start with the previous step
+    constexpr double InitialStep = 1.0;
+
+    // Precision of the minimum along the line
+    constexpr double LineTolerance = 1e-2 * Epsilon;
+}
 
 RelaxationEngine::RelaxationEngine() {
     set_start_point(XMin, YMin);
 }
 
-void RelaxationEngine::draw(CoordinateFunc xFunc, CoordinateFunc yFunc) {
-    constexpr double PointSize = 0.1;
-    constexpr int LineWidth = 3;
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    float oldW{ 0.0f };
-    glGetFloatv(GL_LINE_WIDTH, &oldW);
-    glLineWidth(LineWidth);
-    SET_FL_COLOR_TO_GL(LineColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_line_style(FL_SOLID, LineWidth);
-    fl_color(LineColor);
-#endif
-
-    DrawLine(
-        xFunc(xold_), yFunc(yold_),
-        xFunc(x_), yFunc(y_));
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glLineWidth(oldW);
-    SET_FL_COLOR_TO_GL(PreviousMarkerColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(PreviousMarkerColor);
-#endif
-    DrawRectangle(
-        xFunc(xold_ - PointSize), yFunc(yold_ - PointSize),
-        xFunc(xold_ + PointSize), yFunc(yold_ + PointSize));
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(CurrentMarkerColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(CurrentMarkerColor);
-#endif
-    DrawRectangle(
-        xFunc(x_ - PointSize), yFunc(y_ - PointSize),
-        xFunc(x_ + PointSize), yFunc(y_ + PointSize));
+void RelaxationEngine::draw(Painter& painter) const {
+    DrawStep(painter, xold_, yold_, x_, y_);
 }
 
-void RelaxationEngine::search_start() {
-    xlen_ = XMax - XMin;
-    ylen_ = YMax - YMin;
-    sx_ = 2.0 * xlen_ / Epsilon - 1.0;
-    sy_ = 2.0 * ylen_ / Epsilon - 1.0;
-    ddx_ = xlen_ / sx_;
-    ddy_ = ylen_ / sy_;
+void RelaxationEngine::start() {
+    step_ = RelaxationParams::InitialStep;
     currentVar_ = 0;
 
     x_ = xold_ = xmin_ = xstart_;
     y_ = yold_ = ymin_ = ystart_;
-    zmin_ = func(xmin_, ymin_);
-    count_ = 1;
+    zmin_ = evaluate(xmin_, ymin_);
 
     search_over_ = false;
 }
 
-void RelaxationEngine::search_step() {
-    if (search_over_) {
-        return;
-    }
-
+void RelaxationEngine::step() {
+    using namespace RelaxationParams;
     // Вычисление частных производных в точке (x,y)
-    double partialX = dfdx(x_, y_);
-    double partialY = dfdy(x_, y_);
-    count_ += 4;
+    Dual z = evaluate_gradient(x_, y_);
+    double partialX = z.dx;
+    double partialY = z.dy;
 
     // Проверка условия выхода
     double partial = sqrt(partialX * partialX + partialY * partialY);
@@ -95,45 +59,33 @@ void RelaxationEngine::search_step() {
         currentVar_ = 2; // y
     }
 
-    // Установка начальных значений для сканирования
+    double dx = 0.0, dy = 0.0;
     if (currentVar_==1) {
-        dx_ = -ddx_ * signum(partialX);
-        dy_ = 0;
+        dx = -signum(partialX);
     }
     else if (currentVar_==2) {
-        dx_ = 0;
-        dy_ = -ddy_ * signum(partialY);
+        dy = -signum(partialY);
     }
 
-    double x1 = x_, xmin1 = x_;
-    double y1 = y_, ymin1 = y_;
-    double zmin1 = func(x1, y1);
-
-    // Сканирование в направлении
-    while (x1>=XMin && x1<=XMax && y1>=YMin && y1<=YMax) {
-        double z1 = func(x1, y1);
-        count_++;
-
-        if (z1<zmin1) {
-            xmin1 = x1;
-            ymin1 = y1;
-            zmin1 = z1;
-        }
-        x1 += dx_;
-        y1 += dy_;
-    }
+    // Поиск минимума вдоль координаты, значение в точке (x,y) известно
+    auto phi = [this, dx, dy](double t) { return evaluate(x_ + t * dx, y_ + t * dy); };
+    LineSearch::Result line = LineSearch::Minimize(
+        phi, z.value, step_, MaxStep(x_, y_, dx, dy), LineTolerance);
 
     // Сравнение полученного минимума в направлении с уже известным минимумом
-    if (zmin1 < zmin_) {
+    if (line.point.value < zmin_) {
         xold_ = xmin_;
         yold_ = ymin_;
-        x_ = xmin_ = xmin1;
-        y_ = ymin_ = ymin1;
-        zmin_ = zmin1;
+        x_ = xmin_ = x_ + line.point.t * dx;
+        y_ = ymin_ = y_ + line.point.t * dy;
+        zmin_ = line.point.value;
+        step_ = line.point.t;
     }
     else {
-        // Изменение параметров поиска, если шаг неудачный
-        ddx_ *= -0.5;
-        ddy_ *= -0.5;
+        // Функция не убывает вдоль координаты: минимум на границе области
+        // или найден с точностью поиска на прямой
+        xold_ = xmin_;
+        yold_ = ymin_;
+        search_over_ = true;
     }
 }
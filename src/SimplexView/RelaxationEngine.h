@@ -4,17 +4,19 @@ class RelaxationEngine: public SearchEngine {
 public:
     RelaxationEngine();
 
-    void draw(CoordinateFunc xFunc, CoordinateFunc yFunc) override;
+    void draw(Painter& painter) const override;
 
-    void search_start() override;
-    void search_step() override;
+    std::unique_ptr<SearchEngine> clone() const override { return std::make_unique<RelaxationEngine>(*this); }
+
+protected:
+    void start() override;
+    void step() override;
 
 private:
     double x_{ 0.0 }, y_{ 0.0 };
     double xold_{ 0.0 }, yold_{ 0.0 };
-    double dx_{ 0.0 }, dy_{ 0.0 };
-    double ddx_{ 0.0 }, ddy_{ 0.0 };
-    double xlen_{ 0.0 }, ylen_{ 0.0 };
-    double sx_{ 0.0 }, sy_{ 0.0 };
     int currentVar_{ 0 };
+
+    // Length of the last step along a coordinate
+    double step_{ 0.0 };
 };
@@ -1,4 +1,8 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
+#include "SearchStats.h"
+#include "ThreadPool.h"
 #include "MathUtils.h"
 #include "FuncUtils.h"
 #include "GraphUtils.h"
@@ -6,24 +10,38 @@
 #include "ScanEngine.h"
 
 const Fl_Color MarkerColor = fl_rgb_color(0, 64, 128);
+const Fl_Color FrontColor = fl_rgb_color(128, 128, 128);
+
+namespace ScanParams {
+    // Columns of the grid are scanned in this many steps, so the minimum
+    // found so far is shown while the scan goes on
+    constexpr size_t StepCount = 8;
+
+    // Columns evaluated by one task of the thread pool
+    constexpr size_t TileColumns = 16;
+
+    constexpr double PointSize = 0.1;
+}
 
 ScanEngine::ScanEngine() {
     search_start();
 }
 
-void ScanEngine::draw(CoordinateFunc xFunc, CoordinateFunc yFunc) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(MarkerColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(MarkerColor);
-#endif
-    constexpr double PointSize = 0.1;
-    DrawRectangle(
-        xFunc(xmin_ - PointSize), yFunc(ymin_ - PointSize),
-        xFunc(xmin_ + PointSize), yFunc(ymin_ + PointSize));
+void ScanEngine::draw(Painter& painter) const {
+    using namespace ScanParams;
+    if (!search_over_ && column_ > 0) {
+        double x = xs_[column_ - 1];
+        painter.set_color(FrontColor);
+        painter.line(x, YMin, x, YMax);
+    }
+
+    painter.set_color(MarkerColor);
+    painter.rectangle(
+        xmin_ - PointSize, ymin_ - PointSize,
+        xmin_ + PointSize, ymin_ + PointSize);
 }
 
-void ScanEngine::search_start() {
+void ScanEngine::start() {
     double xlen = XMax - XMin;
     double ylen = YMax - YMin;
     double sx = 2 * xlen / Epsilon - 1;
@@ -31,31 +49,71 @@ void ScanEngine::search_start() {
     dx_ = xlen / sx;
     dy_ = ylen / sy;
 
+    // Nodes of the grid, accumulated the same way as the scan always did
+    xs_.clear();
+    for (double x = XMin; x <= XMax; x += dx_) {
+        xs_.push_back(x);
+    }
+    ys_.clear();
+    for (double y = YMin; y <= YMax; y += dy_) {
+        ys_.push_back(y);
+    }
+    column_ = 0;
+
     xmin_ = XMin;
     ymin_ = YMin;
-    zmin_ = func(xmin_, ymin_);
+    zmin_ = evaluate(xmin_, ymin_);
 
-    count_ = 1;
     search_over_ = false;
 }
 
-void ScanEngine::search_step() {
-    if (search_over_) {
-        return;
-    }
+void ScanEngine::step() {
+    using namespace ScanParams;
+    size_t first = column_;
+    size_t last = std::min(first + (xs_.size() + StepCount - 1) / StepCount, xs_.size());
 
-    for (double x = XMin; x <= XMax; x += dx_) {
-        for (double y = YMin; y <= YMax; y += dy_) {
-            double z = func(x,y);
-            count_++;
-
-            if (z<zmin_) {
-                zmin_ = z;
-                xmin_ = x;
-                ymin_ = y;
+    // Tiles of columns run on the pool, each one finds its own minimum.
+    // Every column is one batch of the objective, a loop over arrays the
+    // compiler vectorises for native objectives
+    struct TileMinimum {
+        double x, y, z;
+    };
+    size_t tiles = (last - first + TileColumns - 1) / TileColumns;
+    std::vector<TileMinimum> minima(tiles,
+        TileMinimum{ 0.0, 0.0, std::numeric_limits<double>::infinity() });
+
+    TaskGroup tasks;
+    for (size_t t = 0; t < tiles; t++) {
+        tasks.submit([this, &minima, t, first, last]() {
+            size_t n = ys_.size();
+            std::vector<double> xs(n), zs(n);
+            TileMinimum& m = minima[t];
+
+            size_t end = std::min(first + (t + 1) * TileColumns, last);
+            for (size_t i = first + t * TileColumns; i < end; i++) {
+                std::fill(xs.begin(), xs.end(), xs_[i]);
+                evaluate(xs.data(), ys_.data(), zs.data(), n);
+
+                for (size_t k = 0; k < n; k++) {
+                    if (zs[k] < m.z) {
+                        m = TileMinimum{ xs_[i], ys_[k], zs[k] };
+                    }
+                }
             }
+        });
+    }
+    tasks.wait();
+
+    // Tiles are merged in the order of the scan, so ties resolve the same
+    // way as in a scan on one thread
+    for (const TileMinimum& m : minima) {
+        if (m.z < zmin_) {
+            zmin_ = m.z;
+            xmin_ = m.x;
+            ymin_ = m.y;
         }
     }
 
-    search_over_ = true;
+    column_ = last;
+    search_over_ = (column_ >= xs_.size());
 }
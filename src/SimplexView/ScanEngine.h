@@ -1,14 +1,26 @@
 #pragma once
 
+/*
+ * Brute-force scan of a grid with the step about Epsilon/2. Every step scans
+ * a band of columns split into tiles over the shared thread pool and keeps
+ * the smallest value found so far.
+ */
 class ScanEngine: public SearchEngine {
 public:
     ScanEngine();
 
-    void draw(CoordinateFunc xFunc, CoordinateFunc yFunc) override;
+    void draw(Painter& painter) const override;
 
-    void search_start() override;
-    void search_step() override;
+    std::unique_ptr<SearchEngine> clone() const override { return std::make_unique<ScanEngine>(*this); }
+
+protected:
+    void start() override;
+    void step() override;
 
 private:
     double dx_{ 0.0 }, dy_{ 0.0 };
+
+    // Nodes of the grid and the first column not scanned yet
+    std::vector<double> xs_, ys_;
+    size_t column_{ 0 };
 };
@@ -1,3 +1,44 @@
 #include "pch.h"
+#include "SearchStats.h"
+#include "MathUtils.h"
+#include "Dual.h"
+#include "FuncUtils.h"
 #include "GraphUtils.h"
+#include "Objective.h"
 #include "SearchEngine.h"
+
+void SearchEngine::search_start() {
+    stats_.reset();
+
+    size_t evaluations = FuncEvaluations();
+    start();
+    stats_.add_evaluations(FuncEvaluations() - evaluations);
+}
+
+void SearchEngine::search_step() {
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+
+    if (search_over_) {
+        return;
+    }
+
+    size_t evaluations = FuncEvaluations();
+    auto t0 = Clock::now();
+    step();
+    stats_.add_step(Seconds(Clock::now() - t0).count());
+    stats_.add_evaluations(FuncEvaluations() - evaluations);
+}
+
+double SearchEngine::evaluate(double x, double y) {
+    return func(x, y);
+}
+
+Dual SearchEngine::evaluate_gradient(double x, double y) {
+    return grad(x, y);
+}
+
+void SearchEngine::evaluate(const double* x, const double* y, double* z, size_t n) {
+    stats_.add_evaluations(n);
+    Objectives::Current().evaluate(x, y, z, n);
+}
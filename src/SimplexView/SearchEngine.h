@@ -1,13 +1,21 @@
 #pragma once
 
+struct Dual;
+class Painter;
+
 class SearchEngine {
 public:
     SearchEngine() = default;
     virtual ~SearchEngine() { };
 
-    virtual void draw(CoordinateFunc /*xFunc*/, CoordinateFunc /*yFunc*/) { }
-    virtual void search_start() { }
-    virtual void search_step() { }
+    virtual void draw(Painter& /*painter*/) const { }
+
+    // Restart the statistics and the search, steps are timed
+    void search_start();
+    void search_step();
+
+    // Copy of the state drawn while the engine runs on another thread
+    virtual std::unique_ptr<SearchEngine> clone() const = 0;
 
     void set_start_point(float xstart, float ystart) {
         xstart_ = xstart;
@@ -15,14 +23,29 @@ public:
         this->search_start();
     }
 
-    int count() const { return count_; }
+    // Evaluations of the objective and times of the steps since the start
+    const SearchStats& stats() const { return stats_; }
+    int count() const { return static_cast<int>(stats_.evaluations()); }
+
     bool search_over() const { return search_over_; }
     double xmin() const { return xmin_; }
     double ymin() const { return ymin_; }
     double zmin() const { return zmin_; }
 
 protected:
-    int count_{ 0 };
+    virtual void start() { }
+    virtual void step() { }
+
+    // The current objective. Evaluations on the thread of search_start() and
+    // search_step() are counted, values that come from the cache are not
+    double evaluate(double x, double y);
+    Dual evaluate_gradient(double x, double y);
+
+    // Batches skip the cache and are counted on any thread
+    void evaluate(const double* x, const double* y, double* z, size_t n);
+
+protected:
+    SearchStats stats_;
     bool search_over_{ true };
     double xmin_{ 0.0 }, ymin_{ 0.0 }, zmin_{ 0.0 };
     double xstart_{ 0.0 }, ystart_{ 0.0 };
@@ -1,25 +1,13 @@
 #pragma once
 
-constexpr int SimplexOrder = 3;
-
+// Simplex of the Nelder-Mead method projected on the plane of two parameters,
+// (x, y, value) of every vertex
 struct Simplex {
     Simplex() = default;
 
-    void set(float x1, float y1, float x2, float y2, float x3, float y3);
-    void setTriangle(float size, float x, float y);
-
-    void flip(int node);
-    void reduce(int node);
-
-    int getMaxNode() const;
-    int getMinNode() const;
-    float getSize() const;
-    HMM_Vec4 getMinPoint() const;
-
-    static bool compare_points(HMM_Vec4 a, HMM_Vec4 b) {
-        return a.Z < b.Z;
-    }
+    // Projection on the parameters ix and iy, the worst vertex is marked
+    static Simplex Project(const NelderMead& method, size_t ix = 0, size_t iy = 1);
 
-    std::array<HMM_Vec4, SimplexOrder> points;
+    std::vector<HMM_Vec3> points;
     int max_node{ -1 };
 };
@@ -1,8 +1,14 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
+#include "SearchStats.h"
 #include "MathUtils.h"
 #include "GraphUtils.h"
 #include "FuncUtils.h"
+#include "NelderMead.h"
 #include "Simplex.h"
+#include "SimplexHistory.h"
+#include "SimplexLog.h"
 #include "SearchEngine.h"
 #include "SimplexEngine.h"
 
@@ -11,101 +17,135 @@ const Fl_Color SimplexHistoryColor = fl_rgb_color(128);
 const Fl_Color SimplexNode = fl_rgb_color(0);
 const Fl_Color SimplexActiveNode = fl_rgb_color(0, 0, 0xff);
 
-void DrawSimplex(CoordinateFunc xFunc, CoordinateFunc yFunc,
-        const Simplex&s) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    glBegin(GL_LINE_LOOP);
-    for (const auto& p : s.points) {
-        glVertex2f(xFunc(p.X), yFunc(p.Y));
+namespace SimplexParams {
+    // Simplices of the history drawn under the current one
+    constexpr size_t HistoryCapacity = 1024;
+}
+
+// Every pair of vertices is joined, a projection of a simplex with more
+// vertices than a triangle shows all its edges
+void DrawSimplex(Painter& painter, const Simplex& s) {
+    for (size_t i = 0; i < s.points.size(); i++) {
+        for (size_t j = i + 1; j < s.points.size(); j++) {
+            const auto& p1 = s.points[i];
+            const auto& p2 = s.points[j];
+            painter.line(p1.X, p1.Y, p2.X, p2.Y);
+        }
     }
-    glVertex2f(xFunc(s.points[0].X), yFunc(s.points[0].Y));
-    glEnd();
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_begin_loop();
-    for (const auto& p : s.points) {
-        fl_vertex(xFunc(p.X), yFunc(p.Y));
+}
+
+std::vector<double> StartTriangle(double x, double y) {
+    constexpr int VertexCount = 3;
+    std::vector<double> vertices;
+    for (int i = 0; i < VertexCount; i++) {
+        double angle = i * 2 * M_PI / VertexCount;
+        vertices.push_back(x + cos(angle));
+        vertices.push_back(y + sin(angle));
     }
-    fl_end_loop();
-#endif
+    return vertices;
 }
 
-SimplexEngine::SimplexEngine() {
+SimplexEngine::SimplexEngine()
+    : method_(2, [](const double* x) { return func(x[0], x[1]); }),
+      history_(SimplexParams::HistoryCapacity) {
     set_start_point(0.f, -2.5f);
 }
 
-void SimplexEngine::draw(CoordinateFunc xFunc, CoordinateFunc yFunc) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(SimplexHistoryColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(SimplexHistoryColor);
-    fl_line_style(FL_SOLID, 1);
-#endif
-    for (const auto &s : history_) {
-        DrawSimplex(xFunc, yFunc, s);
-    }
+void SimplexEngine::draw(Painter& painter) const {
+    painter.set_line_width(1);
+
+    painter.set_color(SimplexHistoryColor);
+    history_.segments([&](const HMM_Vec2* points, size_t count) {
+        painter.lines(reinterpret_cast<const float*>(points), count);
+    });
+
+    painter.set_color(SimplexColor);
+    DrawSimplex(painter, simplex_);
+
+    for (size_t i = 0; i < simplex_.points.size(); i++) {
+        const auto nodeColor = (simplex_.max_node == static_cast<int>(i)) ? SimplexActiveNode : SimplexNode;
+        painter.set_color(nodeColor);
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(SimplexColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(SimplexColor);
-    fl_line_style(FL_SOLID, 1);
-#endif
-    DrawSimplex(xFunc, yFunc, simplex_);
-
-    for (int i=0; i<SimplexOrder; i++) {
-        const auto nodeColor = (simplex_.max_node == i) ? SimplexActiveNode : SimplexNode;
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        SET_FL_COLOR_TO_GL(nodeColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_color(nodeColor);
-#endif
         constexpr double PointSize = 0.05;
-        DrawRectangle(xFunc(simplex_.points[i].X - PointSize),
-                      yFunc(simplex_.points[i].Y - PointSize),
-                      xFunc(simplex_.points[i].X + PointSize),
-                      yFunc(simplex_.points[i].Y + PointSize));
+        painter.rectangle(simplex_.points[i].X - PointSize,
+                          simplex_.points[i].Y - PointSize,
+                          simplex_.points[i].X + PointSize,
+                          simplex_.points[i].Y + PointSize);
     }
 }
 
-void SimplexEngine::search_start() {
-    count_ = 0;
+void SimplexEngine::start() {
     search_over_ = false;
+    history_.clear();
+    if (log_) {
+        log_->clear();
+    }
+
+    if (replay_) {
+        replayStep_ = 0;
+        simplex_ = replay_->at(0);
+        push_simplex();
+        update_min();
+        search_over_ = (replay_->size() < 2);
+        return;
+    }
 
-    // float cx = 0.f, cy = -2.5f;
-    // set_simplex(simplex_, -4.5, -4.0, -3.5, -4.0, -4.0, sqrt(3.0) / 2.0 - 4.0);
-    // set_simplex(simplex_, -0.5+cx, cy, 0.5+cx, cy, cx, sqrt(3.0) / 2.0+cy);
-    // set_triangle_simplex(simplex_, 1.0, cx, cy);
-    simplex_.setTriangle(1.f, xstart_, ystart_);
+    method_.start(StartTriangle(xstart_, ystart_));
+    simplex_ = Simplex::Project(method_);
+    push_simplex();
 
     update_min();
-    count_ += 3;
-    history_.clear();
 }
 
-void SimplexEngine::search_step() {
-    if (search_over_) {
+void SimplexEngine::step() {
+    if (replay_) {
+        simplex_ = replay_->at(++replayStep_);
+        push_simplex();
+        update_min();
+        search_over_ = (replayStep_ + 1 >= replay_->size());
         return;
     }
-    history_.push_back(simplex_);
-
-    int max_node = simplex_.getMaxNode();
-    simplex_.flip(max_node);
-    count_ += 1;
-    if (simplex_.max_node==max_node) {
-        simplex_.reduce(max_node);
-        count_ += 2;
-    }
-    simplex_.max_node = max_node;
+
+    method_.step();
+    simplex_ = Simplex::Project(method_);
+    push_simplex();
 
     update_min();
-    if (simplex_.getSize() <= Epsilon) {
+    if (method_.diameter() <= Epsilon) {
         search_over_ = true;
     }
 }
 
+void SimplexEngine::record(std::shared_ptr<SimplexLog> log) {
+    log_ = std::move(log);
+    search_start();
+}
+
+void SimplexEngine::replay(std::shared_ptr<const SimplexLog> trajectory) {
+    replay_ = (trajectory && trajectory->size() > 0) ? std::move(trajectory) : nullptr;
+    search_start();
+}
+
+void SimplexEngine::push_simplex() {
+    history_.push(simplex_);
+    if (log_) {
+        log_->push(simplex_);
+    }
+}
+
 void SimplexEngine::update_min() {
-    HMM_Vec4 pt = simplex_.getMinPoint();
-    xmin_ = pt.X;
-    ymin_ = pt.Y;
-    zmin_ = pt.Z;
+    if (replay_) {
+        // Values of the vertices are saved, replays evaluate nothing
+        auto best = std::min_element(simplex_.points.begin(), simplex_.points.end(),
+            [](const HMM_Vec3& a, const HMM_Vec3& b) { return a.Z < b.Z; });
+        xmin_ = best->X;
+        ymin_ = best->Y;
+        zmin_ = best->Z;
+        return;
+    }
+
+    size_t best = method_.best();
+    xmin_ = method_.vertex(best)[0];
+    ymin_ = method_.vertex(best)[1];
+    zmin_ = method_.value(best);
 }
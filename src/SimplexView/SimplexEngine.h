@@ -1,18 +1,40 @@
 #pragma once
 
+class SimplexLog;
+
+// Regular triangle of unit size around the point, the start simplex of the
+// method with the vertices one after another
+std::vector<double> StartTriangle(double x, double y);
+
 class SimplexEngine: public SearchEngine {
 public:
     SimplexEngine();
 
-    void draw(CoordinateFunc xFunc, CoordinateFunc yFunc) override;
+    void draw(Painter& painter) const override;
+
+    std::unique_ptr<SearchEngine> clone() const override { return std::make_unique<SimplexEngine>(*this); }
 
-    void search_start() override;
-    void search_step() override;
+    // Logs every simplex of the following runs, null stops logging
+    void record(std::shared_ptr<SimplexLog> log);
+
+    // Play a saved trajectory back instead of searching, null stops it
+    void replay(std::shared_ptr<const SimplexLog> trajectory);
+
+protected:
+    void start() override;
+    void step() override;
 
 private:
+    void push_simplex();
     void update_min();
 
 private:
+    NelderMead method_;
     Simplex simplex_;
-    std::vector<Simplex> history_;
+    SimplexHistory history_;
+
+    // Shared by the copies of the engine, only the searching one appends
+    std::shared_ptr<SimplexLog> log_;
+    std::shared_ptr<const SimplexLog> replay_;
+    size_t replayStep_{ 0 };
 };
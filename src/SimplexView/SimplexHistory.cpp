@@ -0,0 +1,58 @@
+#include "pch.h"
+#include "NelderMead.h"
+#include "Simplex.h"
+#include "SimplexHistory.h"
+
+SimplexHistory::SimplexHistory(size_t capacity)
+    : capacity_(capacity) {
+}
+
+void SimplexHistory::reset(size_t vertexCount) {
+    vertexCount_ = vertexCount;
+    segmentCount_ = vertexCount * (vertexCount - 1) / 2;
+    clear();
+}
+
+void SimplexHistory::clear() {
+    segments_.clear();
+    head_ = 0;
+}
+
+void SimplexHistory::push(const Simplex& s) {
+    if (s.points.size() < 2 || capacity_ == 0) {
+        return;
+    }
+    if (s.points.size() != vertexCount_) {
+        reset(s.points.size());
+    }
+
+    // The ring grows until it is full, then the oldest simplex is replaced
+    size_t pointsPerSimplex = segmentCount_ * 2;
+    if (segments_.size() < capacity_ * pointsPerSimplex) {
+        segments_.resize(segments_.size() + pointsPerSimplex);
+    }
+
+    // Every pair of vertices is joined
+    HMM_Vec2* segment = &segments_[head_ * pointsPerSimplex];
+    for (size_t i = 0; i < vertexCount_; i++) {
+        for (size_t j = i + 1; j < vertexCount_; j++) {
+            *segment++ = HMM_Vec2{ s.points[i].X, s.points[i].Y };
+            *segment++ = HMM_Vec2{ s.points[j].X, s.points[j].Y };
+        }
+    }
+    head_ = (head_ + 1) % capacity_;
+}
+
+void SimplexHistory::segments(const std::function<void(const HMM_Vec2* points, size_t count)>& f) const {
+    if (segments_.empty()) {
+        return;
+    }
+    size_t pointsPerSimplex = segmentCount_ * 2;
+    if (segments_.size() < capacity_ * pointsPerSimplex || head_ == 0) {
+        f(&segments_[0], segments_.size());
+    }
+    else {
+        f(&segments_[head_ * pointsPerSimplex], (capacity_ - head_) * pointsPerSimplex);
+        f(&segments_[0], head_ * pointsPerSimplex);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+/*
+ * Last simplices of the Nelder-Mead method on the plane. Their edges are
+ * turned into line segments once when they are added and kept in a ring
+ * buffer of fixed capacity, so drawing and copying a long run take bounded
+ * time and the segments are drawn as they are, without going over the
+ * simplices again. The complete run is kept by SimplexLog.
+ */
+class SimplexHistory {
+public:
+    // Simplices drawn at most, zero capacity keeps no segments
+    explicit SimplexHistory(size_t capacity = 0);
+
+    void clear();
+    void push(const Simplex& s);
+
+    size_t capacity() const { return capacity_; }
+
+    // Segments of the last simplices as pairs of points in at most two
+    // contiguous ranges, the oldest first
+    void segments(const std::function<void(const HMM_Vec2* points, size_t count)>& f) const;
+
+private:
+    void reset(size_t vertexCount);
+
+private:
+    size_t capacity_{ 0 };
+    size_t vertexCount_{ 0 }, segmentCount_{ 0 };
+
+    // Ring of the segments, grown up to the capacity. Slot of the next simplex
+    std::vector<HMM_Vec2> segments_;
+    size_t head_{ 0 };
+};
@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "NelderMead.h"
+#include "Simplex.h"
+#include "SimplexLog.h"
+
+void SimplexLog::clear() {
+    points_.clear();
+    maxNodes_.clear();
+}
+
+void SimplexLog::push(const Simplex& s) {
+    if (s.points.size() < 2) {
+        return;
+    }
+    if (s.points.size() != vertexCount_) {
+        vertexCount_ = s.points.size();
+        clear();
+    }
+
+    points_.insert(points_.end(), s.points.begin(), s.points.end());
+    maxNodes_.push_back(s.max_node);
+}
+
+Simplex SimplexLog::at(size_t i) const {
+    Simplex s;
+    s.points.assign(&points_[i * vertexCount_], &points_[(i + 1) * vertexCount_]);
+    s.max_node = maxNodes_[i];
+    return s;
+}
+
+bool SimplexLog::save(const char* path) const {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        return false;
+    }
+
+    fprintf(f, "step,worst");
+    for (size_t i = 0; i < vertexCount_; i++) {
+        fprintf(f, ",x%zu,y%zu,z%zu", i, i, i);
+    }
+    fprintf(f, "\n");
+
+    for (size_t i = 0; i < size(); i++) {
+        Simplex s = at(i);
+        fprintf(f, "%zu,%d", i, s.max_node);
+        for (const auto& p : s.points) {
+            fprintf(f, ",%.9g,%.9g,%.9g", p.X, p.Y, p.Z);
+        }
+        fprintf(f, "\n");
+    }
+
+    bool written = !ferror(f);
+    fclose(f);
+    return written;
+}
+
+bool SimplexLog::load(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+
+    constexpr size_t LineLength = 4096;
+    char line[LineLength] = { 0 };
+
+    // Header first
+    bool loaded = fgets(line, LineLength, f) != nullptr;
+    clear();
+    while (loaded && fgets(line, LineLength, f)) {
+        char* p = line;
+        char* end = nullptr;
+        strtoul(p, &end, 10);
+        if (end == p || *end != ',') {
+            loaded = false;
+            break;
+        }
+
+        Simplex s;
+        p = end + 1;
+        s.max_node = static_cast<int>(strtol(p, &end, 10));
+
+        std::vector<float> values;
+        while (*end == ',') {
+            p = end + 1;
+            values.push_back(strtof(p, &end));
+            if (end == p) {
+                loaded = false;
+                break;
+            }
+        }
+        if (!loaded || values.size() % 3 != 0) {
+            loaded = false;
+            break;
+        }
+        for (size_t i = 0; i < values.size(); i += 3) {
+            s.points.push_back(HMM_Vec3{ values[i], values[i + 1], values[i + 2] });
+        }
+        push(s);
+    }
+
+    fclose(f);
+    return loaded && size() > 0;
+}
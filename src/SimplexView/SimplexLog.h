@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+ * Every simplex of a Nelder-Mead run on the plane, in the order the method
+ * went through them, so saved and replayed trajectories are complete. The
+ * log only grows and is not bounded, it is kept for exports and replays and
+ * shared by the copies of the engine rather than copied with them.
+ * Trajectories are saved to and loaded from CSV files, one simplex per line.
+ */
+class SimplexLog {
+public:
+    void clear();
+    void push(const Simplex& s);
+
+    // Simplices added since the log was cleared
+    size_t size() const { return maxNodes_.size(); }
+
+    // Simplex of the run, 0 is the first one
+    Simplex at(size_t i) const;
+
+    bool save(const char* path) const;
+    bool load(const char* path);
+
+private:
+    size_t vertexCount_{ 0 };
+
+    // Vertices and worst vertices of every simplex
+    std::vector<HMM_Vec3> points_;
+    std::vector<int> maxNodes_;
+};
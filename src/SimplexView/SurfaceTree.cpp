@@ -0,0 +1,266 @@
+#include "pch.h"
+#include "Canvas.h"
+#include "GraphUtils.h"
+#include "Objective.h"
+#include "ContourPlot.h"
+#include "SurfaceTree.h"
+
+namespace SurfaceTreeParams {
+    // Splits of the grid cells, a cell of the last level is 1/16 of a grid cell
+    constexpr int MaxDepth = 4;
+
+    // Cells crossed by a level are split at least this many times
+    constexpr int CrossingDepth = 2;
+
+    // A cell is split when the value in its center differs from the mean of
+    // the corners by this fraction of the gap between the nearest levels
+    constexpr float BendTolerance = 0.2f;
+
+    // Trees kept for reuse
+    constexpr size_t CacheSize = 4;
+}
+
+uint64_t MakeNodeKey(int i, int j) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(i)) << 32) | static_cast<uint32_t>(j);
+}
+
+// Distance between the levels around the value
+float LevelGap(const std::vector<float>& levels, float z, float zmin, float zmax) {
+    if (levels.size() < 2) {
+        return zmax - zmin;
+    }
+
+    size_t k = std::upper_bound(levels.begin(), levels.end(), z) - levels.begin();
+    k = std::min(std::max(k, static_cast<size_t>(1)), levels.size() - 1);
+    return levels[k] - levels[k - 1];
+}
+
+std::shared_ptr<const SurfaceTree> SurfaceTree::sample(
+        const std::shared_ptr<const SurfaceGrid>& grid,
+        const std::vector<float>& levels) {
+    using namespace SurfaceTreeParams;
+
+    static std::mutex cacheMutex;
+    static std::deque<std::shared_ptr<const SurfaceTree>> cache;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = std::find_if(cache.begin(), cache.end(),
+            [&](const std::shared_ptr<const SurfaceTree>& t) {
+                return t->grid_ == grid && t->levels_ == levels;
+            });
+        if (it != cache.end()) {
+            return *it;
+        }
+    }
+
+    auto tree = std::make_shared<SurfaceTree>();
+    tree->grid_ = grid;
+    tree->levels_ = levels;
+
+    const int scale = 1 << MaxDepth;
+    tree->dx_ = (grid->xmax - grid->xmin) / static_cast<float>((grid->cols - 1) * scale);
+    tree->dy_ = (grid->ymax - grid->ymin) / static_cast<float>((grid->rows - 1) * scale);
+
+    tree->nodes_.reserve(grid->points.size() * 4);
+    for (int j = 0; j < grid->rows; j++) {
+        for (int i = 0; i < grid->cols; i++) {
+            tree->nodes_[MakeNodeKey(i * scale, j * scale)] = grid->points[j * grid->cols + i];
+        }
+    }
+    tree->evaluations_ = grid->points.size();
+
+    std::vector<Square> squares;
+    for (int j = 0; j < grid->rows - 1; j++) {
+        for (int i = 0; i < grid->cols - 1; i++) {
+            squares.push_back({ i * scale, j * scale, scale, j * (grid->cols - 1) + i });
+        }
+    }
+    for (int depth = 0; !squares.empty(); depth++) {
+        tree->split(squares, depth);
+    }
+
+    // Triangulate after all splits, when the nodes of every neighbour are known
+    std::stable_sort(tree->leafCells_.begin(), tree->leafCells_.end(),
+        [](const Leaf& a, const Leaf& b) { return a.square.cell < b.square.cell; });
+
+    auto leaf = tree->leafCells_.begin();
+    for (int c = 0; c < (grid->rows - 1) * (grid->cols - 1); c++) {
+        Cell cell;
+        cell.first = tree->triangles_.size() / 3;
+
+        for (; leaf != tree->leafCells_.end() && leaf->square.cell == c; ++leaf) {
+            tree->triangulate(*leaf);
+        }
+
+        cell.count = tree->triangles_.size() / 3 - cell.first;
+        cell.zmin = std::min_element(
+            tree->triangles_.begin() + cell.first * 3, tree->triangles_.end(),
+            [](const HMM_Vec3& a, const HMM_Vec3& b) { return a.Z < b.Z; })->Z;
+        tree->cells_.push_back(cell);
+    }
+    tree->leaves_ = tree->leafCells_.size();
+
+    tree->leafCells_.clear();
+    tree->leafCells_.shrink_to_fit();
+    tree->nodes_.clear();
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.push_front(tree);
+    if (cache.size() > CacheSize) {
+        cache.pop_back();
+    }
+    return tree;
+}
+
+// Queue a node for the next batch unless its value is known
+void SurfaceTree::request(int i, int j) {
+    if (nodes_.emplace(MakeNodeKey(i, j), 0.0f).second) {
+        requests_.emplace_back(i, j);
+    }
+}
+
+void SurfaceTree::evaluate_requests() {
+    size_t n = requests_.size();
+    std::vector<double> xs(n), ys(n), zs(n);
+    for (size_t k = 0; k < n; k++) {
+        HMM_Vec2 p = position(requests_[k].first, requests_[k].second);
+        xs[k] = p.X;
+        ys[k] = p.Y;
+    }
+
+    grid_->objective->evaluate(xs.data(), ys.data(), zs.data(), n);
+
+    for (size_t k = 0; k < n; k++) {
+        nodes_[MakeNodeKey(requests_[k].first, requests_[k].second)] = static_cast<float>(zs[k]);
+    }
+    evaluations_ += n;
+    requests_.clear();
+}
+
+float SurfaceTree::value(int i, int j) const {
+    return nodes_.at(MakeNodeKey(i, j));
+}
+
+bool SurfaceTree::has_node(int i, int j) const {
+    return nodes_.find(MakeNodeKey(i, j)) != nodes_.end();
+}
+
+HMM_Vec2 SurfaceTree::position(int i, int j) const {
+    return HMM_Vec2{
+        grid_->xmin + static_cast<float>(i) * dx_,
+        grid_->ymin + static_cast<float>(j) * dy_
+    };
+}
+
+HMM_Vec2 SurfaceTree::grid_node(int i, int j) const {
+    const int scale = 1 << SurfaceTreeParams::MaxDepth;
+    return position(i * scale, j * scale);
+}
+
+HMM_Vec3 SurfaceTree::node(int i, int j) const {
+    HMM_Vec2 p = position(i, j);
+    return HMM_Vec3{ p.X, p.Y, nodes_.at(MakeNodeKey(i, j)) };
+}
+
+// Split the squares of one depth, the squares of the next depth replace them
+void SurfaceTree::split(std::vector<Square>& squares, int depth) {
+    using namespace SurfaceTreeParams;
+
+    for (const auto& q : squares) {
+        request(q.i, q.j);
+        request(q.i + q.size, q.j);
+        request(q.i + q.size, q.j + q.size);
+        request(q.i, q.j + q.size);
+        if (depth < MaxDepth) {
+            request(q.i + q.size / 2, q.j + q.size / 2);
+        }
+    }
+    evaluate_requests();
+
+    std::vector<Square> next;
+    for (const auto& q : squares) {
+        if (depth == MaxDepth) {
+            leafCells_.push_back({ q, false });
+            continue;
+        }
+
+        int i = q.i, j = q.j, size = q.size, h = size / 2;
+
+        std::array<float, 4> corners = {
+            value(i, j), value(i + size, j),
+            value(i + size, j + size), value(i, j + size)
+        };
+        float center = value(i + h, j + h);
+
+        auto range = std::minmax_element(corners.begin(), corners.end());
+        float zlo = std::min(*range.first, center);
+        float zhi = std::max(*range.second, center);
+
+        bool crossed = std::lower_bound(levels_.begin(), levels_.end(), zlo) !=
+            std::lower_bound(levels_.begin(), levels_.end(), zhi);
+
+        float mean = (corners[0] + corners[1] + corners[2] + corners[3]) / 4.0f;
+        float gap = LevelGap(levels_, center, grid_->zmin, grid_->zmax);
+        bool bent = fabs(center - mean) > BendTolerance * gap;
+
+        if (!bent && !(crossed && depth < CrossingDepth)) {
+            leafCells_.push_back({ q, true });
+            continue;
+        }
+
+        next.push_back({ i,     j,     h, q.cell });
+        next.push_back({ i + h, j,     h, q.cell });
+        next.push_back({ i + h, j + h, h, q.cell });
+        next.push_back({ i,     j + h, h, q.cell });
+    }
+
+    squares.swap(next);
+}
+
+void SurfaceTree::edge_nodes(int i0, int j0, int i1, int j1, std::vector<HMM_Vec3>& nodes) const {
+    // A node between two others exists only if the middle node does
+    if (abs(i1 - i0) + abs(j1 - j0) < 2) {
+        return;
+    }
+
+    int i = (i0 + i1) / 2, j = (j0 + j1) / 2;
+    if (!has_node(i, j)) {
+        return;
+    }
+
+    edge_nodes(i0, j0, i, j, nodes);
+    nodes.push_back(node(i, j));
+    edge_nodes(i, j, i1, j1, nodes);
+}
+
+void SurfaceTree::triangulate(const Leaf& leaf) {
+    int i = leaf.square.i, j = leaf.square.j, s = leaf.square.size;
+
+    if (!leaf.center) {
+        // Cells of the last level have no finer neighbours
+        HMM_Vec3 c1 = node(i, j), c2 = node(i + s, j);
+        HMM_Vec3 c3 = node(i + s, j + s), c4 = node(i, j + s);
+
+        triangles_.insert(triangles_.end(), { c1, c2, c3, c1, c3, c4 });
+        return;
+    }
+
+    // Fan around the center through the corners and the nodes on the edges
+    std::vector<HMM_Vec3> ring;
+    ring.push_back(node(i, j));
+    edge_nodes(i, j, i + s, j, ring);
+    ring.push_back(node(i + s, j));
+    edge_nodes(i + s, j, i + s, j + s, ring);
+    ring.push_back(node(i + s, j + s));
+    edge_nodes(i + s, j + s, i, j + s, ring);
+    ring.push_back(node(i, j + s));
+    edge_nodes(i, j + s, i, j, ring);
+
+    HMM_Vec3 center = node(i + s / 2, j + s / 2);
+    for (size_t k = 0; k < ring.size(); k++) {
+        triangles_.push_back(center);
+        triangles_.push_back(ring[k]);
+        triangles_.push_back(ring[(k + 1) % ring.size()]);
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+ * Function sampled on an adaptive quadtree grown from the cells of a uniform
+ * grid. Cells are split where the function bends between the contour levels
+ * or, down to a few levels, where a level crosses them, so flat regions keep
+ * coarse cells. The tree grows one depth at a time and the new nodes of each
+ * depth are evaluated in one batch. Leaves are triangulated with the nodes of
+ * finer neighbours on their edges, so contours have no cracks between cells
+ * of different size.
+ */
+class SurfaceTree {
+public:
+    // Levels go in ascending order. Trees are cached by the grid and the levels
+    static std::shared_ptr<const SurfaceTree> sample(
+        const std::shared_ptr<const SurfaceGrid>& grid,
+        const std::vector<float>& levels);
+
+    const std::shared_ptr<const SurfaceGrid>& grid() const { return grid_; }
+
+    // Triangles of the leaves, (x, y, value) for each vertex, grouped by the
+    // cells of the grid row by row
+    const std::vector<HMM_Vec3>& triangles() const { return triangles_; }
+
+    // Triangles of a grid cell and the lowest value on them
+    struct Cell {
+        size_t first{ 0 };
+        size_t count{ 0 };
+        float zmin{ 0.0f };
+    };
+
+    const std::vector<Cell>& cells() const { return cells_; }
+
+    // Position of a node of the grid
+    HMM_Vec2 grid_node(int i, int j) const;
+
+    size_t leaves() const { return leaves_; }
+    size_t evaluations() const { return evaluations_; }
+
+private:
+    using NodeKey = uint64_t;
+
+    // Square of the finest lattice with its corner at (i, j) inside a cell
+    // of the grid
+    struct Square {
+        int i, j;
+        int size;
+        int cell;
+    };
+
+    struct Leaf {
+        Square square;
+        bool center;
+    };
+
+    void request(int i, int j);
+    void evaluate_requests();
+    float value(int i, int j) const;
+    bool has_node(int i, int j) const;
+
+    void split(std::vector<Square>& squares, int depth);
+    void edge_nodes(int i0, int j0, int i1, int j1, std::vector<HMM_Vec3>& nodes) const;
+    void triangulate(const Leaf& leaf);
+
+    HMM_Vec2 position(int i, int j) const;
+    HMM_Vec3 node(int i, int j) const;
+
+private:
+    std::shared_ptr<const SurfaceGrid> grid_;
+    std::vector<float> levels_;
+
+    // Nodes on the lattice of the finest cells
+    std::unordered_map<NodeKey, float> nodes_;
+    std::vector<std::pair<int, int>> requests_;
+    float dx_{ 0.0f }, dy_{ 0.0f };
+
+    std::vector<Leaf> leafCells_;
+    std::vector<HMM_Vec3> triangles_;
+    std::vector<Cell> cells_;
+
+    size_t leaves_{ 0 };
+    size_t evaluations_{ 0 };
+};
@@ -4,20 +4,154 @@
  */
 
 #include "pch.h"
+#include "SnapshotSlot.h"
+#include "BackgroundSolver.h"
+#include "Canvas.h"
+#include "Headless.h"
+#include "SearchStats.h"
 #include "MathUtils.h"
+#include "Objective.h"
 #include "GraphUtils.h"
+#include "NelderMead.h"
 #include "Simplex.h"
+#include "SimplexHistory.h"
+#include "SimplexLog.h"
 #include "SearchEngine.h"
 #include "SimplexEngine.h"
 #include "GaussSEngine.h"
 #include "DescentEngine.h"
 #include "RelaxationEngine.h"
+#include "BfgsEngine.h"
+#include "LineSearch.h"
+#include "Lbfgs.h"
+#include "LbfgsEngine.h"
 #include "ScanEngine.h"
+#include "MultiStartEngine.h"
 #include "ContourPlot.h"
 #include "GraphWidget.h"
+#include "Benchmark.h"
 #include "MainWindow.h"
 
 int main(int argc, char* argv[]) {
+    // Built-in objective by name or an expression of x and y
+    if (argc > 2 && strcmp(argv[1], "--function") == 0) {
+        std::string error;
+        auto objective = Objectives::FindOrCompile(argv[2], error);
+        if (!objective) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        Objectives::SetCurrent(objective);
+
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
+    // Evaluations go through the cache, of every objective in the benchmark
+    bool cached = false;
+    if (argc > 1 && strcmp(argv[1], "--cache") == 0) {
+        cached = true;
+        Objectives::Current().set_cached(true);
+
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        return RunBenchmark(argc > 2 && strcmp(argv[2], "--json") == 0, cached);
+    }
+
+    // Trajectory of the Nelder-Mead method from its default start point
+    if (argc > 2 && strcmp(argv[1], "--trajectory") == 0) {
+        constexpr int MaxSteps = 10000;
+        auto log = std::make_shared<SimplexLog>();
+        SimplexEngine engine;
+        engine.record(log);
+        for (int step = 0; step < MaxSteps && !engine.search_over(); step++) {
+            engine.search_step();
+        }
+        if (!log->save(argv[2])) {
+            std::cerr << "Error: Unable to write " << argv[2] << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Saved trajectory is rendered instead of the methods
+    std::unique_ptr<SimplexLog> trajectory;
+    if (argc > 3 && strcmp(argv[1], "--replay") == 0) {
+        // The engine draws the replayed simplices, the trajectory only keeps them
+        trajectory = std::make_unique<SimplexLog>();
+        if (!trajectory->load(argv[2])) {
+            std::cerr << "Error: Unable to read " << argv[2] << std::endl;
+            return 1;
+        }
+
+        argv[2] = argv[1];
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
+    if (argc > 2 && (strcmp(argv[1], "--render") == 0 || strcmp(argv[1], "--replay") == 0)) {
+        constexpr int RenderWidth = 490;
+        constexpr int RenderHeight = 490;
+        // Limit of frames per method, scanning takes thousands of steps
+        constexpr int MethodFrames = 200;
+        int width = (argc > 4) ? atoi(argv[3]) : RenderWidth;
+        int height = (argc > 4) ? atoi(argv[4]) : RenderHeight;
+
+        // Replays show the whole trajectory
+        int methodFrames = trajectory ? static_cast<int>(trajectory->size()) : MethodFrames;
+
+        std::vector<std::unique_ptr<SearchEngine>> engines;
+        if (trajectory) {
+            auto engine = std::make_unique<SimplexEngine>();
+            engine->replay(std::move(trajectory));
+            engines.push_back(std::move(engine));
+        }
+        else {
+            engines.push_back(std::make_unique<SimplexEngine>());
+            engines.push_back(std::make_unique<GaussSEngine>());
+            engines.push_back(std::make_unique<DescentEngine>());
+            engines.push_back(std::make_unique<RelaxationEngine>());
+            engines.push_back(std::make_unique<BfgsEngine>());
+            engines.push_back(std::make_unique<LbfgsEngine>());
+            engines.push_back(std::make_unique<ScanEngine>());
+            engines.push_back(std::make_unique<MultiStartEngine>());
+        }
+
+        // Every method in turn from its start point, no display is opened
+        GraphWidget widget(0, 0, width, height, nullptr);
+        size_t current = 0;
+        int step = 0;
+
+        return RenderFrames(argv[2], width, height, [&](int /*frame*/, Canvas& canvas) {
+            while (current < engines.size() &&
+                (step >= methodFrames || (step > 0 && engines[current]->search_over()))) {
+                current++;
+                step = 0;
+            }
+            if (current >= engines.size()) {
+                return false;
+            }
+
+            auto& engine = engines[current];
+            if (step == 0) {
+                engine->search_start();
+                widget.engine(engine.get());
+            }
+            else {
+                engine->search_step();
+            }
+            widget.render(canvas);
+            step++;
+            return true;
+        });
+    }
+
 #if !defined(DRAW_OPENGL) && !defined(WIN32) && !defined(__APPLE__)
     fl_open_display();
 #endif
@@ -1,4 +1,6 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "Painter.h"
 #include "SurfaceFunction.h"
 #include "WaveModel.h"
 #include "WaveWidget.h"
@@ -10,14 +12,6 @@ const Fl_Color ModelLinesColor = fl_rgb_color(0);
 const Fl_Color ModelPointsColor = fl_rgb_color(0); // (128, 192, 255);
 const Fl_Color LegendTextColor = fl_rgb_color(0);
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-#define SET_FL_COLOR_TO_GL(c) { \
-    GLubyte r, g, b, a; \
-    Fl::get_color((c), r, g, b, a); \
-    glColor4ub(r, g, b, a); \
-    }
-#endif
-
 struct Gradient {
     Fl_Color colorMin;
     Fl_Color colorMax;
@@ -68,23 +62,17 @@ void WaveWidget::resize(int x, int y, int w, int h) {
     update_size();
 }
 
-void WaveWidget::screenshot(const std::string& fileName) const {
-    constexpr int ScreenCaptureBpp = 3;
-    int width(w()), height(h());
-    std::vector<uint8_t> pixels(width * height * ScreenCaptureBpp);
+void WaveWidget::render(Canvas& canvas) const {
+    using namespace PlotDefaults;
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    constexpr GLenum ScreenCaptureFormat = GL_RGB;
-    glReadPixels(0, 0, width, height, ScreenCaptureFormat, GL_UNSIGNED_BYTE, pixels.data());
-    stbi_flip_vertically_on_write(1);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_begin_offscreen(offscreen_);
-    fl_read_image(static_cast<uchar*>(pixels.data()), 0, 0, width, height);
-    fl_end_offscreen();
-#endif
+    double px = (XMax - XMin) / (canvas.width() - Margin * 2 - TickSize);
+    double py = (YMax - YMin) / (canvas.height() - Margin * 2 - TickSize);
 
-    int stride = width * ScreenCaptureBpp;
-    stbi_write_png(fileName.c_str(), width, height, ScreenCaptureBpp, pixels.data(), stride);
+    canvas.clear({ 255, 255, 255, 255 });
+
+    CanvasPainter painter(canvas, PlotToPixelX(XMin, px, Margin + TickSize),
+        PlotToPixelY(YMax, py, Margin));
+    paint(painter, px, py);
 }
 
 void WaveWidget::draw() {
@@ -123,21 +111,22 @@ void WaveWidget::draw() {
 #endif
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
+    // Plot coordinates are set by the projection
+    ScreenPainter painter([](double x) { return x; }, [](double y) { return y; });
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
 #elif DRAW_METHOD==DRAW_METHOD_FLTK
+    ScreenPainter painter(PlotToPixelX(XMin, pixelX_, Margin + TickSize),
+        PlotToPixelY(YMax, pixelY_, Margin));
+
     fl_begin_offscreen(offscreen_);
 
     fl_color(fl_rgb_color(255));
     fl_rectf(0, 0, this->w(), this->h());
 #endif
 
-    draw_heatmap();
-    draw_box();
-    draw_axes();
-    draw_model();
-    draw_ticks();
-    draw_legend();
+    paint(painter, pixelX_, pixelY_);
 
 #if DRAW_METHOD==DRAW_METHOD_FLTK
     fl_end_offscreen();
@@ -147,7 +136,16 @@ void WaveWidget::draw() {
 #endif
 }
 
-void WaveWidget::draw_heatmap() {
+void WaveWidget::paint(Painter& painter, double pixelX, double pixelY) const {
+    draw_heatmap(painter);
+    draw_box(painter);
+    draw_axes(painter);
+    draw_model(painter);
+    draw_ticks(painter, pixelX, pixelY);
+    draw_legend(painter, pixelX, pixelY);
+}
+
+void WaveWidget::draw_heatmap(Painter& painter) const {
     using namespace PlotDefaults;
 
     if (!model_) {
@@ -159,98 +157,44 @@ void WaveWidget::draw_heatmap() {
 
     auto heatmapColors = HeatmapGradient.GetGradient(model_->zn);
 
+    // Band between two layers as a strip of triangles
+    std::vector<float> strip(model_->xn * 4);
     for (int j = 0; j < model_->zn - 1; j++) {
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        glBegin(GL_TRIANGLE_STRIP);
-#endif
-
-        auto layerColor = heatmapColors[j];
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        SET_FL_COLOR_TO_GL(layerColor);
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_color(layerColor);
-#endif
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
         for (int i = 0; i < model_->xn; i++) {
             const auto& p0 = model_->points[i * model_->zn + j];
             const auto& p1 = model_->points[i * model_->zn + j + 1];
-            glVertex3f(p1.x * scalex + XMin,
-                ((model_->h + p1.z) * scalez) + YMin, 0.0);
-            glVertex3f(p0.x * scalex + XMin,
-                ((model_->h + p0.z) * scalez) + YMin, 0.0);
-        }
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-        fl_begin_complex_polygon();
-        for (int i = 0; i < model_->xn; i++) {
-            const auto& p0 = model_->points[i * model_->zn + j];
-            fl_vertex(get_x(p0.x * scalex + XMin), get_y((model_->h + p0.z) * scalez + YMin));
-        }
-        for (int i = model_->xn-1; i >= 0; i--) {
-            const auto& p0 = model_->points[i * model_->zn + j + 1];
-            fl_vertex(get_x(p0.x * scalex + XMin), get_y((model_->h + p0.z) * scalez + YMin));
+            strip[i * 4] = p1.x * scalex + XMin;
+            strip[i * 4 + 1] = (model_->h + p1.z) * scalez + YMin;
+            strip[i * 4 + 2] = p0.x * scalex + XMin;
+            strip[i * 4 + 3] = (model_->h + p0.z) * scalez + YMin;
         }
-        fl_end_complex_polygon();
-#endif
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-        glEnd();
-#endif
+        painter.set_color(heatmapColors[j]);
+        painter.triangle_strip(strip.data(), model_->xn * 2);
     }
 }
 
-void WaveWidget::draw_box() {
+void WaveWidget::draw_box(Painter& painter) const {
     using namespace PlotDefaults;
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(BoxColor);
-
-    glLineWidth(2);
-    glBegin(GL_LINE_STRIP);
-    glVertex3f(XMax, YMax, 0.0);
-    glVertex3f(XMax, YMin, 0.0);
-    glVertex3f(XMin, YMin, 0.0);
-    glVertex3f(XMin, YMax, 0.0);
-    glEnd();
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(BoxColor);
-
-    fl_line_style(FL_SOLID, 2);
-    fl_line(
-        get_x(XMax), get_y(YMax),
-        get_x(XMax), get_y(YMin));
-    fl_line(
-        get_x(XMax), get_y(YMin),
-        get_x(XMin), get_y(YMin));
-    fl_line(
-        get_x(XMin), get_y(YMin),
-        get_x(XMin), get_y(YMax));
-#endif
+    painter.set_color(BoxColor);
+    painter.set_line_width(2);
+
+    painter.line(XMax, YMax, XMax, YMin);
+    painter.line(XMax, YMin, XMin, YMin);
+    painter.line(XMin, YMin, XMin, YMax);
 }
 
-void WaveWidget::draw_axes() {
+void WaveWidget::draw_axes(Painter& painter) const {
     using namespace PlotDefaults;
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(AxesColor);
-
-    glLineWidth(1);
-    glBegin(GL_LINES);
-    glVertex3f(XMin, 0.0, 0.0);
-    glVertex3f(XMax, 0.0, 0.0);
-    glEnd();
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(AxesColor);
+    painter.set_color(AxesColor);
+    painter.set_line_width(1);
 
-    fl_line_style(FL_SOLID, 1);
-    fl_line(
-        get_x(XMin), get_y(0.0),
-        get_x(XMax), get_y(0.0)
-    );
-#endif
+    painter.line(XMin, 0.0, XMax, 0.0);
 }
 
-void WaveWidget::draw_model() {
+void WaveWidget::draw_model(Painter& painter) const {
     using namespace PlotDefaults;
 
     if (!model_) {
@@ -261,272 +205,105 @@ void WaveWidget::draw_model() {
     double scalez = (/*YMax*/ -YMin) / model_->h;
 
     // Lines
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(ModelLinesColor);
-    glLineWidth(1.0);
-    for (int j = 0; j < model_->zn; j++) {
-        glBegin(GL_LINE_STRIP);
-        for (int i = 0; i < model_->xn - 1; i++) {
-            const auto& p0 = model_->points[i * model_->zn + j];
-            const auto& p1 = model_->points[(i + 1) * model_->zn + j];
-
-            glVertex3f(p0.x * scalex + XMin,
-                ((model_->h + p0.z) * scalez) + YMin, 0.0);
-            glVertex3f(p1.x * scalex + XMin,
-                ((model_->h + p1.z) * scalez) + YMin, 0.0);
-        }
-        glEnd();
-    }
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(ModelLinesColor);
-    fl_line_style(FL_SOLID, 1);
+    painter.set_color(ModelLinesColor);
+    painter.set_line_width(1);
 
+    std::vector<float> line(model_->xn * 2);
     for (int j = 0; j < model_->zn; j++) {
-        fl_begin_line();
         for (int i = 0; i < model_->xn; i++) {
-            const auto& p0 = model_->points[i * model_->zn + j];
-
-            fl_vertex(get_x(p0.x * scalex + XMin), get_y((model_->h + p0.z) * scalez + YMin));
-        }
-        fl_end_line();
-    }
-#endif
-
-    // Points
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(ModelPointsColor);
-    glPointSize(3.0);
-
-    glBegin(GL_POINTS);
-    for (int i = 0; i < model_->xn; i++) {
-        for (int j = 0; j < model_->zn; j++) {
             const auto& p = model_->points[i * model_->zn + j];
-            glVertex3f(p.x * scalex + XMin,
-                ((model_->h + p.z) * scalez) + YMin, 0.0);
+            line[i * 2] = p.x * scalex + XMin;
+            line[i * 2 + 1] = (model_->h + p.z) * scalez + YMin;
         }
+        painter.polyline(line.data(), model_->xn, false);
     }
-    glEnd();
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(ModelPointsColor);
 
-    for (int i = 0; i < model_->xn; i++) {
-        for (int j = 0; j < model_->zn; j++) {
-            const auto& p = model_->points[i * model_->zn + j];
-            auto x = get_x(p.x * scalex + XMin);
-            auto y = get_y((model_->h + p.z) * scalez + YMin);
+    // Points
+    constexpr int PointSize = 4;
 
-            constexpr double PointSize = 4.0;
-            fl_rectf(x - PointSize / 2, y - PointSize / 2, PointSize, PointSize);
-        }
+    painter.set_color(ModelPointsColor);
+    for (const auto& p : model_->points) {
+        painter.point(p.x * scalex + XMin, (model_->h + p.z) * scalez + YMin, PointSize);
     }
-#endif
 }
 
-void WaveWidget::draw_ticks() {
+void WaveWidget::draw_ticks(Painter& painter, double pixelX, double pixelY) const {
     using namespace PlotDefaults;
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    SET_FL_COLOR_TO_GL(TicksColor);
-
-    glBegin(GL_LINES);
-    for (int i = 0; i <= TickCountX; i++) {
-        glVertex2d(ticksX[i * 2].x, ticksX[i * 2].y);
-        glVertex2d(ticksX[i * 2 + 1].x, ticksX[i * 2 + 1].y);
-    }
-
-    for (int i = 0; i <= TickCountY; i++) {
-        glVertex2d(ticksY[i * 2].x, ticksY[i * 2].y);
-        glVertex2d(ticksY[i * 2 + 1].x, ticksY[i * 2 + 1].y);
-    }
-    glEnd();
-
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_color(TicksColor);
-    fl_line_style(FL_SOLID, 1);
+    painter.set_color(TicksColor);
+    painter.set_line_width(1);
 
     for (int i = 0; i <= TickCountX; i++) {
-        fl_line(
-            get_x(ticksX[i * 2].x), get_y(ticksX[i * 2].y),
-            get_x(ticksX[i * 2 + 1].x), get_y(ticksX[i * 2 + 1].y)
-        );
+        double x = XMin + i * (XMax - XMin) / TickCountX;
+        double tickScale = (i % 2) ? 0.5 : 1.0;
+        painter.line(x, YMin, x, YMin - TickSize * pixelY * tickScale);
     }
 
     for (int i = 0; i <= TickCountY; i++) {
-        fl_line(
-            get_x(ticksY[i * 2].x), get_y(ticksY[i * 2].y),
-            get_x(ticksY[i * 2 + 1].x), get_y(ticksY[i * 2 + 1].y)
-        );
+        double y = YMin + i * (YMax - YMin) / TickCountY;
+        double tickScale = (i % 2) ? 0.5 : 1.0;
+        painter.line(XMin, y, XMin - TickSize * pixelX * tickScale, y);
     }
-#endif
 }
 
-void WaveWidget::draw_legend() {
+void WaveWidget::draw_legend(Painter& painter, double pixelX, double pixelY) const {
     using namespace PlotDefaults;
 
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    auto headerFont = GLUT_BITMAP_HELVETICA_18;
-    auto textFont = GLUT_BITMAP_HELVETICA_12;
-#else
-    auto headerFont = reinterpret_cast<void*>(18);
-    auto textFont = reinterpret_cast<void*>(14);
-
-    fl_color(LegendTextColor);
-#endif
+    painter.set_color(LegendTextColor);
 
     // Draw widget label
-    draw_text(headerFont, 0.0, YMax,
+    painter.set_text_size(HeaderTextSize);
+    painter.text(0.0, YMax,
         TextAlign::Center | TextAlign::Top,
-        "%s", this->label());
+        "%s", this->label() ? this->label() : "");
+
+    if (!model_) {
+        return;
+    }
 
     // Draw model time
-    draw_text(headerFont, 0.0, YMin - TickSize * pixelY_,
+    painter.text(0.0, YMin - TickSize * pixelY,
         TextAlign::Center | TextAlign::Bottom,
         "time : %.4f", model_->time);
 
     // Axes labels
+    painter.set_text_size(TextSize);
+
     // X-Axis labels
-    draw_text(textFont, XMin, YMin - TickSize * pixelY_,
+    painter.text(XMin, YMin - TickSize * pixelY,
         TextAlign::Center | TextAlign::Bottom,
         "%.2f", 0.0);
 
-    draw_text(textFont, XMax, YMin - TickSize * pixelY_,
+    painter.text(XMax, YMin - TickSize * pixelY,
         TextAlign::Center | TextAlign::Bottom,
         "%.2f", model_->delta);
 
     // Y-Axis labels
-    draw_text(textFont, XMin - TickSize * pixelX_, YMax,
+    painter.text(XMin - TickSize * pixelX, YMax,
         TextAlign::Left | TextAlign::Top,
-        "%.2f", model_->h * YMax / abs(YMin));
+        "%.2f", model_->h * YMax / std::abs(YMin));
 
     // Water level
-    draw_text(textFont, XMin - TickSize * pixelX_, 0.0,
+    painter.text(XMin - TickSize * pixelX, 0.0,
         TextAlign::Left | TextAlign::Top,
         "%.2f", 0.0);
 
-    draw_text(textFont, XMin - TickSize * pixelX_, YMin,
+    painter.text(XMin - TickSize * pixelX, YMin,
         TextAlign::Left | TextAlign::Top,
         "%.2f", -model_->h);
 }
 
-void WaveWidget::draw_text(void* font, double x, double y, uint8_t align, const char* fmt, ...) {
-    const size_t BufferLen = 256;
-    char text[BufferLen] = { 0 };
-    va_list ap;
-
-    if (!fmt) {
-        return;
-    }
-
-    va_start(ap, fmt);
-    vsnprintf(text, BufferLen - 1, fmt, ap);
-    va_end(ap);
-
-#if DRAW_METHOD==DRAW_METHOD_OPENGL
-    int h = glutBitmapHeight(font);
-
-    int w = 0;
-    char* p = (char*)text;
-    while (*p != '\0') {
-        w += glutBitmapWidth((void*)(font), *p);
-        p++;
-    }
-
-    float tx = x;
-    float ty = y;
-    float tw = w * pixelX_;
-    float th = h * pixelY_;
-
-    if (align == TextAlign::Unspecified) {
-        align = TextAlign::Default;
-    }
-
-    if (align & TextAlign::Left) {
-        tx -= tw;
-    }
-    else if (align & TextAlign::Center) {
-        tx -= tw / 2;
-    }
-
-    if (align & TextAlign::Bottom) {
-        ty -= th;
-    }
-    else if (align & TextAlign::Middle) {
-        ty -= th / 2;
-    }
-
-    glRasterPos2d(tx, ty);
-    glutBitmapString(font, (const unsigned char*)text);
-
-#elif DRAW_METHOD==DRAW_METHOD_FLTK
-    fl_font(FL_HELVETICA, static_cast<int>(reinterpret_cast<uintptr_t>(font)));
-
-    int w{ 0 }, h{ 0 };
-    fl_measure(text, w, h);
-
-    double x0{ get_x(x) }, y0{ get_y(y) };
-
-    if (align & TextAlign::Left) {
-        x0 -= w;
-    }
-    else if (align & TextAlign::Center) {
-        x0 -= w / 2;
-    }
-
-    if (align & TextAlign::Bottom) {
-        y0 += h;
-    }
-    else if (align & TextAlign::Middle) {
-        y0 += h / 2;
-    }
-
-    fl_draw(text, x0, y0);
-#endif
-}
-
-double WaveWidget::get_x(double x) const {
-    return (x - PlotDefaults::XMin) / pixelX_ + PlotDefaults::Margin + PlotDefaults::TickSize;
-}
-
-double WaveWidget::get_y(double y) const {
-    return (PlotDefaults::YMax - y) / pixelY_ + PlotDefaults::Margin;
-}
-
 void WaveWidget::update_size() {
     using namespace PlotDefaults;
 
     pixelX_ = (XMax - XMin) / (this->w() - Margin * 2 - TickSize);
     pixelY_ = (YMax - YMin) / (this->h() - Margin * 2 - TickSize);
 
-    // Y Ticks
-    ticksY.resize((TickCountY + 1) * 2);
-    double dTick = (YMax - YMin) / TickCountY;
-    for (int i = 0; i <= TickCountY; i++) {
-        double y = YMin + i * dTick;
-        ticksY[i * 2].x = XMin;
-        ticksY[i * 2].y = y;
-
-        double tickScale = (i % 2) ? 0.5 : 1.0;
-        ticksY[i * 2 + 1].x = XMin - TickSize * pixelX_ * tickScale;
-        ticksY[i * 2 + 1].y = y;
-    }
-
-    // X Ticks
-    ticksX.resize((TickCountX + 1) * 2);
-    dTick = (XMax - XMin) / TickCountX;
-    for (int i = 0; i <= TickCountX; i++) {
-        double x = XMin + i * dTick;
-        ticksX[i * 2].y = YMin;
-        ticksX[i * 2].x = x;
-
-        double tickScale = (i % 2) ? 0.5 : 1.0;
-        ticksX[i * 2 + 1].y = YMin - TickSize * pixelY_ * tickScale;
-        ticksX[i * 2 + 1].x = x;
-    }
-
 #if DRAW_METHOD==DRAW_METHOD_FLTK
+    // Plot is drawn into a buffer of the new size
     if (initOffscreen_) {
         fl_delete_offscreen(offscreen_);
-        offscreen_ = fl_create_offscreen(this->w(), this->h());
+        initOffscreen_ = false;
     }
 #endif
 }
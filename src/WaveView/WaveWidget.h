@@ -6,6 +6,9 @@
 #define DRAW_METHOD DRAW_METHOD_FLTK
 #endif
 
+class Canvas;
+class Painter;
+
 namespace PlotDefaults {
     static const double XMin = -1.0;
     static const double XMax = 1.0;
@@ -16,20 +19,9 @@ namespace PlotDefaults {
     static const int TickCountY = 18;
     static const int TickSize = 15;
     static const int Margin = 40;
-}
-
-namespace TextAlign {
-    const uint8_t Unspecified = 0x00;
-
-    const uint8_t Top = 0x01;
-    const uint8_t Middle = 0x02;
-    const uint8_t Bottom = 0x04;
 
-    const uint8_t Left = 0x10;
-    const uint8_t Center = 0x20;
-    const uint8_t Right = 0x40;
-
-    const uint8_t Default = TextAlign::Right | TextAlign::Top;
+    static const int HeaderTextSize = 18;
+    static const int TextSize = 14;
 }
 
 #if DRAW_METHOD==DRAW_METHOD_OPENGL
@@ -38,32 +30,27 @@ class WaveWidget : public Fl_Gl_Window {
 class WaveWidget : public Fl_Widget {
 #endif
 public:
-    struct Point2d {
-        float x, y;
-    };
-
     WaveWidget(int X, int Y, int W, int H, WaveModel* model = nullptr, const char* l = nullptr);
     ~WaveWidget();
 
     void resize(int x, int y, int w, int h) FL_OVERRIDE;
 
-    void screenshot(const std::string& fileName) const;
+    // Rasterise the plot on the CPU, the widget does not need to be shown
+    void render(Canvas& canvas) const;
 
     void draw() FL_OVERRIDE;
 
 private:
-    void draw_heatmap();
-    void draw_box();
-    void draw_axes();
-    void draw_model();
-    void draw_ticks();
-    void draw_legend();
+    // Plot shared by the screen and rendered images, pixel sizes are in plot units
+    void paint(Painter& painter, double pixelX, double pixelY) const;
 
-    void draw_text(void* font, double x, double y, uint8_t align, const char* fmt, ...);
+    void draw_heatmap(Painter& painter) const;
+    void draw_box(Painter& painter) const;
+    void draw_axes(Painter& painter) const;
+    void draw_model(Painter& painter) const;
+    void draw_ticks(Painter& painter, double pixelX, double pixelY) const;
+    void draw_legend(Painter& painter, double pixelX, double pixelY) const;
 
-    double get_x(double x) const;
-    double get_y(double y) const;
-    
     void update_size();
 
 private:
@@ -71,9 +58,6 @@ private:
 
     double pixelX_{ 0.0 }, pixelY_{ 0.0 };
 
-    std::vector<Point2d> ticksX;
-    std::vector<Point2d> ticksY;
-
 #if DRAW_METHOD==DRAW_METHOD_FLTK
     bool initOffscreen_{ false };
     Fl_Offscreen offscreen_;
@@ -1,4 +1,6 @@
 #include "pch.h"
+#include "Canvas.h"
+#include "ImageWriter.h"
 #include "SurfaceFunction.h"
 #include "WaveModel.h"
 #include "WaveWidget.h"
@@ -100,7 +102,10 @@ void WaveWindow::get_inputs() {
 void WaveWindow::screenshot() {
     std::stringstream s;
     s << "frame" << std::setfill('0') << std::setw(4) << frame_counter << ".png";
-    ww->screenshot(s.str());
+
+    Canvas canvas(ww->w(), ww->h());
+    ww->render(canvas);
+    writer.write(canvas, s.str());
 
     frame_counter++;
 }
@@ -31,6 +31,9 @@ private:
 
     WaveWidget* ww{ nullptr };
 
+    // Frames are encoded in the background while the animation goes on
+    ImageWriter writer;
+
     Fl_Choice* surface_choice{ nullptr };
     Fl_Input* g_in{ nullptr }, * h_in{ nullptr }, * delta_in{ nullptr },
         * eps_in{ nullptr }, * dtime_in{ nullptr };
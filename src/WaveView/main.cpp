@@ -1,9 +1,7 @@
-#ifndef STB_IMAGE_WRITE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#endif
-#include <stb_image_write.h>
-
 #include "pch.h"
+#include "Canvas.h"
+#include "ImageWriter.h"
+#include "Headless.h"
 #include "SurfaceFunction.h"
 #include "WaveModel.h"
 #include "WaveWidget.h"
@@ -13,6 +11,27 @@
  * Main entry point
  *****************************************************************************/
 int main (int argc, char* argv[]) {
+    if (argc > 3 && strcmp(argv[1], "--render") == 0) {
+        constexpr int RenderWidth = 640;
+        constexpr int RenderHeight = 480;
+        int frames = atoi(argv[3]);
+        int width = (argc > 5) ? atoi(argv[4]) : RenderWidth;
+        int height = (argc > 5) ? atoi(argv[5]) : RenderHeight;
+
+        // Animation with the default parameters, no display is opened
+        WaveModel model;
+        WaveWidget widget(0, 0, width, height, &model, "Wave Model");
+
+        return RenderFrames(argv[2], width, height, [&](int frame, Canvas& canvas) {
+            if (frame >= frames) {
+                return false;
+            }
+            widget.render(canvas);
+            model.step();
+            return true;
+        });
+    }
+
 #if DRAW_METHOD==DRAW_METHOD_FLTK && !defined(WIN32) && !defined(__APPLE__)
     fl_open_display();
 #endif
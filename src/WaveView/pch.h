@@ -16,13 +16,19 @@
 #include <FL/Fl_Check_Button.H>
 
 #include <array>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <cstdarg>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
-
-#include <stb_image_write.h>